@@ -0,0 +1,235 @@
+#ifndef _ACTIVATION_H
+#define _ACTIVATION_H
+
+//****************************************************************************
+//**
+//**    Activation.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <math.h>
+
+#include "LayerKernels.h"
+
+namespace CarDemo
+{
+	// The squashing function a layer applies to its weighted sums.
+	enum EvalFunction
+	{
+		EVAL_SIGMOID,	// 0 to 1.
+		EVAL_STEP,		// 1 when the sum is positive, otherwise 0.
+		EVAL_BIPOLAR,	// Bipolar sigmoid, -1 to 1.
+		EVAL_RELU,		// max(0, sum).
+		EVAL_TANH,		// -1 to 1, twice as steep as EVAL_BIPOLAR.
+		EVAL_LINEAR,	// The sum is passed straight through.
+
+		EVAL_FUNCTION_COUNT,
+	};
+
+	// How the sigmoid curve is computed. All three agree to well below anything the nets can
+	// tell apart, the difference is purely speed.
+	enum ActivationMode
+	{
+		// 1 / (1 + expf(-a)) through the C library.
+		ACTIVATION_EXACT,
+
+		// expf replaced by a range reduced degree 5 polynomial (2^n * P(r), |r| <= ln2/2).
+		// Max absolute error against the true curve is below 1e-7 over the whole float range,
+		// the same as ACTIVATION_EXACT.
+		ACTIVATION_APPROX,
+
+		// Linear interpolation into a 4096 entry table covering [-16, 16], clamped outside it.
+		// Max absolute error against the true curve is below 1e-6.
+		ACTIVATION_TABLE,
+	};
+
+	// ----------------------------------------------------------------------
+	// Polynomial expf. This is the classic Cephes range reduction:
+	// e^x = 2^n * e^r where n = round(x / ln2) and r = x - n * ln2, with e^r
+	// approximated by a degree 5 polynomial on |r| <= ln2 / 2.
+	// ----------------------------------------------------------------------
+	const float EXP_HIGH = 88.3762626647949f;
+	const float EXP_LOW = -88.3762626647949f;
+	const float LOG2_E = 1.44269504088896341f;
+	const float LN2_HIGH = 0.693359375f;
+	const float LN2_LOW = -2.12194440e-4f;
+	const float EXP_P0 = 1.9875691500E-4f;
+	const float EXP_P1 = 1.3981999507E-3f;
+	const float EXP_P2 = 8.3334519073E-3f;
+	const float EXP_P3 = 4.1665795894E-2f;
+	const float EXP_P4 = 1.6666665459E-1f;
+	const float EXP_P5 = 5.0000001201E-1f;
+
+	inline float ExpApprox(float x)
+	{
+		x = x > EXP_HIGH ? EXP_HIGH : x;
+		x = x < EXP_LOW ? EXP_LOW : x;
+
+		// floor() by truncating and stepping down for negatives, which avoids a libm call.
+		const float t = x * LOG2_E + 0.5f;
+		int k = (int)t;
+		k -= (t < (float)k) ? 1 : 0;
+		const float n = (float)k;
+		x = x - n * LN2_HIGH - n * LN2_LOW;
+
+		float y = EXP_P0;
+		y = y * x + EXP_P1;
+		y = y * x + EXP_P2;
+		y = y * x + EXP_P3;
+		y = y * x + EXP_P4;
+		y = y * x + EXP_P5;
+		y = y * x * x + x + 1.0f;
+
+		// Build 2^n straight into the exponent bits.
+		union { int i; float f; } pow2n;
+		pow2n.i = (k + 127) << 23;
+		return y * pow2n.f;
+	}
+
+	// Single value versions of the sigmoid, returns 0 to 1. SigmoidExact and SigmoidApprox are
+	// inline so that fixed size nets can fold them straight into their loops.
+	inline float SigmoidExact(float a)
+	{
+		return 1.0f / (1.0f + expf(-a));
+	}
+
+	float SigmoidTable(float a);
+
+	inline float SigmoidApprox(float a)
+	{
+		return 1.0f / (1.0f + ExpApprox(-a));
+	}
+
+	// Squashes 'count' pre-activation values in place. The SIMD variants process four (SSE2) or
+	// eight (AVX2) values per instruction and finish the tail with the scalar version.
+	void SigmoidExactBulk(float* values, int count);
+	void SigmoidApproxBulkScalar(float* values, int count);
+	void SigmoidApproxBulkSSE2(float* values, int count);
+	void SigmoidApproxBulkAVX2(float* values, int count);
+	void SigmoidTableBulkScalar(float* values, int count);
+	void SigmoidTableBulkSSE2(float* values, int count);
+	void SigmoidTableBulkAVX2(float* values, int count);
+
+	// Picks the implementation used by ApplySigmoid / ApplyBiPolarSigmoid. Safe to call while
+	// other threads are evaluating nets, they pick the change up on their next layer.
+	void SetActivationMode(ActivationMode mode);
+	ActivationMode GetActivationMode();
+
+	// Squashes a whole layer in place with the selected mode and the best kernel level the CPU
+	// supports. The bipolar version maps to -1 to 1.
+	void ApplySigmoid(float* values, int count);
+	void ApplyBiPolarSigmoid(float* values, int count);
+
+	// Squashes in place with an explicit mode and kernel level, ignoring the selection.
+	void ApplySigmoid(float* values, int count, ActivationMode mode, KernelLevel level);
+
+	// Bulk versions of the remaining layer functions.
+	void ApplyStep(float* values, int count);
+	void ApplyReLU(float* values, int count);
+	void ApplyTanh(float* values, int count);
+
+	// Applies the layer function 'F' to 'count' values in place. The function is picked when the
+	// template is instantiated, so the loop inside carries no per-value branch or indirect call.
+	template <EvalFunction F>
+	inline void ApplyActivation(float* values, int count);
+
+	template <>
+	inline void ApplyActivation<EVAL_SIGMOID>(float* values, int count)
+	{
+		ApplySigmoid(values, count);
+	}
+
+	template <>
+	inline void ApplyActivation<EVAL_STEP>(float* values, int count)
+	{
+		ApplyStep(values, count);
+	}
+
+	template <>
+	inline void ApplyActivation<EVAL_BIPOLAR>(float* values, int count)
+	{
+		ApplyBiPolarSigmoid(values, count);
+	}
+
+	template <>
+	inline void ApplyActivation<EVAL_RELU>(float* values, int count)
+	{
+		ApplyReLU(values, count);
+	}
+
+	template <>
+	inline void ApplyActivation<EVAL_TANH>(float* values, int count)
+	{
+		ApplyTanh(values, count);
+	}
+
+	template <>
+	inline void ApplyActivation<EVAL_LINEAR>(float*, int)
+	{
+	}
+
+	// Picks the instantiation once for the whole buffer.
+	void ApplyActivation(EvalFunction function, float* values, int count);
+
+	// The layer function 'F' of a single value with the sigmoid computed as 'M' says, the same
+	// curves as the bulk versions above. Both are picked at compile time, so fixed size nets can
+	// fold the activation straight into their loops.
+	template <ActivationMode M>
+	inline float Sigmoid(float a)
+	{
+		if constexpr (M == ACTIVATION_EXACT)
+		{
+			return SigmoidExact(a);
+		}
+		else if constexpr (M == ACTIVATION_TABLE)
+		{
+			return SigmoidTable(a);
+		}
+		else
+		{
+			return SigmoidApprox(a);
+		}
+	}
+
+	template <EvalFunction F, ActivationMode M>
+	inline float Activate(float a)
+	{
+		if constexpr (F == EVAL_SIGMOID)
+		{
+			return Sigmoid<M>(a);
+		}
+		else if constexpr (F == EVAL_STEP)
+		{
+			return a > 0.0f ? 1.0f : 0.0f;
+		}
+		else if constexpr (F == EVAL_BIPOLAR)
+		{
+			return 2.0f * Sigmoid<M>(a) - 1.0f;
+		}
+		else if constexpr (F == EVAL_RELU)
+		{
+			return a > 0.0f ? a : 0.0f;
+		}
+		else if constexpr (F == EVAL_TANH)
+		{
+			return 2.0f * Sigmoid<M>(2.0f * a) - 1.0f;
+		}
+		else
+		{
+			return a;
+		}
+	}
+
+	// Names used for the "Function=" field of exported nets. ParseEvalFunction falls back to
+	// EVAL_SIGMOID for anything it doesn't recognise, which is what older exports used.
+	const char* GetEvalFunctionName(EvalFunction function);
+	EvalFunction ParseEvalFunction(const char* name);
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _ACTIVATION_H
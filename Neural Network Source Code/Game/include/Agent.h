@@ -18,12 +18,10 @@
 #include <Clarity/Math/LineSegment2.h>
 #include <Clarity/Math/Circle.h>
 
-// Forward Declarations
-namespace GF1
-{
-	class Sprite;
-};
+#include "AgentPool.h"
+#include "FixedNeuralNet.h"
 
+// Forward Declarations
 namespace CarDemo
 {
 	class NeuralNet;
@@ -32,97 +30,81 @@ namespace CarDemo
 
 namespace CarDemo 
 {
-	enum NeuralNetOuputs
-	{
-		NN_OUTPUT_RIGHT_FORCE,
-		NN_OUTPUT_LEFT_FORCE,
-
-		NN_OUTPUT_COUNT,
-	};
+	// Caps how many frames of sensor inputs an agent will record, about ten minutes at 60Hz.
+	const unsigned int MAX_RECORDED_FRAMES = 36000;
 
-	// The identifiers for the feelers of the agnet
-	enum SensorFeelers
-	{
-		FEELER_EAST,
-		FEELER_NORTH_EAST,
-		FEELER_NORTH,
-		FEELER_NORTH_WEST,
-		FEELER_WEST,
-
-		FEELER_COUNT,
-	};
-
-
-	enum AgentBoundsCorners
-	{
-		CORNER_TOP_LEFT,
-		CORNER_TOP_RIGHT,
-		CORNER_BOTTOM_RIGHT,
-		CORNER_BOTTOM_LEFT,
-
-		CORNER_COUNT,
-	};
-
-
-	struct Sensor
-	{
-		Clarity::Vector2 feelerEnds[FEELER_COUNT];
-		Clarity::Vector2 feelers[FEELER_COUNT];
-	};
+	// The production net, feelers in, one sigmoid hidden layer, sigmoid track forces out.
+	typedef FixedNeuralNet<EVAL_SIGMOID, FEELER_COUNT, HIDDEN_LAYER_NEURONS, NN_OUTPUT_COUNT> CarNeuralNet;
 
+	// A single car for the interactive demo. Its body, sensors and movement live in a one agent
+	// AgentPool, the agent adds the net that drives it.
 	class Agent
 	{
 	private:
-		bool hasFailed;
-		float distanceDelta;
-
-		int collidedCorner;
-		GF1::Sprite* sprite;
-		Sensor sensor;
+		AgentPool pool;
 
 		NeuralNet* neuralNet;
 
-		Clarity::Vector2 position;
-		Clarity::Circle sensorBounds;
-		Clarity::Vector2 corners[CORNER_COUNT];
-
-		float intersectionDepths[FEELER_COUNT];
-
-		float headingAngle; // Degrees.
+		// Used by Update in place of the attached net whenever that is a CarNeuralNet. It is
+		// bound straight to the net's weights when they lie in genome order in one run, as a
+		// genome view's do; otherwise they are copied into 'fixedWeights' once per Attach.
+		CarNeuralNet fixedNet;
+		bool useFixedNet;
+		float fixedWeights[CarNeuralNet::TOTAL_WEIGHTS];
 
-		void BuildBounds();
-		void BuildFeelers();
+		// When set, every Update appends its FEELER_COUNT net inputs here.
+		std::vector<float>* inputRecording;
 
-		void DrawFeelers();
-		void DrawAgentBounds();
+		void SyncFixedNet();
 	protected:
 	public:
 
+		// Agents are pure simulation, AgentRenderer draws them.
 		Agent();
 		~Agent();
 
 		void Initilise(float headingIn);
 
 		void SetPosition(const Clarity::Vector2& p);
-		const Clarity::Vector2& GetPosition() const;
+		Clarity::Vector2 GetPosition() const;
 		void SetRotation(float theta);
+		float GetRotation() const;
 		void CreateNewNet();
 
 		void Update(float t);
-		void Render();
 
 		void GetIntersectionDepths(std::vector<float> &out);
 
-		const Clarity::Circle& GetSensorBounds() const;
+		// For drawing the agent.
+		Sensor GetSensor() const;
+		Clarity::Vector2 GetCorner(int corner) const;
+		float GetIntersectionDepth(int feeler) const;
+		int GetCollidedCorner() const;
+
+		Clarity::Circle GetSensorBounds() const;
 		void GetLocalBounds(std::vector<Clarity::LineSegment2> &out);
 
-		void UpdateSensors(std::vector<Clarity::LineSegment2> polySections);
+		// Measures how far each feeler reaches before it hits one of 'segments', or a wall of
+		// the track 'field' was built from.
+		void UpdateSensors(const SensorSegments& segments);
+		void UpdateSensors(const DistanceField& field);
 
 		// Tests the agent against the polygon walls to see if it has collided with the wall.
-		// Uses a plane equation for each vertice and poly segment to deduce this.
-		bool CheckForCollision(std::vector<Clarity::LineSegment2> polySections);
+		// Every edge of the body is tested against every segment.
+		bool CheckForCollision(const SensorSegments& segments);
+		bool CheckForCollision(const DistanceField& field);
+
+		// True if an edge of the body crosses segment 'index' of 'segments'.
+		bool CrossesSegment(const SensorSegments& segments, int index) const;
 
+		// The agent drives 'net' through a CarNeuralNet when its shape and functions match,
+		// reading a genome view's weights in place. Call Attach again after rebinding the net or
+		// changing its weights.
 		void Attach(NeuralNet* net);
+
+		// Records the sensor inputs fed to the net each update into 'recording', up to
+		// MAX_RECORDED_FRAMES frames. Pass NULL to stop recording.
+		void RecordInputs(std::vector<float>* recording);
 		NeuralNet* GetNeuralNet();
 
 		void ClearFailure();
@@ -0,0 +1,198 @@
+#ifndef _AGENT_POOL_H
+#define _AGENT_POOL_H
+
+//****************************************************************************
+//**
+//**    AgentPool.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <vector>
+
+#include <Clarity/Math/Vector2.h>
+#include <Clarity/Math/Circle.h>
+
+#include "SensorKernels.h"
+
+// Forward Declarations
+namespace CarDemo
+{
+	class BatchedNeuralNet;
+	class DistanceField;
+	class TrackGeometry;
+};
+
+namespace CarDemo
+{
+	enum NeuralNetOuputs
+	{
+		NN_OUTPUT_RIGHT_FORCE,
+		NN_OUTPUT_LEFT_FORCE,
+
+		NN_OUTPUT_COUNT,
+	};
+
+	// The identifiers for the feelers of the agnet
+	enum SensorFeelers
+	{
+		FEELER_EAST,
+		FEELER_NORTH_EAST,
+		FEELER_NORTH,
+		FEELER_NORTH_WEST,
+		FEELER_WEST,
+
+		FEELER_COUNT,
+	};
+
+
+	enum AgentBoundsCorners
+	{
+		CORNER_TOP_LEFT,
+		CORNER_TOP_RIGHT,
+		CORNER_BOTTOM_RIGHT,
+		CORNER_BOTTOM_LEFT,
+
+		CORNER_COUNT,
+	};
+
+
+	// Size of the car's body, matching Resources/Car.png.
+	const float AGENT_WIDTH = 21.0f;
+	const float AGENT_HEIGHT = 47.0f;
+
+	struct Sensor
+	{
+		Clarity::Vector2 feelerEnds[FEELER_COUNT];
+		Clarity::Vector2 feelers[FEELER_COUNT];
+	};
+
+	// The state of many cars at once, one array per quantity rather than one object per car.
+	// Per feeler and per corner values are stored a whole row of agents at a time, so feeler 'f'
+	// of agent 'a' is at [f * count + a]. The passes over every agent are straight, branch free
+	// loops over those arrays that the compiler can vectorize; crashed agents are masked out
+	// rather than skipped. Agent is a one car view of a pool for the interactive demo.
+	class AgentPool
+	{
+	private:
+		int count;
+
+		std::vector<float> positionX;
+		std::vector<float> positionY;
+		std::vector<float> heading; // Degrees.
+
+		// Sine and cosine of the heading, kept in step with it so the other passes never need
+		// to call the trig functions.
+		std::vector<float> headingSin;
+		std::vector<float> headingCos;
+
+		std::vector<float> feelerX;
+		std::vector<float> feelerY;
+		std::vector<float> feelerEndX;
+		std::vector<float> feelerEndY;
+		std::vector<float> depths;
+
+		std::vector<float> cornerX;
+		std::vector<float> cornerY;
+
+		std::vector<float> distanceDelta;
+		std::vector<float> fitness;
+		std::vector<unsigned char> failed;
+
+		// One flag per agent per checkpoint, agent after agent.
+		int checkpointCount;
+		std::vector<unsigned char> checkpointsHit;
+
+		// Scratch space for the per agent passes and Step.
+		std::vector<int> candidates;
+		SensorSegments nearbySegments;
+		std::vector<int> running;
+		std::vector<float> inputs;
+		std::vector<float> batchOutputs;
+		std::vector<float> outputs;
+
+		void RefreshHeading(int agent);
+		void BuildFeelers(int first, int end);
+		void BuildBounds(int first, int end);
+
+		// Update for agents 'first' to 'end'.
+		void Drive(const float* outputsIn, float t, int first, int end);
+
+		AgentPool(const AgentPool&);
+		AgentPool& operator=(const AgentPool&);
+
+	protected:
+	public:
+		explicit AgentPool(int countIn = 0);
+
+		// Changes the number of agents. Every agent is reset to the origin.
+		void Resize(int countIn);
+		int GetCount() const;
+
+		// Puts an agent back at the start: no fitness, no checkpoints hit, not crashed.
+		void Reset(int agent, const Clarity::Vector2& position, float rotation);
+		void ResetAll(const Clarity::Vector2& position, float rotation);
+
+		// Rebuilds the feeler rays and body corners of every agent from the position and heading.
+		void BuildFeelers();
+		void BuildBounds();
+
+		// Measures how far each feeler of every agent still driving reaches into the track walls.
+		// The track versions always test the segments exactly, whether or not it has a field.
+		void UpdateSensors(const TrackGeometry& track);
+		void UpdateSensors(int agent, const SensorSegments& segments);
+		void UpdateSensors(const DistanceField& field);
+		void UpdateSensors(int agent, const DistanceField& field);
+
+		// Flags every agent whose body now crosses a wall as failed. Returns how many crashed.
+		// Through a distance field the corners and the middle of each side are looked up, so a
+		// wall poking into the body between them can go unnoticed.
+		int CheckForCollision(const TrackGeometry& track);
+		bool CheckForCollision(int agent, const SensorSegments& segments);
+		int CheckForCollision(const DistanceField& field);
+		bool CheckForCollision(int agent, const DistanceField& field);
+
+		// True if an edge of the agent's body crosses segment 'index'.
+		bool CrossesSegment(int agent, const SensorSegments& segments, int index) const;
+
+		// Writes the net inputs of every agent, FEELER_COUNT per agent, agent after agent: how
+		// far into the feeler range the nearest wall is, 0 for nothing and 1 for touching.
+		void GetInputs(float* out) const;
+
+		// Steers and drives every agent still running by 't' seconds from its NN_OUTPUT_COUNT
+		// outputs, laid out like GetInputs. Half the distance driven is added to the fitness.
+		void Update(const float* outputsIn, float t);
+
+		// Awards CHECK_POINT_BONUS the first time an agent's body crosses each checkpoint.
+		void ScoreCheckpoints(const SensorSegments& checkpoints);
+
+		// One whole simulation step for every agent: sense, crash, think with 'net' (agent 'i'
+		// driven by batch entry 'i') and drive. Returns how many agents are still running.
+		// Crashed agents are left out of the net altogether. Uses the track's distance field if
+		// it has one.
+		int Step(const TrackGeometry& track, const SensorSegments& checkpoints, BatchedNeuralNet& net, float t);
+
+		void SetPosition(int agent, const Clarity::Vector2& position);
+		Clarity::Vector2 GetPosition(int agent) const;
+		void SetRotation(int agent, float rotation);
+		float GetRotation(int agent) const;
+
+		Clarity::Vector2 GetFeeler(int agent, int feeler) const;
+		Clarity::Vector2 GetFeelerEnd(int agent, int feeler) const;
+		float GetIntersectionDepth(int agent, int feeler) const;
+		Clarity::Vector2 GetCorner(int agent, int corner) const;
+		Clarity::Circle GetSensorBounds(int agent) const;
+
+		bool HasFailed(int agent) const;
+		void ClearFailure(int agent);
+		float GetDistanceDelta(int agent) const;
+		float GetFitness(int agent) const;
+	};
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _AGENT_POOL_H
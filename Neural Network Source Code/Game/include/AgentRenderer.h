@@ -0,0 +1,51 @@
+#ifndef _AGENT_RENDERER_H
+#define _AGENT_RENDERER_H
+
+//****************************************************************************
+//**
+//**    AgentRenderer.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+// Forward Declarations
+namespace GF1
+{
+	class Sprite;
+};
+
+namespace CarDemo
+{
+	class Agent;
+};
+
+namespace CarDemo
+{
+	// Draws an Agent with GF1: the car sprite, its feelers, bounds and sensor hits.
+	// Agents themselves know nothing about rendering so they can be simulated headless.
+	class AgentRenderer
+	{
+	private:
+		GF1::Sprite* sprite;
+
+		void DrawFeelers(const Agent& agent);
+		void DrawAgentBounds(const Agent& agent);
+
+		AgentRenderer(const AgentRenderer&);
+		AgentRenderer& operator=(const AgentRenderer&);
+
+	protected:
+	public:
+		AgentRenderer();
+		~AgentRenderer();
+
+		void Render(const Agent& agent);
+	};
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _AGENT_RENDERER_H
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef _ALIGNED_MEMORY_H
+#define _ALIGNED_MEMORY_H
+
+//****************************************************************************
+//**
+//**    AlignedMemory.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <stdlib.h>
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+namespace CarDemo
+{
+	// Alignment used for any float buffer that the SIMD kernels will touch.
+	// 64 bytes keeps every block on its own cache line.
+	const size_t CACHE_LINE_ALIGNMENT = 64;
+
+	// Allocates 'size' bytes aligned to 'alignment' (which must be a power of two).
+	// Memory returned from here MUST be released with AlignedFree.
+	inline void* AlignedMalloc(size_t size, size_t alignment)
+	{
+		if (size == 0)
+			return NULL;
+
+#if defined(_MSC_VER)
+		return _aligned_malloc(size, alignment);
+#else
+		void* memory = NULL;
+		if (posix_memalign(&memory, alignment, size) != 0)
+		{
+			return NULL;
+		}
+		return memory;
+#endif
+	}
+
+	inline void AlignedFree(void* memory)
+	{
+		if (memory == NULL)
+			return;
+
+#if defined(_MSC_VER)
+		_aligned_free(memory);
+#else
+		free(memory);
+#endif
+	}
+
+	inline float* AllocateFloats(size_t count)
+	{
+		return (float*)AlignedMalloc(count * sizeof(float), CACHE_LINE_ALIGNMENT);
+	}
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _ALIGNED_MEMORY_H
@@ -0,0 +1,112 @@
+#ifndef _BATCHED_NEURAL_NET_H
+#define _BATCHED_NEURAL_NET_H
+
+//****************************************************************************
+//**
+//**    BatchedNeuralNet.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <vector>
+
+#include "NetworkLayout.h"
+
+// Forward Declarations
+namespace CarDemo
+{
+	class NeuralNet;
+	class GeneticAlgorithm;
+};
+
+namespace CarDemo
+{
+
+	// Runs the forward pass for a whole population of agents in one call.
+	// Every agent shares the same topology. The weights can either be shared by every agent (one
+	// NeuralNet, evaluated as a matrix-matrix product) or come from one genome per agent, laid out
+	// exactly like NeuralNet::ToGenome and strided through one weight tensor.
+	// In per genome mode only neighbouring agents on the same genome have a matrix in common, so
+	// each such run is batched as a matrix-matrix product and every other agent is a
+	// matrix-vector product per layer. A population of distinct genomes gets no batching gain,
+	// only the one call.
+	class BatchedNeuralNet
+	{
+	private:
+		NetworkLayout layout;
+
+		// Shared mode, one weight matrix per layer.
+		std::vector<const float*> sharedWeights;
+
+		// Per genome mode, the start of each agents genome.
+		std::vector<const float*> genomes;
+		bool perGenome;
+
+		// Ping-pong activation buffers, 'capacity' agents wide, and the feature-major copies of
+		// a run of agents sharing a genome.
+		int capacity;
+		float* buffers[2];
+		float* runBuffers[2];
+
+		void ReleaseBuffers();
+
+		void UpdateShared(const float* inputs, int count, float* outputs);
+		void UpdatePerGenome(const float* inputs, const int* agents, int count, float* outputs);
+
+		// One layer for rows first .. first + runLength of the agent-major 'source' and 'dest',
+		// agents that all share 'weights'.
+		void BatchRun(DenseBatchKernel kernel, const float* weights, const LayerLayout& shape,
+					  const float* source, int first, int runLength, float* dest);
+
+		BatchedNeuralNet(const BatchedNeuralNet&);
+		BatchedNeuralNet& operator=(const BatchedNeuralNet&);
+
+	protected:
+	public:
+		BatchedNeuralNet();
+		~BatchedNeuralNet();
+
+		// Every agent in the batch is evaluated with the weights of 'net'.
+		// The net is referenced, not copied, so it must outlive the batch.
+		void SetSharedNet(const NeuralNet& net);
+
+		// Describes the topology of the genomes that will be handed to SetGenomeWeights.
+		void SetTopology(int numOfHiddenLayers, int numOfInputs, int neuronsPerHidden, int numOfOutputs,
+						 EvalFunction hiddenFunction = EVAL_SIGMOID, EvalFunction outputFunction = EVAL_SIGMOID);
+		void SetLayout(const NetworkLayout& layoutIn);
+
+		// Agent 'i' is evaluated with the genome starting at weights + i * genomeStride. A stride
+		// of 0 evaluates every agent with the one genome.
+		void SetGenomeWeights(const float* weights, int genomeStride, int count);
+
+		// Agent 'i' is evaluated with genome 'i' of the population, straight out of the GA's
+		// arena. Good until the population is next bred.
+		void SetGenomeWeights(const GeneticAlgorithm& genAlg);
+
+		// Grows the activation buffers up front so that UpdateBatch never has to.
+		void Reserve(int maxBatch);
+
+		// 'inputs' holds GetTotalInputs() floats per agent, agent after agent.
+		// 'outputs' receives GetTotalOutputs() floats per agent in the same order.
+		void UpdateBatch(const float* inputs, int count, float* outputs);
+
+		// As above for a subset of the agents: row 'i' of 'inputs' and 'outputs' belongs to agent
+		// agents[i], so only the agents still driving need to be evaluated.
+		void UpdateBatch(const float* inputs, const int* agents, int count, float* outputs);
+
+		int GetTotalInputs() const;
+		int GetTotalOutputs() const;
+
+		// Number of weights in one genome for the current topology.
+		int GetTotalWeights() const;
+
+		const NetworkLayout& GetLayout() const;
+	};
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _BATCHED_NEURAL_NET_H
@@ -0,0 +1,31 @@
+#ifndef _BENCHMARKS_H
+#define _BENCHMARKS_H
+
+//****************************************************************************
+//**
+//**    Benchmarks.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <iostream>
+
+namespace CarDemo
+{
+	// Times every activation mode at every kernel level the CPU supports and prints the
+	// nanoseconds per value along with the max error against the double precision sigmoid.
+	void RunActivationBenchmark(std::ostream& out);
+
+	// Loads an exported net, quantizes it to int8 and fp16 using the recorded sensor inputs for
+	// calibration, then feeds the recorded inputs to every version (open loop, no simulation)
+	// and prints how far they drift from float along with their memory use and speed. Falls
+	// back to random sensor readings if the recording can't be loaded.
+	void RunQuantizationReport(std::ostream& out, const char* netFilename, const char* recordingFilename);
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _BENCHMARKS_H
\ No newline at end of file
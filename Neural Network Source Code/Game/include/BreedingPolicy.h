@@ -0,0 +1,109 @@
+#ifndef _BREEDING_POLICY_H
+#define _BREEDING_POLICY_H
+
+//****************************************************************************
+//**
+//**    BreedingPolicy.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+namespace CarDemo
+{
+	// How the parents of the bred children are picked, see Selection.h.
+	enum SelectionOperator
+	{
+		SELECTION_TRUNCATION,				// Every pairing of the 'selectionSize' fittest in turn.
+		SELECTION_TOURNAMENT,				// Tournaments of 'selectionSize'.
+		SELECTION_RANKED,					// Linear ranking with 'rankPressure'.
+		SELECTION_STOCHASTIC_UNIVERSAL,		// Fitness proportionate.
+
+		SELECTION_COUNT,
+	};
+
+	// The most cuts CROSSOVER_MULTI_POINT makes, whatever 'crossoverPoints' asks for.
+	const int MAX_CROSSOVER_POINTS = 32;
+
+	// How two parents' weights are shared between their two children. All but single point only
+	// cut between the blocks of GeneticAlgorithm::GenerateCrossoverSplits, so a neuron always
+	// keeps its weights and bias together, and whole blocks are copied at a time.
+	enum CrossoverOperator
+	{
+		CROSSOVER_SINGLE_POINT,				// One cut anywhere in the weights.
+		CROSSOVER_NEURON_POINT,				// One cut between neurons.
+		CROSSOVER_MULTI_POINT,				// 'crossoverPoints' cuts between neurons, the parents alternating.
+		CROSSOVER_UNIFORM,					// Each neuron from either parent, a coin toss apiece.
+		CROSSOVER_NONE,						// The children are copies of their parents.
+
+		CROSSOVER_COUNT,
+	};
+
+	// How a child's weights are disturbed once bred, in one pass over all the children by the
+	// kernels of MutationKernels.h.
+	//
+	// Uniform keeps the demo's original odds: a weight moves when a RandomClamped() draw falls
+	// below 'mutationRate'. That draw runs from -1 to 1 and is peaked at 0, so a weight moves
+	// with probability 1 - (1 - rate)^2 / 2 for rates from 0 to 1, about 64% at the default
+	// 0.15, and (1 + rate)^2 / 2 for rates below 0. Gaussian and self-adaptive use the rate as
+	// the plain probability.
+	enum MutationOperator
+	{
+		MUTATION_UNIFORM,					// Weights move by up to +-'maxPerturbation', with the odds above.
+		MUTATION_NONE,
+		MUTATION_GAUSSIAN,					// 'mutationRate' of the weights move by N(0, 'mutationSigma').
+		MUTATION_SELF_ADAPTIVE,				// As gaussian, but each genome carries and evolves its own sigma.
+
+		MUTATION_COUNT,
+	};
+
+	// Everything BreedPopulation does to turn one generation into the next, set at run time.
+	// The next generation is made of, in order:
+	//   the 'eliteCount' fittest genomes, carried over (and mutated if 'mutateElites'),
+	//   children bred from selected parents, crossed over and mutated,
+	//   'immigrantFraction' of the population as fresh random genomes.
+	// The defaults are the demo's original scheme: the best genome carried and mutated, the top
+	// four paired off five times, the rest (four of fifteen) immigrants. Only the crossover has
+	// changed, cutting between neurons rather than through them.
+	struct BreedingPolicy
+	{
+		int eliteCount;
+		bool mutateElites;
+		float immigrantFraction;
+
+		SelectionOperator selection;
+		int selectionSize;
+		float rankPressure;
+
+		CrossoverOperator crossover;
+		int crossoverPoints;
+
+		MutationOperator mutation;
+		float mutationRate;
+		float maxPerturbation;
+
+		// The gaussian's deviation, and where a self-adaptive genome's sigma starts. Each time a
+		// self-adaptive genome is mutated its sigma is first multiplied by exp(tau * N(0, 1)),
+		// tau = 1 / sqrt(weights), and kept above 'minimumSigma' so it can't die away.
+		float mutationSigma;
+		float minimumSigma;
+
+		BreedingPolicy();
+	};
+
+	// Names for the operators, as taken by the headless trainer: "truncation", "tournament",
+	// "ranked", "sus"; "single-point", "neuron", "multi-point", "uniform", "none"; "uniform",
+	// "none", "gaussian", "self-adaptive". Parsing returns false and leaves 'out' alone for a name it doesn't know.
+	const char* GetSelectionName(SelectionOperator selection);
+	const char* GetCrossoverName(CrossoverOperator crossover);
+	const char* GetMutationName(MutationOperator mutation);
+	bool ParseSelection(const char* name, SelectionOperator& out);
+	bool ParseCrossover(const char* name, CrossoverOperator& out);
+	bool ParseMutation(const char* name, MutationOperator& out);
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _BREEDING_POLICY_H
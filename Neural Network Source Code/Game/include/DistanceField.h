@@ -0,0 +1,133 @@
+#ifndef _DISTANCE_FIELD_H
+#define _DISTANCE_FIELD_H
+
+//****************************************************************************
+//**
+//**    DistanceField.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <vector>
+
+// Forward Declarations
+namespace CarDemo
+{
+	class TrackGeometry;
+};
+
+namespace CarDemo
+{
+	// ----------------------------------------------------------------------
+	// Binary distance field cache, little endian throughout:
+	//   DistanceFieldHeader                64 bytes
+	//   float * columns * rows             the samples, row after row
+	// 'polygonHash' is the FNV-1a hash of the polygon file the field was
+	// built from, so editing the track invalidates the cache. The checksum
+	// is FNV-1a over every byte after the header.
+	// ----------------------------------------------------------------------
+	const unsigned int DISTANCE_FIELD_MAGIC = 0x46534443; // "CDSF"
+	const unsigned int DISTANCE_FIELD_VERSION = 1;
+
+	// Where LoadOrBuild keeps its cache files.
+	const char* const DISTANCE_FIELD_CACHE_DIRECTORY = "ExportedNNs";
+
+	const float DEFAULT_DISTANCE_FIELD_CELL_SIZE = 2.0f;
+
+	struct DistanceFieldHeader
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int fileSize;
+		unsigned int checksum;
+		unsigned int polygonHash;
+		unsigned int columns;
+		unsigned int rows;
+		float originX;
+		float originY;
+		float cellSize;
+		float range;
+		unsigned int reserved[5];
+	};
+
+	// How far the distance field strays from the exact ray casts, see ValidateDistanceField.
+	struct DistanceFieldReport
+	{
+		int rays;
+		float meanDepthError;
+		float maxDepthError;
+		int raysWithinCell;			// Rays whose depth is within one cell of the exact one.
+
+		int bodies;
+		int missedCollisions;		// Exact test crashes, the field doesn't.
+		int falseCollisions;		// The field crashes, the exact test doesn't.
+	};
+
+	// Signed distance to the nearest wall, sampled on a regular grid over the track. Positive on
+	// the road between the inner and outer walls, negative off it, and clamped to 'range' either
+	// way. Built once for a static track, it turns a feeler into a few lookups marching along the
+	// ray (sphere tracing) and a collision into a lookup per point of the car's body, with no
+	// segments involved at all. Values between samples are interpolated, so answers are only as
+	// good as the cell size; ValidateDistanceField measures how good.
+	class DistanceField
+	{
+	private:
+		float originX;
+		float originY;
+		float cellSize;
+		float inverseCellSize;
+		float range;
+		int columns;
+		int rows;
+		std::vector<float> samples;
+
+	protected:
+	public:
+		DistanceField();
+
+		// Samples 'track' every 'cellSizeIn' units, out to 'rangeIn' past its walls. The road is
+		// told apart from the rest by counting wall crossings, so both walls must be closed loops.
+		void Build(const TrackGeometry& track, float cellSizeIn, float rangeIn);
+
+		// The cache file. Load fails if the file is missing, damaged or was built from another
+		// polygon file, cell size or range.
+		bool Save(const char* filename, unsigned int polygonHash) const;
+		bool Load(const char* filename, unsigned int polygonHash, float cellSizeIn, float rangeIn);
+
+		// Loads the field for 'polygonFile' from the cache, or builds it and caches it. Returns
+		// false if the polygon file couldn't be read.
+		bool LoadOrBuild(const TrackGeometry& track, const char* polygonFile, float cellSizeIn, float rangeIn);
+
+		void Clear();
+		bool IsEmpty() const;
+
+		// Interpolated signed distance at (x, y). Anywhere outside the grid is well off the road.
+		float Sample(float x, float y) const;
+
+		// Marches from (px, py) along the unit direction (dx, dy) until it reaches a wall and
+		// returns the distance, or 'maxDistance' if there's no wall that close.
+		float Trace(float px, float py, float dx, float dy, float maxDistance) const;
+
+		// True if any of the 'points' points (x[i], y[i]) is off the road.
+		bool Overlaps(const float* x, const float* y, int points) const;
+
+		float GetCellSize() const;
+		float GetRange() const;
+		int GetColumns() const;
+		int GetRows() const;
+	};
+
+	// FNV-1a over the whole of 'filename'. Returns false if it couldn't be read.
+	bool HashFile(const char* filename, unsigned int& out);
+
+	// Drives the field against the exact segment tests: a car is put down every few cells along
+	// the road, facing several ways, and its feeler depths and collision are worked out both ways.
+	void ValidateDistanceField(const TrackGeometry& track, const DistanceField& field, DistanceFieldReport& out);
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _DISTANCE_FIELD_H
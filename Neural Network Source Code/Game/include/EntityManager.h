@@ -17,11 +17,17 @@
 #include <Clarity/Math/Vector2.h>
 #include <Clarity/Math/Circle.h>
 
+#include "NetworkLayout.h"
+#include "Simulation.h"
+
 namespace CarDemo
 {
 	class Agent;
+	class AgentRenderer;
 	class GeneticAlgorithm;
 	class NeuralNet;
+	class PopulationEvaluator;
+	class TrackGeometry;
 };
 
 namespace GF1
@@ -37,28 +43,28 @@ namespace CarDemo
 		GENETIC_ALGORITHM,
 	};
 
-	enum CheckpointFlag
-	{
-		Checkpoint_Active,
-		Checkpoint_Inactive,
-	};
-
-	const float CHECK_POINT_BONUS = 15.0f;
-	const float DEFAULT_ROTATION = 90.0f;
-	const Clarity::Vector2 DEFAULT_POSITION(0.0f, -175.0f);
+	// The game's population, and the headless trainer's unless it's given -population.
 	const unsigned int MAX_GENOME_POPULATION = 15;
 
-	//const unsigned int HIDDEN_LAYER_NEURONS = 7;
+	// Written at the end of every generation, resumed from on start up.
+	const char* const POPULATION_CHECKPOINT = "ExportedNNs/Population.ckpt";
 
-	typedef Clarity::LineSegment2 Checkpoint;
+	//const unsigned int HIDDEN_LAYER_NEURONS = 7;
 
-	// This is used to hold 
+	// Runs the genetic algorithm in the game: steps the test agent's Simulation in fixed steps
+	// whatever the frame rate, and draws it with GF1.
 	class EntityManager
 	{
 	private: 
-		Agent* testAgent;
+		// The current test subject's episode. The agent lives in here.
+		Simulation* simulation;
+		AgentRenderer* agentRenderer;
+		const TrackGeometry* track;
+
+		// Frame time not yet simulated, always less than one SIMULATION_TIME_STEP.
+		float stepAccumulator;
+
 		std::vector<Agent*> agents;
-		float currentAgentFitness;
 		float bestFitness;
 		float currentTimer;
 		int checkPointsHit;
@@ -68,25 +74,44 @@ namespace CarDemo
 
 		NeuralNet* neuralNet;
 
+		// How every genome in the population maps onto the test agents net.
+		NetworkLayout layout;
+
+		// Every sensor input the test agents have fed their nets, for calibrating quantized nets.
+		std::vector<float> sensorRecording;
+
 		// The checkpoints for the polygon track we are testing the agent against.
 		std::vector<Checkpoint> checkpoints;
-		std::vector<CheckpointFlag> checkpointFlags;
 
 		GeneticAlgorithm* genAlg;
+
+		// Created on first use of EvaluateGeneration.
+		PopulationEvaluator* evaluator;
 		//char* GetRandomName();
 
+		void FinishEpisode();
+
 	protected:
 	public:
 
-		EntityManager();
+		// 'trackIn' is shared with the simulation and must outlive the EntityManager.
+		explicit EntityManager(const TrackGeometry& trackIn);
 		~EntityManager();
 
 		void LoadCheckPoints(char* filename);
 		void LoadExternalNetwork(char* filename);
 
+		// Carries on an earlier run from a GeneticAlgorithm checkpoint. Returns false, leaving
+		// the fresh population in place, if there is no usable checkpoint.
+		bool ResumePopulation(const char* filename);
+
 		void NextTestSubject();
 		void BreedNewPopulation();
 		void EvolveGenomes();
+
+		// Scores the whole population on every core at once, without drawing anything, then
+		// breeds the next generation.
+		void EvaluateGeneration();
 		int GetCurrentMemberOfPopulation() const;
 
 		void ExportAllNeuralNetworks();
@@ -95,11 +120,11 @@ namespace CarDemo
 		void Render();
 		void RenderStatistics();
 
-		const Clarity::Circle& GetAgentSensorBounds();
-		void TestAgentToPolySections(std::vector<Clarity::LineSegment2> polySections);
+		Clarity::Circle GetAgentSensorBounds();
 
 		void Restart();
 
+		// Runs as many fixed simulation steps as fit in 't' seconds, carrying the rest over.
 		void Update(float t);
 
 		 void ForceToNextAgent();
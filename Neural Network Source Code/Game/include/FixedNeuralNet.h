@@ -0,0 +1,164 @@
+#ifndef _FIXED_NEURAL_NET_H
+#define _FIXED_NEURAL_NET_H
+
+//****************************************************************************
+//**
+//**    FixedNeuralNet.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <vector>
+
+#include <assert.h>
+
+#include "Activation.h"
+#include "NLayer.h"
+#include "Genome.h"
+
+namespace CarDemo
+{
+
+	// One fully connected layer with its size baked in. Rows are (Inputs + bias) wide,
+	// exactly like an NLayer's weight matrix. The layer holds no weights of its own, it is
+	// handed the TOTAL_WEIGHTS floats to evaluate with.
+	template <int Inputs, int Neurons>
+	class FixedLayer
+	{
+	public:
+		static const int STRIDE = Inputs + 1;
+		static const int TOTAL_WEIGHTS = Neurons * STRIDE;
+
+		template <EvalFunction F, ActivationMode M>
+		static inline void Evaluate(const float* weights, const float* input, float* output)
+		{
+			for (int n = 0; n < Neurons; n++)
+			{
+				const float* row = weights + n * STRIDE;
+
+				float sum = row[Inputs] * BIAS;
+				for (int i = 0; i < Inputs; i++)
+				{
+					sum += row[i] * input[i];
+				}
+				output[n] = Activate<F, M>(sum);
+			}
+		}
+	};
+
+	// A chain of FixedLayers. The first layer reads 'Inputs' values, every entry in 'Sizes' is
+	// the neuron count of the next layer, the last one being the output layer.
+	template <int Inputs, int... Sizes>
+	class FixedLayerChain;
+
+	template <int Inputs, int Neurons>
+	class FixedLayerChain<Inputs, Neurons>
+	{
+	public:
+		static const int TOTAL_OUTPUTS = Neurons;
+		static const int TOTAL_WEIGHTS = FixedLayer<Inputs, Neurons>::TOTAL_WEIGHTS;
+
+		template <EvalFunction F, ActivationMode M>
+		static inline void Evaluate(const float* weights, const float* input, float* output)
+		{
+			FixedLayer<Inputs, Neurons>::template Evaluate<F, M>(weights, input, output);
+		}
+	};
+
+	template <int Inputs, int Neurons, int Next, int... Rest>
+	class FixedLayerChain<Inputs, Neurons, Next, Rest...>
+	{
+	public:
+		typedef FixedLayer<Inputs, Neurons> Layer;
+		typedef FixedLayerChain<Neurons, Next, Rest...> Tail;
+
+		static const int TOTAL_OUTPUTS = Tail::TOTAL_OUTPUTS;
+		static const int TOTAL_WEIGHTS = Layer::TOTAL_WEIGHTS + Tail::TOTAL_WEIGHTS;
+
+		template <EvalFunction F, ActivationMode M>
+		static inline void Evaluate(const float* weights, const float* input, float* output)
+		{
+			// The layer's activations live on the stack, they're only ever a few floats.
+			float activations[Neurons];
+			Layer::template Evaluate<F, M>(weights, input, activations);
+			Tail::template Evaluate<F, M>(weights + Layer::TOTAL_WEIGHTS, activations, output);
+		}
+	};
+
+	// A neural net whose topology and layer function 'F' are fixed at compile time, for example
+	// FixedNeuralNet<EVAL_SIGMOID, 5, 8, 2> is 5 inputs, one hidden layer of 8 and 2 outputs,
+	// all sigmoid. Every loop has a constant trip count and the activation is inlined, so once
+	// Update has read the ActivationMode (one switch per call) it runs as straight line code
+	// with no heap, no virtual calls and no per-value dispatch.
+	// The net doesn't own its weights, it is bound to TOTAL_WEIGHTS floats in the same order as
+	// NeuralNet::ToGenome, hidden layers first then the output layer, one row of
+	// (inputs + bias) per neuron. Binding copies nothing, so the weights must outlive the
+	// binding. Use NeuralNet for anything that has to change shape at runtime.
+	template <EvalFunction F, int In, int... Layers>
+	class FixedNeuralNet
+	{
+	private:
+		typedef FixedLayerChain<In, Layers...> Chain;
+
+		const float* weights;
+
+	protected:
+	public:
+		static const int TOTAL_INPUTS = In;
+		static const int TOTAL_OUTPUTS = Chain::TOTAL_OUTPUTS;
+		static const int TOTAL_WEIGHTS = Chain::TOTAL_WEIGHTS;
+		static const EvalFunction FUNCTION = F;
+
+		FixedNeuralNet()
+			: weights(NULL)
+		{
+		}
+
+		// 'input' holds TOTAL_INPUTS floats, 'output' receives TOTAL_OUTPUTS floats.
+		inline void Update(const float* input, float* output) const
+		{
+			assert(weights != NULL);
+			switch (GetActivationMode())
+			{
+			case ACTIVATION_EXACT:
+				Chain::template Evaluate<F, ACTIVATION_EXACT>(weights, input, output);
+				break;
+			case ACTIVATION_TABLE:
+				Chain::template Evaluate<F, ACTIVATION_TABLE>(weights, input, output);
+				break;
+			default:
+				Chain::template Evaluate<F, ACTIVATION_APPROX>(weights, input, output);
+				break;
+			}
+		}
+
+		// Points the net at TOTAL_WEIGHTS floats in genome order.
+		void Bind(const float* weightsIn)
+		{
+			weights = weightsIn;
+		}
+
+		void BindGenome(const Genome& genome)
+		{
+			assert(genome.totalWeights >= TOTAL_WEIGHTS);
+			Bind(genome.weights);
+		}
+
+		const float* GetWeights() const
+		{
+			return weights;
+		}
+
+		void ToGenome(std::vector<float>& out) const
+		{
+			out.assign(weights, weights + TOTAL_WEIGHTS);
+		}
+	};
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _FIXED_NEURAL_NET_H
@@ -0,0 +1,94 @@
+#ifndef _GA_CHECKPOINT_H
+#define _GA_CHECKPOINT_H
+
+//****************************************************************************
+//**
+//**    GACheckpoint.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <vector>
+#include <string>
+#include <thread>
+
+namespace CarDemo
+{
+	// ----------------------------------------------------------------------
+	// Binary snapshot of a whole GeneticAlgorithm, little endian throughout:
+	//   GACheckpointHeader                         64 bytes
+	//   GACheckpointGenome * totalPopulation       ID and fitness of each genome
+	//   float * totalPopulation * totalWeights     every genome's weights, in order
+	//   float * totalPopulation                    every genome's mutation sigma
+	// Floats are stored as raw bits so a resumed run carries on bit for bit.
+	// The checksum is FNV-1a over every byte after the header.
+	// ----------------------------------------------------------------------
+	const unsigned int GA_CHECKPOINT_MAGIC = 0x41474443; // "CDGA"
+	const unsigned int GA_CHECKPOINT_VERSION = 3;
+
+	// Version 2 had no sigmas; a genome loaded from one starts at the policy's mutationSigma.
+	const unsigned int GA_CHECKPOINT_VERSION_NO_SIGMAS = 2;
+
+	// Version 1 held a 64 bit xorshift state in the first two words of 'randomState'.
+	const unsigned int GA_CHECKPOINT_VERSION_XORSHIFT = 1;
+
+	struct GACheckpointHeader
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int fileSize;
+		unsigned int checksum;
+		int generation;
+		int genomeID;
+		int currentGenome;
+		unsigned int totalPopulation;
+		unsigned int totalWeights;
+		unsigned int randomState[4];	// RandomStream::GetState.
+		unsigned int reserved[3];
+	};
+
+	struct GACheckpointGenome
+	{
+		int ID;
+		float fitness;
+	};
+
+	// Writes snapshots to disk on a background thread so the simulation never waits on the
+	// disk. Each file is written under a temporary name and then renamed over the old one
+	// (MoveFileEx on Windows, which replaces it in one step too), so being killed mid write
+	// leaves the previous snapshot intact. A missing directory is created.
+	class CheckpointWriter
+	{
+	private:
+		std::thread thread;
+		std::vector<unsigned char> data;
+		std::string filename;
+		bool succeeded;
+
+		void WriteFile();
+
+		CheckpointWriter(const CheckpointWriter&);
+		CheckpointWriter& operator=(const CheckpointWriter&);
+
+	protected:
+	public:
+		CheckpointWriter();
+		~CheckpointWriter();
+
+		// Takes the contents of 'snapshot' (leaving it empty) and starts writing them to
+		// 'filenameIn'. Waits for the previous write first, if one is still going, and
+		// returns false if that one failed, so a failure shows up a snapshot later rather
+		// than at the end of the run.
+		bool Write(const char* filenameIn, std::vector<unsigned char>& snapshot);
+
+		// Blocks until the current write is done. Returns false if it failed.
+		bool Wait();
+	};
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _GA_CHECKPOINT_H
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef _GF1_CONVERSIONS_H
+#define _GF1_CONVERSIONS_H
+
+//****************************************************************************
+//**
+//**    GF1Conversions.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+// Only the GF1 viewer and editor need these, the simulation works purely in Clarity types.
+
+#include <GF1_Vector3.h>
+#include <Clarity/Math/Vector2.h>
+
+namespace CarDemo
+{
+	inline GF1::Vector3 ToGF1Vector(const Clarity::Vector2& v)
+	{
+		GF1::Vector3 out;
+		out.x = v.x;
+		out.y = v.y;
+		out.z = 0;
+		return out;
+	}
+
+	inline Clarity::Vector2 ToClarityVector(const GF1::Vector3& v)
+	{
+		Clarity::Vector2 out;
+		out.x = v.x;
+		out.y = v.y;
+		return out;
+	}
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _GF1_CONVERSIONS_H
\ No newline at end of file
@@ -12,11 +12,15 @@
 //**
 //****************************************************************************
 
-#include <GF1_Vector3.h>
+#include <math.h>
+#include <stdlib.h>
+
 #include <Clarity/Math/Vector2.h>
 #include <Clarity/Math/Ray2.h>
 #include <Clarity/Math/Math.h>
 
+#include "RandomStream.h"
+
 namespace GF1
 {
 	class Sprite;
@@ -46,24 +50,6 @@ namespace CarDemo
 
 	const float MAX_ROTATION_PER_SECOND = 80.0f; // Degrees per seconds.
 	
-	inline GF1::Vector3 ToGF1Vector(const Clarity::Vector2& v)
-	{
-		GF1::Vector3 out;
-		out.x = v.x;
-		out.y = v.y;
-		out.z = 0;
-		return out;
-	}
-
-	inline Clarity::Vector2 ToClarityVector(const GF1::Vector3& v)
-	{
-		Clarity::Vector2 out;
-		out.x = v.x;
-		out.y = v.y;
-		return out;
-	}
-
-
 	inline Clarity::Ray2 ToRay2(const Clarity::Vector2& dir, const Clarity::Vector2& origin)
 	{
 		return Clarity::Ray2(origin, dir);
@@ -74,25 +60,26 @@ namespace CarDemo
 	// Thank you to my friends Wikipedia, AI Techniques for Game Programming 
 	// and AI Game Engine Programming for  explaining the constant 'e' and
 	// showing an implemntation of Sigmoid Curve equation.
+	// These are the single value reference versions, the layers squash whole
+	// buffers at once through Activation.h.
 	// ----------------------------------------------------------------------
-	static const float e = 2.7183f;
 
-	// Creates an S curve based from the mathematical constant '.' This is a 
+	// Creates an S curve based from the mathematical constant 'e'. This is a 
 	// clamped value from 0 to 1.
 	// 
 	inline float Sigmoid(float a, float p)
 	{
 		float ap = (-a)/p;
-		return (1 / (1 + Clarity::Exp(ap)));
+		return (1 / (1 + expf(ap)));
 	}
 
-	// Creates an S curve based from the mathematical constant '.' This is a 
+	// Creates an S curve based from the mathematical constant 'e'. This is a 
 	// clamped value from -1 to 1.
 	// The higher the value of p the steeper the curve is.
 	inline float BiPolarSigmoid(float a, float p)
 	{
 		float ap = (-a)/p;
-		return (2 / (1 + Clarity::Exp(ap)) - 1);
+		return (2 / (1 + expf(ap)) - 1);
 	}
 
 	/*inline float HalfBiPolarSigmoid(float a, float p)
@@ -101,14 +88,15 @@ namespace CarDemo
 		return (2 / (1 + exp(ap)) - 1);
 	}*/
 
+	// Both draw from this thread's RandomStream, so they follow SetRandomSeed.
 	inline float RandomFloat()
 	{
-		return (float)rand()/*0 to 32767*/ / (float)RAND_MAX/*32767*/ + 1.0f;
+		return ThreadRandom().NextUnit() + 1.0f;
 	}
 
 	inline float RandomClamped()
 	{
-		return RandomFloat() - RandomFloat();
+		return ThreadRandom().NextClamped();
 	}
 
 	inline float Clamp( float val, float min, float max)
@@ -14,16 +14,27 @@
 
 #include <vector>
 
+#include "BreedingPolicy.h"
+#include "Genome.h"
+#include "MutationKernels.h"
+#include "RandomStream.h"
+
 // Forward Declarations
 namespace CarDemo
 {
-	class Genome;
 	class NeuralNet;
+	class NetworkLayout;
+	class CheckpointWriter;
 };
 
 namespace CarDemo 
 {
 
+	// The population lives in one arena rather than one allocation per genome: a matrix of
+	// totalPopulation x totalGenomeWeights floats, genome after genome, beside arrays of their
+	// fitnesses and IDs. Breeding writes the children straight into a second arena of the same
+	// size and then swaps the two, so once the first generation is allocated the GA never touches
+	// the heap again and every pass over the population is a walk through contiguous memory.
 	class GeneticAlgorithm
 	{
 	private:
@@ -32,36 +43,124 @@ namespace CarDemo
 		int genomeID;
 		int generation;
 		int totalGenomeWeights;
-		std::vector<Genome*> population;
+
+		// Where each neuron's weights start in a genome, with the genome's length last, so block
+		// 'i' runs from crossoverSplits[i] to crossoverSplits[i + 1].
 		std::vector<int> crossoverSplits;
 
-		void GetBestCases(int totalGenomes, std::vector<Genome*> &out);
-		void CrossBreed(Genome* g1, Genome* g2, Genome* &baby1, Genome* &baby2);
-		void Mutate(Genome* genome);
-		Genome* CreateNewGenome(unsigned int totalWeights);
+		// The current population.
+		std::vector<float> weights;
+		std::vector<float> fitnesses;
+		std::vector<int> IDs;
+
+		// Each genome's own mutation sigma, only evolved by MUTATION_SELF_ADAPTIVE.
+		std::vector<float> sigmas;
+
+		// The next population, being bred.
+		std::vector<float> childWeights;
+		std::vector<int> childIDs;
+		std::vector<float> childSigmas;
+
+		BreedingPolicy policy;
+
+		// The elites, fittest first, and the parents of the bred children, pair after pair.
+		std::vector<int> bestCases;
+		std::vector<int> parents;
+
+		// Where the second child of a pair goes when there's only room for the first.
+		std::vector<float> spareChild;
+
+		// The GA draws from its own stream so its state can be saved in a checkpoint and a
+		// resumed run makes exactly the same choices.
+		RandomStream random;
+
+		// The mutation kernels' generators, reseeded from 'random' every generation.
+		MutationLanes mutationLanes;
+
+		CheckpointWriter* checkpointWriter;
+
+		// Sizes both arenas for the current population, keeping what they already hold.
+		void AllocatePopulation();
+
+		float* GetChildWeights(int child);
+
+		// Fills 'parents' with 'pairs' pairs as the policy's selection operator picks them.
+		void SelectParents(int pairs);
+
+		// Breeds children 'first' to 'end' from 'parents' and mutates them. The crossover is
+		// picked once, by the switch in BreedChildren, and its loop compiled for each, so no
+		// operator costs a call per weight.
+		void BreedChildren(int first, int end);
+		template <class Crossover>
+		void BreedChildren(const Crossover& crossover, int first, int end);
+
+		// Mutates children 'first' to 'end', which lie end to end in the arena, as one block.
+		void MutateChildren(int first, int end);
+		void CreateNewGenome(int child);
+
+		// Makes the bred children the current population.
+		void SwapPopulations();
+
+		GeneticAlgorithm(const GeneticAlgorithm&);
+		GeneticAlgorithm& operator=(const GeneticAlgorithm&);
+
 	protected:
 	public:
 		GeneticAlgorithm();
 		~GeneticAlgorithm();
 
-		Genome* GetNextGenome();
-		Genome* GetBestGenome();
-		Genome* GetWorstGenome();
-		Genome* GetGenome(int index);
+		// Empty genomes once the population or the index runs out.
+		Genome GetNextGenome();
+		Genome GetBestGenome() const;
+		Genome GetWorstGenome() const;
+		Genome GetGenome(int index) const;
 
 		int GetCurrentGenomeIndex() const;
 		int GetCurrentGenomeID() const;
 		int GetCurrentGeneration() const;
 		int GetTotalPopulation() const;
+		int GetTotalWeights() const;
+
+		// Every genome's weights, GetTotalWeights floats apart, for BatchedNeuralNet.
+		const float* GetPopulationWeights() const;
 
 		// Creates a new population 
 		void GenerateNewPopulation(unsigned int totalPop, unsigned int totalWeights);
 		void BreedPopulation();
 		void ClearPopulation();
 
+		// Works out where the neurons of a genome of this shape start, so crossover can cut
+		// between them instead of through them. Until it's called, or if the population's genomes
+		// turn out to be another length, every weight counts as a neuron of its own.
 		void GenerateCrossoverSplits(int neuronsPerHidden, int inputs, int outputs);
+		void GenerateCrossoverSplits(const NetworkLayout& layout);
+
+		// Takes effect from the next BreedPopulation.
+		void SetBreedingPolicy(const BreedingPolicy& policyIn);
+		const BreedingPolicy& GetBreedingPolicy() const;
 
 		void SetGenomeFitness(float fitness, int index);
+
+		void SetSeed(unsigned long long seed);
+
+		// Packs the whole population, the counters and the generator state into one buffer
+		// laid out as described in GACheckpoint.h.
+		void SaveState(std::vector<unsigned char> &out) const;
+
+		// Restores a buffer written by SaveState. Returns false, leaving the GA untouched, if
+		// the buffer is damaged or isn't a checkpoint.
+		bool LoadState(const unsigned char* data, unsigned int size);
+
+		// Snapshots the GA and writes it to 'filename' on a background thread. Only the copy
+		// into the snapshot buffer happens on the calling thread. Returns false if the
+		// previous SaveCheckpoint failed to reach the disk.
+		bool SaveCheckpoint(const char* filename);
+
+		// Waits for the last SaveCheckpoint to reach the disk. Returns false if it failed.
+		bool WaitForCheckpoint();
+
+		// Replaces the GA's state with a checkpoint file.
+		bool LoadCheckpoint(const char* filename);
 	};
 	
 }; // End namespace CarDemo.
@@ -12,11 +12,14 @@
 //**
 //****************************************************************************
 
-#include <vector>
+#include <stddef.h>
 
 namespace CarDemo 
 {
 
+	// One member of a GeneticAlgorithm's population. The weights aren't owned: they point into
+	// the GA's population arena, so a Genome is only good until the population is next bred,
+	// generated, cleared or loaded. An empty Genome (no weights) stands for "no such genome".
 	class Genome
 	{
 	private:
@@ -24,8 +27,29 @@ namespace CarDemo
 	public:
 		float fitness;
 		int ID;
-		std::vector<float> weights;
+		const float* weights;
+		int totalWeights;
 
+		Genome()
+			: fitness(0.0f)
+			, ID(-1)
+			, weights(NULL)
+			, totalWeights(0)
+		{
+		}
+
+		Genome(int IDIn, float fitnessIn, const float* weightsIn, int totalWeightsIn)
+			: fitness(fitnessIn)
+			, ID(IDIn)
+			, weights(weightsIn)
+			, totalWeights(totalWeightsIn)
+		{
+		}
+
+		bool IsEmpty() const
+		{
+			return weights == NULL;
+		}
 	};
 	
 }; // End namespace CarDemo.
@@ -0,0 +1,135 @@
+#ifndef _LAYER_KERNELS_H
+#define _LAYER_KERNELS_H
+
+//****************************************************************************
+//**
+//**    LayerKernels.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define CARDEMO_X86
+#endif
+
+// MSVC lets any function use any intrinsic, GCC and Clang need to be told which functions
+// may use the wider instruction sets.
+#if defined(_MSC_VER)
+#define KERNEL_TARGET_SSE2
+#define KERNEL_TARGET_AVX2
+#else
+#define KERNEL_TARGET_SSE2 __attribute__((target("sse2")))
+#define KERNEL_TARGET_AVX2 __attribute__((target("avx2,fma,f16c")))
+#endif
+
+namespace CarDemo
+{
+	// The instruction sets the kernels can be built for, in order of preference.
+	enum KernelLevel
+	{
+		KERNEL_SCALAR,
+		KERNEL_SSE2,
+		KERNEL_AVX2,
+	};
+
+	// Computes the pre-activation value (weighted sum of the inputs plus the bias) of every neuron in
+	// a dense layer. 'weights' is the row-major neurons x (inputs + 1) layer matrix with the bias in
+	// the last column, 'out' must have room for 'neurons' floats.
+	typedef void (*DenseKernel)(const float* weights, int neurons, int inputs, const float* input, float* out);
+
+	// Plain C++ version, kept as the reference the SIMD versions are checked against.
+	void DenseLayerScalar(const float* weights, int neurons, int inputs, const float* input, float* out);
+
+	// Four rows at a time with 128 bit vectors.
+	void DenseLayerSSE2(const float* weights, int neurons, int inputs, const float* input, float* out);
+
+	// Four rows at a time with 256 bit vectors and fused multiply-adds.
+	void DenseLayerAVX2(const float* weights, int neurons, int inputs, const float* input, float* out);
+
+	// Computes the pre-activations of a dense layer for a whole batch of agents at once (a matrix-matrix
+	// product). 'input' and 'out' are feature-major: input 'j' of agent 'a' lives at input[j * count + a]
+	// and neuron 'n' of agent 'a' is written to out[n * count + a]. Each weight is broadcast across
+	// a run of agents so the inner loop is a straight multiply-add over contiguous memory.
+	typedef void (*DenseBatchKernel)(const float* weights, int neurons, int inputs, const float* input, int count, float* out);
+
+	void DenseBatchScalar(const float* weights, int neurons, int inputs, const float* input, int count, float* out);
+	void DenseBatchSSE2(const float* weights, int neurons, int inputs, const float* input, int count, float* out);
+	void DenseBatchAVX2(const float* weights, int neurons, int inputs, const float* input, int count, float* out);
+
+	// The same product as DenseKernel, with the weights stored as IEEE half floats. They are
+	// widened in registers as the sums are made (F16C on AVX2), so the result is exactly what
+	// the float kernel of the same level gives on the widened matrix. That relies on this file's
+	// kernels being built without multiply-add contraction, see KERNEL_SOURCES in CMakeLists.txt.
+	typedef void (*DenseHalfKernel)(const unsigned short* weights, int neurons, int inputs, const float* input, float* out);
+
+	void DenseHalfScalar(const unsigned short* weights, int neurons, int inputs, const float* input, float* out);
+	void DenseHalfSSE2(const unsigned short* weights, int neurons, int inputs, const float* input, float* out);
+	void DenseHalfAVX2(const unsigned short* weights, int neurons, int inputs, const float* input, float* out);
+
+	// Widens one half float. Halves are only ever made by rounding trained weights, so there
+	// are no denormals to handle.
+	inline float HalfToFloat(unsigned short half)
+	{
+		const unsigned int sign = (unsigned int)(half & 0x8000) << 16;
+		const unsigned int exponent = (half >> 10) & 0x1f;
+		const unsigned int mantissa = half & 0x3ff;
+
+		union { float f; unsigned int u; } bits;
+		if (exponent == 0)
+		{
+			bits.u = sign;
+		}
+		else if (exponent == 31)
+		{
+			bits.u = sign | 0x7f800000 | (mantissa << 13);
+		}
+		else
+		{
+			bits.u = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+		}
+		return bits.f;
+	}
+
+	// Rows of a quantized weight matrix are padded with zeros up to a multiple of this many weights,
+	// so the integer kernels never need a tail loop.
+	const int INT8_ROW_ALIGNMENT = 16;
+
+	// Integer dot products for quantized layers. 'weights' is row-major, neurons x stride int8 values
+	// (bias included as an ordinary column), 'input' holds 'stride' int16 values and out[n] receives
+	// the exact int32 sum of row 'n' times the input. 'stride' must be a multiple of INT8_ROW_ALIGNMENT.
+	typedef void (*DenseInt8Kernel)(const signed char* weights, int neurons, int stride, const short* input, int* out);
+
+	void DenseInt8Scalar(const signed char* weights, int neurons, int stride, const short* input, int* out);
+	void DenseInt8SSE2(const signed char* weights, int neurons, int stride, const short* input, int* out);
+	void DenseInt8AVX2(const signed char* weights, int neurons, int stride, const short* input, int* out);
+
+	// Asks the CPU (via CPUID) which of the kernels it can run.
+	KernelLevel DetectKernelLevel();
+
+	// The kernel in use: the best the CPU supports unless SetKernelLevel says otherwise. Safe to
+	// call from any thread, the CPU is only asked once.
+	DenseKernel GetDenseKernel();
+	KernelLevel GetKernelLevel();
+
+	// Overrides the detected kernel, clamped to what the CPU supports. Handy for comparing the
+	// SIMD paths against the scalar one. Threads pick the new level up from their next lookup.
+	void SetKernelLevel(KernelLevel level);
+
+	DenseKernel GetDenseKernel(KernelLevel level);
+
+	DenseBatchKernel GetDenseBatchKernel();
+	DenseBatchKernel GetDenseBatchKernel(KernelLevel level);
+
+	DenseInt8Kernel GetDenseInt8Kernel();
+	DenseInt8Kernel GetDenseInt8Kernel(KernelLevel level);
+
+	DenseHalfKernel GetDenseHalfKernel();
+	DenseHalfKernel GetDenseHalfKernel(KernelLevel level);
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _LAYER_KERNELS_H
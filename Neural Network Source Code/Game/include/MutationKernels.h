@@ -0,0 +1,95 @@
+#ifndef _MUTATION_KERNELS_H
+#define _MUTATION_KERNELS_H
+
+//****************************************************************************
+//**
+//**    MutationKernels.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include "LayerKernels.h"
+
+// Forward Declarations
+namespace CarDemo
+{
+	class RandomStream;
+};
+
+namespace CarDemo
+{
+	// How many generators the mutation kernels run side by side, one per weight of a group.
+	const int MUTATION_LANES = 8;
+
+	// MUTATION_LANES xoshiro128** generators, word by word. Every kernel level steps the same
+	// lanes the same way, so a seed mutates a population identically on any CPU.
+	struct MutationLanes
+	{
+		unsigned int s0[MUTATION_LANES];
+		unsigned int s1[MUTATION_LANES];
+		unsigned int s2[MUTATION_LANES];
+		unsigned int s3[MUTATION_LANES];
+
+		// Gives every lane 128 fresh bits of 'source'.
+		void Seed(RandomStream& source);
+
+		unsigned int Next(int lane);
+	};
+
+	inline unsigned int MutationLanes::Next(int lane)
+	{
+		const unsigned int scaled = s1[lane] * 5;
+		const unsigned int result = ((scaled << 7) | (scaled >> 25)) * 9;
+		const unsigned int shifted = s1[lane] << 9;
+
+		s2[lane] ^= s0[lane];
+		s3[lane] ^= s1[lane];
+		s1[lane] ^= s2[lane];
+		s0[lane] ^= s3[lane];
+		s2[lane] ^= shifted;
+		s3[lane] = (s3[lane] << 11) | (s3[lane] >> 21);
+
+		return result;
+	}
+
+	// Disturbs 'count' weights in place, 'count' a multiple of MUTATION_LANES, weight 'i' drawing
+	// from lane i % MUTATION_LANES. The random numbers are made in registers as they are needed,
+	// so a pass over a whole generation's children never touches memory but the weights.
+	//
+	// Uniform: a weight moves by d * 'scale' whenever another d falls below 'rate', d being the
+	// difference of two 16 bit fractions (the halves of one draw), which is how
+	// RandomStream::NextClamped has always shaped the legacy mutation. Two draws a weight.
+	//
+	// Gaussian: a weight moves by N(0, 'scale') with probability 'rate'. The normal is the sum of
+	// four 16 bit fractions, rescaled (Irwin-Hall), so it needs no logarithm and never strays
+	// past 3.46 sigma. Three draws a weight.
+	typedef void (*MutationKernel)(float* weights, int count, float rate, float scale, MutationLanes& lanes);
+
+	// Plain C++ versions, kept as the reference the SIMD versions are checked against.
+	void MutateUniformScalar(float* weights, int count, float rate, float scale, MutationLanes& lanes);
+	void MutateGaussianScalar(float* weights, int count, float rate, float scale, MutationLanes& lanes);
+
+	// Each group of eight as two 128 bit vectors.
+	void MutateUniformSSE2(float* weights, int count, float rate, float scale, MutationLanes& lanes);
+	void MutateGaussianSSE2(float* weights, int count, float rate, float scale, MutationLanes& lanes);
+
+	// Each group of eight as one 256 bit vector.
+	void MutateUniformAVX2(float* weights, int count, float rate, float scale, MutationLanes& lanes);
+	void MutateGaussianAVX2(float* weights, int count, float rate, float scale, MutationLanes& lanes);
+
+	// Runs 'kernel' over any number of weights; a ragged tail is padded out to a whole group.
+	void ApplyMutation(MutationKernel kernel, float* weights, int count, float rate, float scale, MutationLanes& lanes);
+
+	// The kernels for the level picked in LayerKernels, so SetKernelLevel switches these too.
+	MutationKernel GetUniformMutationKernel();
+	MutationKernel GetUniformMutationKernel(KernelLevel level);
+	MutationKernel GetGaussianMutationKernel();
+	MutationKernel GetGaussianMutationKernel(KernelLevel level);
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _MUTATION_KERNELS_H
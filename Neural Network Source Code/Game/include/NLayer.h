@@ -18,63 +18,35 @@
 #include <assert.h>
 
 #include "GameGlobals.h"
+#include "Activation.h"
+#include "LayerKernels.h"
 
 namespace CarDemo 
 {
-	class Neuron
-	{
-	private:
-	protected:
-	public:
-		int numInputs;
-		std::vector<float> weights;
-
-		// 
-		void Populate(int numOfInputs)
-		{
-			this->numInputs = numOfInputs;
-
-			// Initilise the weights
-			for (unsigned int i = 0; i < numOfInputs; i++)
-			{
-				weights.push_back(RandomClamped());
-			}
-
-			// Add an extra weight as the bias (the value that acts as a threshold in a step activation).
-			weights.push_back(RandomClamped());
-		}
-
-		void Initilise(std::vector<float> weightsIn, int numOfInputs)
-		{
-			// The number of inputs should not be equal or exceed the weights.
-			// If so, something is not right in the exported NN file or you've 
-			// just done something odd to fuck this up.
-			//assert(numOfInputs < weightsIn.size());
-
-			this->numInputs = numOfInputs;
-			weights = weightsIn;
-		}
-
-		Neuron(){}
-		~Neuron(){}
-	};
-
 	const float BIAS = -1.0f;
 
-	enum EvalFunction
-	{
-		EVAL_SIGMOID,
-		EVAL_STEP,
-		EVAL_BIPOLAR,
-	};
-
-	// The NLayer is a tighly connected
+	// The NLayer is a tighly connected layer of neurons.
+	// The weights for every neuron live in one contiguous, aligned, row-major matrix of
+	// totalNeurons rows by (totalInputs + 1) columns. The last column of each row is the
+	// bias weight, which is multiplied against the constant BIAS input.
+	// Each layer squashes its sums with its own EvalFunction, sigmoid unless told otherwise.
+	// A layer either owns its matrix or is a view onto one owned by someone else (usually a
+	// Genome), in which case it never copies or frees it.
 	class NLayer
 	{
 	private:
 		int totalNeurons;
 		int totalInputs;
-		std::vector<Neuron> neurons;
+		float* weights;			// Owned matrix, NULL for a view.
+		const float* matrix;	// The matrix evaluated, either 'weights' or the viewed one.
+		EvalFunction function;
+
+		void Allocate(int numOfNeurons, int numOfInputs);
+		void Release();
+
+		// Layers own their weight matrix; copying one would double free it.
+		NLayer(const NLayer&);
+		NLayer& operator=(const NLayer&);
 
 	protected:
 	public:
@@ -82,19 +54,49 @@ namespace CarDemo
 		~NLayer();
 
 		// Evalutes the inputs to the outputs, the amount of input should be mapped directly to the amount
-		// of neurons in the layer. Each neuron will be mapped to the corresponding input
-		void Evaluate(std::vector<float> input, std::vector<float> &output);
+		// of inputs in the layer. Each neuron writes one value into output, so it must have room for
+		// GetTotalNeurons() floats. Nothing is allocated.
+		void Evaluate(const float* input, float* output) const;
+
+		// Evaluate with the squashing function fixed at compile time. Evaluate picks the
+		// instantiation matching the layer's function once per call.
+		template <EvalFunction F>
+		void EvaluateAs(const float* input, float* output) const
+		{
+			GetDenseKernel()(matrix, totalNeurons, totalInputs, input, output);
+			ApplyActivation<F>(output, totalNeurons);
+		}
 
-		void SaveLayer(std::ofstream &fileOut, char* layerType);
-		void LoadLayer(std::vector<Neuron> in);
+		void SetFunction(EvalFunction evalFunction);
+		EvalFunction GetFunction() const;
+
+		void SaveLayer(std::ofstream &fileOut, const char* layerType);
 
 		// Creates the layer with 'n' neurons, intilise with random weights.
 		void PopulateLayer(int numOfNeurons, int numOfInputs);
 
-		void SetWeights(std::vector<float> weights, int numOfNeurons, int numOfInputs);
-		void GetWeights(std::vector<float> &out);
+		// Copies numOfNeurons * (numOfInputs + 1) row-major weights (bias last in each row) into the layer.
+		void SetWeights(const float* weights, int numOfNeurons, int numOfInputs);
+		void SetWeights(const std::vector<float> &weights, int numOfNeurons, int numOfInputs);
+		void GetWeights(std::vector<float> &out) const;
+
+		// Makes the layer a view onto numOfNeurons * (numOfInputs + 1) weights laid out like
+		// SetWeights expects. Nothing is copied, so 'weights' must outlive the view.
+		void SetView(const float* weights, int numOfNeurons, int numOfInputs);
+		bool IsView() const;
+
+		int GetTotalNeurons() const;
+		int GetTotalInputs() const;
+
+		// The number of floats in one row of the weight matrix, (inputs + 1).
+		int GetStride() const;
+		int GetTotalWeights() const;
+
+		// The matrix the layer evaluates with, whether it owns it or views it.
+		const float* GetWeightMatrix() const;
 
-		void SetNeurons(std::vector<Neuron> neurons, int numOfNeurons, int numOfInputs);
+		// The owned matrix, NULL if the layer is a view.
+		float* GetOwnedWeights();
 	};
 	
 }; // End namespace CarDemo.
@@ -0,0 +1,108 @@
+#ifndef _NET_FILE_H
+#define _NET_FILE_H
+
+//****************************************************************************
+//**
+//**    NetFile.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include "NetworkLayout.h"
+
+// Forward Declarations
+namespace CarDemo
+{
+	class NeuralNet;
+};
+
+namespace CarDemo
+{
+	// ----------------------------------------------------------------------
+	// Binary net format, little endian throughout:
+	//   NetFileHeader                      64 bytes
+	//   NetFileLayer * layerCount          32 bytes each, padded to 64
+	//   one weight block per layer         each starting on a 64 byte boundary
+	// A weight block is the layer's row-major neurons x (inputs + 1) float
+	// matrix, exactly as NLayer holds it. The checksum is FNV-1a over every
+	// byte after the header.
+	// ----------------------------------------------------------------------
+	const unsigned int NET_FILE_MAGIC = 0x4e4e4443; // "CDNN"
+	const unsigned int NET_FILE_VERSION = 1;
+	const unsigned int NET_FILE_ALIGNMENT = 64;
+
+	struct NetFileHeader
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int fileSize;
+		unsigned int checksum;
+		unsigned int layerCount;
+		unsigned int inputs;
+		unsigned int outputs;
+		unsigned int reserved[9];
+	};
+
+	struct NetFileLayer
+	{
+		unsigned int inputs;
+		unsigned int neurons;
+		unsigned int function;		// EvalFunction.
+		unsigned int offset;		// Byte offset of the weight block from the start of the file.
+		unsigned int weightCount;
+		unsigned int reserved[3];
+	};
+
+	// FNV-1a, used to check the weights made it to and from disk intact.
+	unsigned int NetFileChecksum(const unsigned char* data, unsigned int size);
+
+	// Writes 'net' in the binary format. Returns false if the file couldn't be written.
+	bool WriteNetFile(const NeuralNet& net, const char* filename);
+
+	// A binary net file mapped straight into memory. The weight blocks are read in place, so a
+	// NeuralNet built with NeuralNet::FromNetFile costs no parsing and no copying, and the pages
+	// are only read from disk when they are first touched.
+	class MappedNetFile
+	{
+	private:
+		const unsigned char* data;
+		unsigned int size;
+		NetworkLayout layout;
+
+#if defined(_WIN32)
+		void* fileHandle;
+		void* mappingHandle;
+#else
+		int fileHandle;
+#endif
+
+		bool Validate(bool verifyChecksum);
+
+		MappedNetFile(const MappedNetFile&);
+		MappedNetFile& operator=(const MappedNetFile&);
+
+	protected:
+	public:
+		MappedNetFile();
+		~MappedNetFile();
+
+		// Maps the file and checks its header, sizes and (unless told not to) its checksum.
+		// Skipping the checksum avoids reading every page up front.
+		bool Open(const char* filename, bool verifyChecksum = true);
+		void Close();
+
+		bool IsOpen() const;
+
+		const NetworkLayout& GetLayout() const;
+
+		// The weight block for layer 'index', 64 byte aligned, laid out like NLayer's matrix.
+		const float* GetLayerWeights(int index) const;
+	};
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _NET_FILE_H
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef _NETWORK_LAYOUT_H
+#define _NETWORK_LAYOUT_H
+
+//****************************************************************************
+//**
+//**    NetworkLayout.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <vector>
+
+#include "Activation.h"
+
+namespace CarDemo
+{
+	// Where one layer's weight matrix lives inside a flat genome.
+	struct LayerLayout
+	{
+		int inputs;
+		int neurons;
+		int offset;		// Index of the layer's first weight in the genome.
+		EvalFunction function;
+	};
+
+	// Describes how a flat weight vector (a Genome) maps onto the layers of a net. Layers are
+	// stored back to back in evaluation order, hidden layers first and the output layer last,
+	// each a row-major neurons x (inputs + 1) matrix with the bias in the last column.
+	class NetworkLayout
+	{
+	private:
+		std::vector<LayerLayout> layers;
+		int totalWeights;
+		int widest;
+
+	protected:
+	public:
+		NetworkLayout();
+
+		// The usual shape, 'numOfHiddenLayers' layers of 'neuronsPerHidden' followed by the output layer.
+		NetworkLayout(int numOfHiddenLayers, int numOfInputs, int neuronsPerHidden, int numOfOutputs,
+					  EvalFunction hiddenFunction = EVAL_SIGMOID, EvalFunction outputFunction = EVAL_SIGMOID);
+
+		void Clear();
+
+		// Appends a layer after the current last one. 'inputs' should match the previous
+		// layer's neuron count.
+		void AddLayer(int inputs, int neurons, EvalFunction function = EVAL_SIGMOID);
+
+		int GetTotalLayers() const;
+		const LayerLayout& GetLayer(int index) const;
+
+		// Hidden layers are every layer but the last.
+		int GetNumOfHiddenLayers() const;
+		const LayerLayout& GetOutputLayer() const;
+
+		int GetTotalInputs() const;
+		int GetTotalOutputs() const;
+
+		// Number of floats in a genome of this layout.
+		int GetTotalWeights() const;
+
+		// The most neurons (or inputs) any one layer has, for sizing activation buffers.
+		int GetWidest() const;
+
+		bool operator==(const NetworkLayout& other) const;
+		bool operator!=(const NetworkLayout& other) const;
+	};
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _NETWORK_LAYOUT_H
\ No newline at end of file
@@ -14,11 +14,15 @@
 
 #include <vector>
 
+#include "Activation.h"
+#include "NetworkLayout.h"
+
 // Forward Declarations
 namespace CarDemo
 {
 	class NLayer;
 	class Genome;
+	class MappedNetFile;
 };
 
 namespace CarDemo 
@@ -36,28 +40,80 @@ namespace CarDemo
 		NLayer* inputLayer;
 		std::vector<NLayer*> hiddenLayers;
 		NLayer* outputLayer;
-		std::vector<float> outputs;
+
+		// Ping-pong activation buffers, each layer reads from one and writes into the other.
+		// They are sized once when the net is built so that Update never touches the heap.
+		std::vector<float> activations[2];
+		const float* outputs;
+
+		// Applied to every layer built by CreateNet and FromGenome.
+		EvalFunction hiddenFunction;
+		EvalFunction outputFunction;
+
+		void AllocateBuffers();
+		bool MatchesLayout(const NetworkLayout& layout) const;
+		void AddLayerView(const LayerLayout& shape, const float* weights, bool isOutput);
 	protected:
 	public:
 		NeuralNet();
 		~NeuralNet();
 
+		// Runs the forward pass. Does not allocate once the net has been built.
 		void Update();
 
-		void SetInput(std::vector<float> in);
+		// Copies 'count' inputs into the net. Any inputs beyond the net's input count are ignored.
+		void SetInput(const float* in, int count);
+		void SetInput(const std::vector<float> &in);
 		float GetOutput(unsigned int ID);
 		int GetTotalOutputs() const;
+		int GetTotalInputs() const;
+
+		const NLayer* GetHiddenLayer(int index) const;
+		const NLayer* GetOutputLayer() const;
+
+		// Text format, kept for interchange and hand editing.
+		void ExportNet(const char* filename);
+		void LoadNet(const char* filename);
+
+		// Binary format (see NetFile.h), written to ExportedNNs/ like ExportNet.
+		bool ExportBinaryNet(const char* filename);
 
-		void ExportNet(char* filename);
-		void LoadNet(char* filename);
+		// Builds the net as views onto the weight blocks of a mapped binary file, nothing is
+		// parsed or copied. The file must stay open for as long as the net is used.
+		void FromNetFile(const MappedNetFile& file);
 
 		void CreateNet(int numOfHiddenLayers, int numOfInputs, int neuronsPerHidden, int numOfOutputs);
-		int GetNumOfHiddenLayers();
+
+		// Builds a net of any depth with random weights.
+		void CreateNet(const NetworkLayout& layout);
+
+		// Describes the current net, with offsets matching ToGenome.
+		void GetLayout(NetworkLayout& out) const;
+
+		// Changes the squashing function of the hidden or output layers, both for the current
+		// layers and any built later. Nets are sigmoid throughout by default.
+		void SetHiddenFunction(EvalFunction function);
+		void SetOutputFunction(EvalFunction function);
+		EvalFunction GetHiddenFunction() const;
+		EvalFunction GetOutputFunction() const;
+		int GetNumOfHiddenLayers() const;
 
 		void ReleaseNet();
 
-		Genome* ToGenome();
+		// Packs every weight into 'out' in genome order, hidden layers first.
+		void ToGenome(std::vector<float> &out);
+
+		// Builds a one hidden layer net over the genome's weights.
 		void FromGenome(const Genome& genome, int numOfInputs, int neuronsPerHidden, int numOfOutputs);
+
+		// Builds the layers described by 'layout' as views straight into the genome's weights,
+		// nothing is copied. The genome must outlive the net (or the next FromGenome / ReleaseNet).
+		void FromGenome(const Genome& genome, const NetworkLayout& layout);
+
+		// Repoints a net built by FromGenome at another genome of the same layout. Nothing is
+		// allocated or copied, it only swaps one pointer per layer. Returns false and leaves the
+		// net alone if the net isn't a genome view or the genome is too small.
+		bool BindGenome(const Genome& genome);
 	};
 	
 }; // End namespace CarDemo.
@@ -0,0 +1,77 @@
+#ifndef _POPULATION_EVALUATOR_H
+#define _POPULATION_EVALUATOR_H
+
+//****************************************************************************
+//**
+//**    PopulationEvaluator.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <vector>
+
+#include "Simulation.h"
+#include "NetworkLayout.h"
+#include "WorkStealingPool.h"
+
+// Forward Declarations
+namespace CarDemo
+{
+	class Genome;
+	class GeneticAlgorithm;
+	class NeuralNet;
+	class TrackGeometry;
+};
+
+namespace CarDemo
+{
+	// Drives every genome of a population round the track at once, one episode per genome,
+	// spread over a WorkStealingPool. Each thread has its own Simulation and NeuralNet, the
+	// track and checkpoints are shared read only. An episode only depends on its genome, so
+	// the fitnesses come out the same whatever the thread count.
+	class PopulationEvaluator
+	{
+	private:
+		struct WorkerState
+		{
+			Simulation* simulation;
+			NeuralNet* net;
+		};
+
+		const TrackGeometry* track;
+		const std::vector<Checkpoint>* checkpoints;
+		NetworkLayout layout;
+
+		WorkStealingPool pool;
+		std::vector<WorkerState> workers;
+		std::vector<float> fitnesses;
+
+		float RunEpisode(const Genome& genome, WorkerState& state);
+
+		PopulationEvaluator(const PopulationEvaluator&);
+		PopulationEvaluator& operator=(const PopulationEvaluator&);
+
+	protected:
+	public:
+		// 'trackIn' and 'checkpointsIn' must outlive the evaluator. 'threadCount' of 0 uses
+		// every hardware thread.
+		PopulationEvaluator(const TrackGeometry& trackIn, const std::vector<Checkpoint>& checkpointsIn,
+							const NetworkLayout& layoutIn, int threadCount = 0);
+		~PopulationEvaluator();
+
+		// Runs an episode for every genome and stores the results with SetGenomeFitness.
+		void Evaluate(GeneticAlgorithm& genAlg);
+
+		// Runs a single episode on the calling thread.
+		float EvaluateGenome(const Genome& genome);
+
+		int GetThreadCount() const;
+	};
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _POPULATION_EVALUATOR_H
\ No newline at end of file
@@ -0,0 +1,124 @@
+#ifndef _QUANTIZED_NEURAL_NET_H
+#define _QUANTIZED_NEURAL_NET_H
+
+//****************************************************************************
+//**
+//**    QuantizedNeuralNet.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <vector>
+#include <iostream>
+
+#include "Activation.h"
+
+// Forward Declarations
+namespace CarDemo
+{
+	class NeuralNet;
+	class NLayer;
+};
+
+namespace CarDemo
+{
+	enum QuantizeFormat
+	{
+		// Weights and layer inputs are stored as int8 with one scale per layer, the sums are
+		// done in integer arithmetic.
+		QUANTIZE_INT8,
+
+		// Weights are stored as IEEE half floats and widened in registers as the sums are made.
+		QUANTIZE_FP16,
+	};
+
+	// How far a quantized net drifts from the float net it was built from, over a set of
+	// recorded inputs fed to both (open loop, see CompareOpenLoop).
+	struct QuantizationReport
+	{
+		int samples;
+		float maxError;			// Largest absolute difference of any output.
+		float meanError;		// Mean absolute difference over every output.
+		float maxSteerError;	// Largest difference of (left - right), which is what turns the car.
+		int floatBytes;			// Weight memory of the float net.
+		int quantizedBytes;		// Weight memory of the quantized net, scales included.
+	};
+
+	// A frozen, post-training quantized copy of a NeuralNet for running lots of exported
+	// controllers at once. Build it from a trained net plus a recording of the sensor inputs it
+	// sees on the track; the recording sets the int8 range of every layer's inputs.
+	class QuantizedNeuralNet
+	{
+	private:
+		struct QuantizedLayer
+		{
+			int inputs;
+			int neurons;
+			int stride;				// Inputs + bias, padded up to INT8_ROW_ALIGNMENT for int8.
+			EvalFunction function;
+			float weightScale;		// Real weight = int8 weight * weightScale.
+			float inputScale;		// Real input = int8 input * inputScale.
+			signed char* weights;
+			unsigned short* halfWeights;
+		};
+
+		QuantizeFormat format;
+		int inputAmount;
+		int outputAmount;
+		std::vector<QuantizedLayer> layers;
+
+		// Scratch space sized once by Quantize so Update never allocates.
+		short* quantizedInput;
+		int* sums;
+		std::vector<float> activations[2];
+
+		void QuantizeLayer(const NLayer& layer, float maxInput, QuantizedLayer& out);
+		void EvaluateLayer(const QuantizedLayer& layer, const float* input, float* output);
+
+		QuantizedNeuralNet(const QuantizedNeuralNet&);
+		QuantizedNeuralNet& operator=(const QuantizedNeuralNet&);
+
+	protected:
+	public:
+		QuantizedNeuralNet();
+		~QuantizedNeuralNet();
+
+		// Converts 'net' to 'formatIn'. 'calibration' holds 'samples' recorded input vectors of
+		// net.GetTotalInputs() floats each. They are run through the float net to find the range
+		// of every layer's inputs. Without any samples, the inputs are assumed to lie in -1 to 1.
+		void Quantize(const NeuralNet& net, QuantizeFormat formatIn, const float* calibration, int samples);
+
+		void Release();
+
+		// Runs the forward pass on GetTotalInputs() floats, writing GetTotalOutputs() floats.
+		void Update(const float* input, float* output);
+
+		// Feeds the same 'samples' recorded input vectors to both nets and measures how far apart
+		// their outputs are. This is open loop: the quantized net never drives the car, so it
+		// says nothing about errors that would compound over a lap.
+		QuantizationReport CompareOpenLoop(NeuralNet& net, const float* inputs, int samples);
+
+		int GetTotalInputs() const;
+		int GetTotalOutputs() const;
+		QuantizeFormat GetFormat() const;
+
+		// Bytes used by the weights and their scales.
+		int GetWeightBytes() const;
+	};
+
+	void PrintQuantizationReport(const QuantizationReport& report, std::ostream& out);
+
+	// Saves recorded sensor inputs ('inputsPerSample' floats per frame) to ExportedNNs/filename,
+	// for calibrating and checking quantized nets later on.
+	void ExportSensorRecording(const char* filename, const std::vector<float> &inputs, int inputsPerSample);
+
+	// Loads a file written by ExportSensorRecording. Returns false if it couldn't be read.
+	bool LoadSensorRecording(const char* filename, std::vector<float> &inputs, int &inputsPerSample);
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _QUANTIZED_NEURAL_NET_H
\ No newline at end of file
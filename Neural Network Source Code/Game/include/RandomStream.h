@@ -0,0 +1,117 @@
+#ifndef _RANDOM_STREAM_H
+#define _RANDOM_STREAM_H
+
+//****************************************************************************
+//**
+//**    RandomStream.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+namespace CarDemo
+{
+	// Used until SetRandomSeed is called, so an unseeded run always repeats.
+	const unsigned long long DEFAULT_RANDOM_SEED = 0x9E3779B97F4A7C15ULL;
+
+	// A xoshiro128** generator (Blackman and Vigna): 128 bits of state, 32 bit draws, a period
+	// of 2^128 - 1. Everything random in the demo comes from one of these rather than rand(), so
+	// a run is fixed by its seed on every platform and every thread count.
+	//
+	// Streams that must not overlap are made by jumping: Jump moves 2^64 draws ahead and
+	// LongJump 2^96, so a stream split off with Split can never run into its parent or its
+	// siblings. Threads get LongJump apart streams, genomes Jump apart ones.
+	class RandomStream
+	{
+	private:
+		unsigned int state[4];
+
+		void Advance(const unsigned int* polynomial);
+
+	protected:
+	public:
+		RandomStream();
+		explicit RandomStream(unsigned long long seed);
+
+		// Any seed works, zero included. Equal seeds give equal streams.
+		void Seed(unsigned long long seed);
+
+		unsigned int Next();
+		unsigned long long Next64();
+
+		// Uniform in 0 to bound - 1, without modulo bias. 'bound' must be above zero.
+		unsigned int NextBelow(unsigned int bound);
+
+		// 24 bits, so every value is exactly representable, 0 up to but not including 1.
+		float NextUnit();
+
+		// -1 to 1, the difference of two NextUnit, the same spread RandomClamped always had.
+		float NextClamped();
+
+		// Standard normal, mean 0 and deviation 1, by Box-Muller. Takes two draws.
+		float NextGaussian();
+
+		void Jump();
+		void LongJump();
+
+		// Hands out 'count' streams, each Jump apart, and moves this stream past all of them.
+		void Split(RandomStream* out, int count);
+
+		// Bulk versions of NextUnit and NextClamped. Eight generators seeded from this stream run
+		// side by side so the loop vectorizes; the values differ from calling NextUnit in a loop
+		// but are just as fixed by the seed.
+		void FillUnit(float* out, int count);
+		void FillClamped(float* out, int count);
+
+		// The raw state, for checkpoints.
+		void GetState(unsigned int out[4]) const;
+		void SetState(const unsigned int in[4]);
+	};
+
+	inline unsigned int RandomStream::Next()
+	{
+		const unsigned int scaled = state[1] * 5;
+		const unsigned int result = ((scaled << 7) | (scaled >> 25)) * 9;
+		const unsigned int shifted = state[1] << 9;
+
+		state[2] ^= state[0];
+		state[3] ^= state[1];
+		state[1] ^= state[2];
+		state[0] ^= state[3];
+		state[2] ^= shifted;
+		state[3] = (state[3] << 11) | (state[3] >> 21);
+
+		return result;
+	}
+
+	inline unsigned long long RandomStream::Next64()
+	{
+		const unsigned long long high = Next();
+		return (high << 32) | Next();
+	}
+
+	inline float RandomStream::NextUnit()
+	{
+		return (float)(int)(Next() >> 8) * (1.0f / 16777216.0f);
+	}
+
+	inline float RandomStream::NextClamped()
+	{
+		const float a = NextUnit();
+		return a - NextUnit();
+	}
+
+	// Starts every thread's stream over from 'seed'. The calling thread gets the first stream,
+	// other threads take the next ones in the order they first ask for one.
+	void SetRandomSeed(unsigned long long seed);
+	unsigned long long GetRandomSeed();
+
+	// This thread's stream, LongJump apart from every other thread's.
+	RandomStream& ThreadRandom();
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _RANDOM_STREAM_H
@@ -0,0 +1,60 @@
+#ifndef _SELECTION_H
+#define _SELECTION_H
+
+//****************************************************************************
+//**
+//**    Selection.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <vector>
+
+// Forward Declarations
+namespace CarDemo
+{
+	class RandomStream;
+};
+
+namespace CarDemo
+{
+	// Parent selection over a population's fitnesses, 'count' floats, one per genome. Every
+	// selector works on the flat array alone and writes genome indexes into 'out', replacing what
+	// was there; 'out' keeps its memory between calls, so selecting allocates nothing once warm.
+	// None of them sorts the population, so each stays cheap for populations in the 100,000s.
+	//
+	// Where two genomes are equally fit the one with the lower index counts as the fitter.
+
+	// The index of the fittest / least fit genome, -1 if there are none. O(n).
+	int SelectBest(const float* fitness, int count);
+	int SelectWorst(const float* fitness, int count);
+
+	// The 'k' fittest genomes, fittest first. Kept in a k sized heap, so O(n log k).
+	void SelectElites(const float* fitness, int count, int k, std::vector<int>& out);
+
+	// 'picks' parents, each the fittest of 'size' genomes drawn at random. O(picks * size).
+	void SelectTournament(const float* fitness, int count, int size, int picks, RandomStream& random,
+						  std::vector<int>& out);
+
+	// 'picks' parents chosen by linear ranking: the chance of a pick falls off in a straight line
+	// from the fittest to the least fit, whatever the fitnesses themselves are. 'pressure' is how
+	// many picks the fittest can expect per genome in the population, from 1 (none, every genome
+	// alike) to 2. Drawn as stochastic binary tournaments, which select with the same linear odds
+	// without ranking anyone first, so O(picks).
+	void SelectRanked(const float* fitness, int count, float pressure, int picks, RandomStream& random,
+					  std::vector<int>& out);
+
+	// 'picks' parents by stochastic universal sampling: fitness proportionate, but one spin of a
+	// wheel with 'picks' evenly spaced pointers, so a genome's picks never stray more than one
+	// from what its share of the fitness is owed. Negative fitnesses count as none; if nobody has
+	// any, everyone is alike. The picks are shuffled so neighbours can be paired. O(n + picks).
+	void SelectStochasticUniversal(const float* fitness, int count, int picks, RandomStream& random,
+								   std::vector<int>& out);
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _SELECTION_H
@@ -0,0 +1,91 @@
+#ifndef _SENSOR_KERNELS_H
+#define _SENSOR_KERNELS_H
+
+//****************************************************************************
+//**
+//**    SensorKernels.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <vector>
+
+#include <Clarity/Math/LineSegment2.h>
+
+#include "LayerKernels.h"
+
+namespace CarDemo
+{
+	// Segment arrays are padded with empty segments up to a multiple of this, so the kernels
+	// never need a tail loop. An empty segment can never be hit.
+	const int SENSOR_SEGMENT_ALIGNMENT = 8;
+
+	// Wall segments laid out one array per component, so a kernel can load several segments into
+	// a vector at once. Vectors and normals are worked out once when a segment is added rather
+	// than through LineSegment2's lazy getters on every test.
+	class SensorSegments
+	{
+	private:
+		std::vector<float> tailX;
+		std::vector<float> tailY;
+		std::vector<float> vectorX;
+		std::vector<float> vectorY;
+		std::vector<float> normalX;
+		std::vector<float> normalY;
+		int count;
+
+		void Pad();
+
+	protected:
+	public:
+		SensorSegments();
+
+		void Clear();
+		void Set(const std::vector<Clarity::LineSegment2> &sections);
+
+		// Replaces the contents with the 'indices' segments of 'source', in that order.
+		void Gather(const SensorSegments& source, const std::vector<int> &indices);
+
+		// Real segments, then GetPaddedCount is the length of every array.
+		int GetCount() const;
+		int GetPaddedCount() const;
+
+		const float* GetTailX() const;
+		const float* GetTailY() const;
+		const float* GetVectorX() const;
+		const float* GetVectorY() const;
+		const float* GetNormalX() const;
+		const float* GetNormalY() const;
+	};
+
+	// Casts 'rays' single sided rays against every segment and writes the distance to the nearest
+	// wall each one hits to depths[r], or 'maxDistance' if nothing is hit within it. The rays are
+	// given as arrays of origins and unit directions and can belong to any number of agents, which
+	// lets a whole batch share one pass over a segment set. Hits match
+	// Clarity::Intersects(segment, true, ray, &distance).
+	typedef void (*RayCastKernel)(const SensorSegments& segments, const float* originX, const float* originY,
+								  const float* directionX, const float* directionY, int rays, float maxDistance, float* depths);
+
+	// Plain C++ version, kept as the reference the SIMD versions are checked against.
+	void CastRaysScalar(const SensorSegments& segments, const float* originX, const float* originY,
+						const float* directionX, const float* directionY, int rays, float maxDistance, float* depths);
+
+	// Four segments at a time per ray with 128 bit vectors.
+	void CastRaysSSE2(const SensorSegments& segments, const float* originX, const float* originY,
+					  const float* directionX, const float* directionY, int rays, float maxDistance, float* depths);
+
+	// Eight segments at a time per ray with 256 bit vectors.
+	void CastRaysAVX2(const SensorSegments& segments, const float* originX, const float* originY,
+					  const float* directionX, const float* directionY, int rays, float maxDistance, float* depths);
+
+	// The kernel for the level picked in LayerKernels, so SetKernelLevel switches both.
+	RayCastKernel GetRayCastKernel();
+	RayCastKernel GetRayCastKernel(KernelLevel level);
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _SENSOR_KERNELS_H
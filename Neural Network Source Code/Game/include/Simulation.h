@@ -0,0 +1,111 @@
+#ifndef _SIMULATION_H
+#define _SIMULATION_H
+
+//****************************************************************************
+//**
+//**    Simulation.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <vector>
+
+#include <Clarity/Math/LineSegment2.h>
+#include <Clarity/Math/Vector2.h>
+
+#include "Agent.h"
+#include "SensorKernels.h"
+
+// Forward Declarations
+namespace CarDemo
+{
+	class NeuralNet;
+	class TrackGeometry;
+};
+
+namespace CarDemo
+{
+	enum CheckpointFlag
+	{
+		Checkpoint_Active,
+		Checkpoint_Inactive,
+	};
+
+	typedef Clarity::LineSegment2 Checkpoint;
+
+	const float CHECK_POINT_BONUS = 15.0f;
+	const float DEFAULT_ROTATION = 90.0f;
+	const Clarity::Vector2 DEFAULT_POSITION(0.0f, -175.0f);
+
+	// The simulation always advances in steps of this size, however fast it is being run or
+	// drawn, so an episode plays out the same everywhere.
+	const float SIMULATION_TIME_STEP = 1.0f / 60.0f;
+
+	// An agent that never crashes would drive forever, so episodes stop after this many
+	// steps, three minutes of driving.
+	const int MAX_EPISODE_STEPS = 60 * 60 * 3;
+
+	// Reads the <Checkpoint> list written by the track editor into 'out'. Returns false if
+	// the file couldn't be opened.
+	bool LoadCheckpoints(const char* filename, std::vector<Checkpoint> &out);
+
+	// One agent driving one episode round a track: sensing, steering, crashing into walls and
+	// scoring distance and checkpoints. There's no rendering, windowing or timing in here, so
+	// it runs headless on any platform, as fast as Step is called. The GF1 game draws it.
+	class Simulation
+	{
+	private:
+		const TrackGeometry* track;
+		const std::vector<Checkpoint>* checkpoints;
+		std::vector<CheckpointFlag> checkpointFlags;
+
+		Agent agent;
+		float fitness;
+		int steps;
+		int maxSteps;
+		bool finished;
+
+		// The checkpoints laid out for the agent's edge test.
+		SensorSegments checkpointSegments;
+
+		// Scratch space reused every step.
+		std::vector<int> candidates;
+		SensorSegments nearbySegments;
+
+		void ScoreCheckpoints();
+
+		Simulation(const Simulation&);
+		Simulation& operator=(const Simulation&);
+
+	protected:
+	public:
+		// 'trackIn' and 'checkpointsIn' are shared, not copied, and must outlive the simulation.
+		// 'maxStepsIn' of 0 lets an episode run until the agent crashes.
+		Simulation(const TrackGeometry& trackIn, const std::vector<Checkpoint>& checkpointsIn,
+				   int maxStepsIn = MAX_EPISODE_STEPS);
+
+		// Starts a new episode with the agent at the start line, driven by 'net'.
+		void Reset(NeuralNet* net);
+
+		// Advances one SIMULATION_TIME_STEP. Returns false once the episode is over.
+		bool Step();
+
+		// Steps until the episode is over and returns the fitness.
+		float Run();
+
+		bool IsFinished() const;
+		float GetFitness() const;
+		int GetSteps() const;
+
+		Agent& GetAgent();
+		const Agent& GetAgent() const;
+		const std::vector<CheckpointFlag>& GetCheckpointFlags() const;
+	};
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _SIMULATION_H
\ No newline at end of file
@@ -0,0 +1,88 @@
+#ifndef _TAG_FILE_READER_H
+#define _TAG_FILE_READER_H
+
+//****************************************************************************
+//**
+//**    TagFileReader.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <stdio.h>
+
+namespace CarDemo
+{
+	// Reads the line based text format shared by exported nets, tracks and checkpoints:
+	//   <Tag>
+	//   Key=Value
+	//   </Tag>
+	// The file is read in large blocks and each line is split in place inside the block, so
+	// reading a line costs no copying and no allocation.
+	//
+	//   TagFileReader reader;
+	//   if (reader.Open(filename))
+	//   {
+	//       while (reader.NextLine())
+	//       {
+	//           if (reader.IsLine("<Segment>")) ...
+	//           else if (reader.IsKey("sX")) x = reader.GetFloat();
+	//       }
+	//   }
+	class TagFileReader
+	{
+	private:
+		FILE* file;
+		char* buffer;
+		int capacity;
+		int start;			// First unread byte in 'buffer'.
+		int end;			// One past the last byte read into 'buffer'.
+		bool endOfFile;
+
+		const char* line;
+		int lineLength;
+		const char* value;	// Just past the '=', or NULL if the line has none.
+		int keyLength;
+
+		bool Refill();
+
+		TagFileReader(const TagFileReader&);
+		TagFileReader& operator=(const TagFileReader&);
+
+	protected:
+	public:
+		static const int BLOCK_SIZE = 64 * 1024;
+
+		TagFileReader();
+		~TagFileReader();
+
+		bool Open(const char* filename);
+		void Close();
+
+		// Moves on to the next line, skipping blank ones. Returns false at the end of the file.
+		bool NextLine();
+
+		// True if the whole current line is 'text', for example "<NLayer>".
+		bool IsLine(const char* text) const;
+
+		// True if the current line is "key=...".
+		bool IsKey(const char* key) const;
+
+		// The current line, without its line ending.
+		const char* GetLine() const;
+
+		// The text after the '=' of a Key=Value line, or "" if there isn't one.
+		const char* GetValue() const;
+		bool ValueIs(const char* text) const;
+
+		// The value as a number. Returns 'fallback' when the value isn't one.
+		float GetFloat(float fallback = 0.0f) const;
+		int GetInt(int fallback = 0) const;
+	};
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _TAG_FILE_READER_H
\ No newline at end of file
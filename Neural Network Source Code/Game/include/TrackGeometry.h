@@ -0,0 +1,103 @@
+#ifndef _TRACK_GEOMETRY_H
+#define _TRACK_GEOMETRY_H
+
+//****************************************************************************
+//**
+//**    TrackGeometry.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <vector>
+
+#include <Clarity/Math/LineSegment2.h>
+#include <Clarity/Math/Vector2.h>
+
+#include "SensorKernels.h"
+
+// Forward Declarations
+namespace Clarity
+{
+	class Circle;
+};
+
+namespace CarDemo
+{
+	class DistanceField;
+};
+
+namespace CarDemo
+{
+	// The walls of a track with nothing to do with drawing or editing them. This is all the
+	// simulation needs, TrackPolygon wraps one for the game and the editor.
+	//
+	// Segments are numbered inner first then outer, so index i < inner.size() is inner[i] and
+	// anything above is outer[i - inner.size()]. A uniform grid over the segments, rebuilt
+	// whenever they change, keeps collision queries from scanning the whole track.
+	class TrackGeometry
+	{
+	private:
+		std::vector<Clarity::LineSegment2> inner;
+		std::vector<Clarity::LineSegment2> outer;
+
+		// The grid. Cell (x, y) holds gridSegments[gridCellStart[c]] up to gridCellStart[c + 1],
+		// where c = y * gridColumns + x. A segment is listed in every cell its bounding box touches.
+		Clarity::Vector2 gridOrigin;
+		float gridCellSize;
+		int gridColumns;
+		int gridRows;
+		std::vector<int> gridCellStart;
+		std::vector<int> gridSegments;
+
+		// Every segment again in the layout the sensor kernels want, same numbering.
+		SensorSegments sensorSegments;
+
+		// Optional, not owned. Forgotten whenever the walls change.
+		const DistanceField* distanceField;
+
+		void BuildGrid();
+
+	protected:
+	public:
+		TrackGeometry();
+
+		// Reads the <PolyInner> / <PolyOuter> segment lists written by TrackPolygon::ExportPolygon.
+		// Returns false if the file couldn't be opened.
+		bool Load(const char* filename);
+
+		void Clear();
+		void SetSections(const std::vector<Clarity::LineSegment2> &innerIn, const std::vector<Clarity::LineSegment2> &outerIn);
+
+		const std::vector<Clarity::LineSegment2>& GetInnerSections() const;
+		const std::vector<Clarity::LineSegment2>& GetOuterSections() const;
+
+		int GetTotalSections() const;
+		const Clarity::LineSegment2& GetSection(int index) const;
+		const SensorSegments& GetSensorSegments() const;
+
+		// With a distance field set the simulation senses and collides through it instead of
+		// the segments. It must have been built from these walls and must outlive its use here.
+		void SetDistanceField(const DistanceField* field);
+		const DistanceField* GetDistanceField() const;
+
+		// Replaces the contents of 'out' with the indices of every segment that might pass through
+		// 'circle', in ascending order. Only the grid cells under the circle are looked at, so the
+		// cost doesn't grow with the size of the track. Candidates still need an exact test.
+		void QueryCandidates(const Clarity::Circle& circle, std::vector<int> &out) const;
+
+		// Appends every wall segment that passes through 'circle' to 'out', inner walls first. The
+		// indices of the inner and outer segments found are appended to 'innerHits' and
+		// 'outerHits' if given. 'candidates' is scratch space for QueryCandidates, pass one in to
+		// avoid allocating on every call. It is left holding the candidates found.
+		void QueryPossibleCollisions(const Clarity::Circle& circle, std::vector<Clarity::LineSegment2> &out,
+									 std::vector<int>* innerHits = NULL, std::vector<int>* outerHits = NULL,
+									 std::vector<int>* candidates = NULL) const;
+	};
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _TRACK_GEOMETRY_H
\ No newline at end of file
@@ -18,6 +18,8 @@
 #include <Clarity/Math/Vector2.h>
 #include <Clarity/Math/LineSegment2.h>
 
+#include "TrackGeometry.h"
+
 // Forward Declarations
 namespace GF1
 {
@@ -62,6 +64,9 @@ namespace CarDemo
 	private:
 		std::vector<PolySection> polygonInner;
 		std::vector<PolySection> polygonOuter;
+
+		// The walls as the simulation sees them, rebuilt on load and whenever a polygon is closed.
+		TrackGeometry geometry;
 		std::vector<GF1::Vector3> pointsInner;
 		std::vector<GF1::Vector3> pointsOuter;
 
@@ -83,6 +88,7 @@ namespace CarDemo
 
 		//
 		void BuildSection(Clarity::Vector2 start, Clarity::Vector2 end);
+		void RebuildGeometry();
 	protected:
 	public:
 		TrackPolygon();
@@ -97,7 +103,9 @@ namespace CarDemo
 
 	
 		// Game functions.
+		// Also highlights the segments found, see DrawIntersectingPolySections.
 		void QueryPossibleCollisions(const Clarity::Circle& circle, std::vector<Clarity::LineSegment2> &out);
+		const TrackGeometry& GetGeometry() const;
 		void GetPolySections(std::vector<Clarity::LineSegment2> &polyInner, std::vector<Clarity::LineSegment2> &polyOuter);
 		
 		// Editor functions.
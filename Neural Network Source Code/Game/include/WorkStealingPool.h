@@ -0,0 +1,76 @@
+#ifndef _WORK_STEALING_POOL_H
+#define _WORK_STEALING_POOL_H
+
+//****************************************************************************
+//**
+//**    WorkStealingPool.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+namespace CarDemo
+{
+	// A fixed set of worker threads that run numbered tasks. Each worker starts with its own
+	// contiguous run of tasks and takes them from the back of its queue. A worker that runs
+	// dry steals from the front of another worker's queue, so one long episode doesn't hold
+	// up the tasks queued behind it.
+	// The thread calling Run works as worker 0, and Run only returns once every task is done.
+	class WorkStealingPool
+	{
+	public:
+		// 'task' is the task number, 'worker' is 0 to GetThreadCount() - 1 and identifies the
+		// thread running it, for picking per thread scratch state.
+		typedef std::function<void(int task, int worker)> TaskFunction;
+
+	private:
+		struct WorkerQueue
+		{
+			std::mutex lock;
+			std::deque<int> tasks;
+		};
+
+		std::vector<std::thread> threads;
+		std::vector<WorkerQueue*> queues;
+
+		std::mutex lock;
+		std::condition_variable wake;
+		std::condition_variable finished;
+		const TaskFunction* function;
+		int generation;
+		bool quitting;
+		std::atomic<int> remaining;
+
+		bool TakeTask(int worker, int &task);
+		void RunTasks(int worker);
+		void WorkerLoop(int worker);
+
+		WorkStealingPool(const WorkStealingPool&);
+		WorkStealingPool& operator=(const WorkStealingPool&);
+
+	protected:
+	public:
+		// 'threadCount' includes the calling thread. 0 uses one thread per hardware thread.
+		explicit WorkStealingPool(int threadCount = 0);
+		~WorkStealingPool();
+
+		int GetThreadCount() const;
+
+		// Runs 'func' for every task from 0 to taskCount - 1 and waits for them all.
+		void Run(int taskCount, const TaskFunction& func);
+	};
+
+}; // End namespace CarDemo.
+
+#endif // #ifndef _WORK_STEALING_POOL_H
\ No newline at end of file
@@ -0,0 +1,388 @@
+//****************************************************************************
+//**
+//**    Activation.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <atomic>
+#include <cmath>
+#include <string.h>
+
+#include "Activation.h"
+
+#if defined(CARDEMO_X86)
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+	// Set from the main thread, read by every pool worker's nets, so it's atomic like the kernel level.
+	static std::atomic<int> gActivationMode(ACTIVATION_APPROX);
+
+	// ----------------------------------------------------------------------
+	// Lookup table covering [-TABLE_RANGE, TABLE_RANGE].
+	// ----------------------------------------------------------------------
+	const int TABLE_SIZE = 4096;
+	const float TABLE_RANGE = 16.0f;
+	const float TABLE_SCALE = TABLE_SIZE / (2.0f * TABLE_RANGE);
+
+	// TABLE_SIZE + 2 entries so interpolating from the last segment never reads past the end.
+	static float gSigmoidTable[TABLE_SIZE + 2];
+
+	static bool BuildSigmoidTable()
+	{
+		for (int i = 0; i < TABLE_SIZE + 2; i++)
+		{
+			const double a = (double)i / TABLE_SCALE - TABLE_RANGE;
+			gSigmoidTable[i] = (float)(1.0 / (1.0 + exp(-a)));
+		}
+		return true;
+	}
+
+	// Built during static initialisation, before any net can be evaluated.
+	static const bool gSigmoidTableBuilt = BuildSigmoidTable();
+
+	float SigmoidTable(float a)
+	{
+		float t = (a + TABLE_RANGE) * TABLE_SCALE;
+		t = t < 0.0f ? 0.0f : t;
+		t = t > (float)TABLE_SIZE ? (float)TABLE_SIZE : t;
+
+		const int i = (int)t;
+		const float frac = t - (float)i;
+		return gSigmoidTable[i] + frac * (gSigmoidTable[i + 1] - gSigmoidTable[i]);
+	}
+
+	void SigmoidExactBulk(float* values, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			values[i] = SigmoidExact(values[i]);
+		}
+	}
+
+	void SigmoidApproxBulkScalar(float* values, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			values[i] = SigmoidApprox(values[i]);
+		}
+	}
+
+	void SigmoidTableBulkScalar(float* values, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			values[i] = SigmoidTable(values[i]);
+		}
+	}
+
+#if defined(CARDEMO_X86)
+
+	KERNEL_TARGET_SSE2
+	void SigmoidApproxBulkSSE2(float* values, int count)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		int i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			// e^-a
+			__m128 x = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(values + i));
+			x = _mm_min_ps(x, _mm_set1_ps(EXP_HIGH));
+			x = _mm_max_ps(x, _mm_set1_ps(EXP_LOW));
+
+			// floor(x * log2(e) + 0.5), SSE2 only truncates so step down where that rounded up.
+			__m128 fx = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(LOG2_E)), _mm_set1_ps(0.5f));
+			__m128i n = _mm_cvttps_epi32(fx);
+			__m128 nf = _mm_cvtepi32_ps(n);
+			const __m128 roundedUp = _mm_cmpgt_ps(nf, fx);
+			nf = _mm_sub_ps(nf, _mm_and_ps(roundedUp, one));
+			n = _mm_cvttps_epi32(nf);
+
+			x = _mm_sub_ps(x, _mm_mul_ps(nf, _mm_set1_ps(LN2_HIGH)));
+			x = _mm_sub_ps(x, _mm_mul_ps(nf, _mm_set1_ps(LN2_LOW)));
+
+			__m128 y = _mm_set1_ps(EXP_P0);
+			y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P1));
+			y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P2));
+			y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P3));
+			y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P4));
+			y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P5));
+			y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(y, x), x), x), one);
+
+			const __m128i pow2n = _mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23);
+			y = _mm_mul_ps(y, _mm_castsi128_ps(pow2n));
+
+			// 1 / (1 + e^-a)
+			_mm_storeu_ps(values + i, _mm_div_ps(one, _mm_add_ps(one, y)));
+		}
+
+		SigmoidApproxBulkScalar(values + i, count - i);
+	}
+
+	KERNEL_TARGET_AVX2
+	void SigmoidApproxBulkAVX2(float* values, int count)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		int i = 0;
+
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 x = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(values + i));
+			x = _mm256_min_ps(x, _mm256_set1_ps(EXP_HIGH));
+			x = _mm256_max_ps(x, _mm256_set1_ps(EXP_LOW));
+
+			const __m256 nf = _mm256_floor_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(LOG2_E)), _mm256_set1_ps(0.5f)));
+			const __m256i n = _mm256_cvttps_epi32(nf);
+
+			x = _mm256_sub_ps(x, _mm256_mul_ps(nf, _mm256_set1_ps(LN2_HIGH)));
+			x = _mm256_sub_ps(x, _mm256_mul_ps(nf, _mm256_set1_ps(LN2_LOW)));
+
+			__m256 y = _mm256_set1_ps(EXP_P0);
+			y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(EXP_P1));
+			y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(EXP_P2));
+			y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(EXP_P3));
+			y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(EXP_P4));
+			y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(EXP_P5));
+			y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(y, x), x), x), one);
+
+			const __m256i pow2n = _mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23);
+			y = _mm256_mul_ps(y, _mm256_castsi256_ps(pow2n));
+
+			_mm256_storeu_ps(values + i, _mm256_div_ps(one, _mm256_add_ps(one, y)));
+		}
+
+		SigmoidApproxBulkScalar(values + i, count - i);
+	}
+
+	KERNEL_TARGET_SSE2
+	void SigmoidTableBulkSSE2(float* values, int count)
+	{
+		int i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 t = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(values + i), _mm_set1_ps(TABLE_RANGE)), _mm_set1_ps(TABLE_SCALE));
+			t = _mm_max_ps(t, _mm_setzero_ps());
+			t = _mm_min_ps(t, _mm_set1_ps((float)TABLE_SIZE));
+
+			const __m128i index = _mm_cvttps_epi32(t);
+			const __m128 frac = _mm_sub_ps(t, _mm_cvtepi32_ps(index));
+
+			// No gather in SSE2, the index maths is vectorised and the four loads are not.
+			int lanes[4];
+			_mm_storeu_si128((__m128i*)lanes, index);
+			const __m128 low = _mm_set_ps(gSigmoidTable[lanes[3]], gSigmoidTable[lanes[2]],
+										  gSigmoidTable[lanes[1]], gSigmoidTable[lanes[0]]);
+			const __m128 high = _mm_set_ps(gSigmoidTable[lanes[3] + 1], gSigmoidTable[lanes[2] + 1],
+										   gSigmoidTable[lanes[1] + 1], gSigmoidTable[lanes[0] + 1]);
+
+			_mm_storeu_ps(values + i, _mm_add_ps(low, _mm_mul_ps(frac, _mm_sub_ps(high, low))));
+		}
+
+		SigmoidTableBulkScalar(values + i, count - i);
+	}
+
+	KERNEL_TARGET_AVX2
+	void SigmoidTableBulkAVX2(float* values, int count)
+	{
+		int i = 0;
+
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(values + i), _mm256_set1_ps(TABLE_RANGE)), _mm256_set1_ps(TABLE_SCALE));
+			t = _mm256_max_ps(t, _mm256_setzero_ps());
+			t = _mm256_min_ps(t, _mm256_set1_ps((float)TABLE_SIZE));
+
+			const __m256i index = _mm256_cvttps_epi32(t);
+			const __m256 frac = _mm256_sub_ps(t, _mm256_cvtepi32_ps(index));
+
+			const __m256 low = _mm256_i32gather_ps(gSigmoidTable, index, 4);
+			const __m256 high = _mm256_i32gather_ps(gSigmoidTable + 1, index, 4);
+
+			_mm256_storeu_ps(values + i, _mm256_add_ps(low, _mm256_mul_ps(frac, _mm256_sub_ps(high, low))));
+		}
+
+		SigmoidTableBulkScalar(values + i, count - i);
+	}
+
+#else
+
+	void SigmoidApproxBulkSSE2(float* values, int count)
+	{
+		SigmoidApproxBulkScalar(values, count);
+	}
+
+	void SigmoidApproxBulkAVX2(float* values, int count)
+	{
+		SigmoidApproxBulkScalar(values, count);
+	}
+
+	void SigmoidTableBulkSSE2(float* values, int count)
+	{
+		SigmoidTableBulkScalar(values, count);
+	}
+
+	void SigmoidTableBulkAVX2(float* values, int count)
+	{
+		SigmoidTableBulkScalar(values, count);
+	}
+
+#endif // #if defined(CARDEMO_X86)
+
+	void SetActivationMode(ActivationMode mode)
+	{
+		gActivationMode.store(mode, std::memory_order_relaxed);
+	}
+
+	ActivationMode GetActivationMode()
+	{
+		return (ActivationMode)gActivationMode.load(std::memory_order_relaxed);
+	}
+
+	void ApplySigmoid(float* values, int count, ActivationMode mode, KernelLevel level)
+	{
+		switch (mode)
+		{
+		case ACTIVATION_APPROX:
+			switch (level)
+			{
+			case KERNEL_AVX2:
+				SigmoidApproxBulkAVX2(values, count);
+				break;
+			case KERNEL_SSE2:
+				SigmoidApproxBulkSSE2(values, count);
+				break;
+			default:
+				SigmoidApproxBulkScalar(values, count);
+				break;
+			};
+			break;
+		case ACTIVATION_TABLE:
+			switch (level)
+			{
+			case KERNEL_AVX2:
+				SigmoidTableBulkAVX2(values, count);
+				break;
+			case KERNEL_SSE2:
+				SigmoidTableBulkSSE2(values, count);
+				break;
+			default:
+				SigmoidTableBulkScalar(values, count);
+				break;
+			};
+			break;
+		default:
+			SigmoidExactBulk(values, count);
+			break;
+		};
+	}
+
+	void ApplySigmoid(float* values, int count)
+	{
+		ApplySigmoid(values, count, GetActivationMode(), GetKernelLevel());
+	}
+
+	void ApplyBiPolarSigmoid(float* values, int count)
+	{
+		ApplySigmoid(values, count);
+
+		// 2 * sigmoid(a) - 1 is the same curve as the bipolar sigmoid.
+		for (int i = 0; i < count; i++)
+		{
+			values[i] = 2.0f * values[i] - 1.0f;
+		}
+	}
+
+	void ApplyStep(float* values, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			values[i] = values[i] > 0.0f ? 1.0f : 0.0f;
+		}
+	}
+
+	void ApplyReLU(float* values, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			values[i] = values[i] > 0.0f ? values[i] : 0.0f;
+		}
+	}
+
+	void ApplyTanh(float* values, int count)
+	{
+		// tanh(a) = 2 * sigmoid(2a) - 1, so it rides on the fast sigmoid.
+		for (int i = 0; i < count; i++)
+		{
+			values[i] *= 2.0f;
+		}
+		ApplyBiPolarSigmoid(values, count);
+	}
+
+	void ApplyActivation(EvalFunction function, float* values, int count)
+	{
+		switch (function)
+		{
+		case EVAL_STEP:
+			ApplyActivation<EVAL_STEP>(values, count);
+			break;
+		case EVAL_BIPOLAR:
+			ApplyActivation<EVAL_BIPOLAR>(values, count);
+			break;
+		case EVAL_RELU:
+			ApplyActivation<EVAL_RELU>(values, count);
+			break;
+		case EVAL_TANH:
+			ApplyActivation<EVAL_TANH>(values, count);
+			break;
+		case EVAL_LINEAR:
+			ApplyActivation<EVAL_LINEAR>(values, count);
+			break;
+		default:
+			ApplyActivation<EVAL_SIGMOID>(values, count);
+			break;
+		};
+	}
+
+	static const char* gEvalFunctionNames[EVAL_FUNCTION_COUNT] =
+	{
+		"Sigmoid",
+		"Step",
+		"BiPolar",
+		"ReLU",
+		"Tanh",
+		"Linear",
+	};
+
+	const char* GetEvalFunctionName(EvalFunction function)
+	{
+		if (function < 0 || function >= EVAL_FUNCTION_COUNT)
+			return gEvalFunctionNames[EVAL_SIGMOID];
+
+		return gEvalFunctionNames[function];
+	}
+
+	EvalFunction ParseEvalFunction(const char* name)
+	{
+		if (name != NULL)
+		{
+			for (int i = 0; i < EVAL_FUNCTION_COUNT; i++)
+			{
+				if (0 == strcmp(name, gEvalFunctionNames[i]))
+					return (EvalFunction)i;
+			}
+		}
+		return EVAL_SIGMOID;
+	}
+
+}; // End namespace CarDemo.
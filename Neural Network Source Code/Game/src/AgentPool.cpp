@@ -0,0 +1,631 @@
+//****************************************************************************
+//**
+//**    AgentPool.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+#include "AgentPool.h"
+
+#include <Clarity/Math/Math.h>
+
+#include "BatchedNeuralNet.h"
+#include "DistanceField.h"
+#include "GameGlobals.h"
+#include "Simulation.h"
+#include "TrackGeometry.h"
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+	// Feeler angles from the heading, in SensorFeelers order.
+	static const float FEELER_THETAS[FEELER_COUNT] = { EAST_THETA, NORTH_EAST_THETA, NORTH_THETA, NORTH_WEST_THETA, WEST_THETA };
+
+	// The body corners relative to the centre of an unrotated car, in AgentBoundsCorners order.
+	static const float CORNER_LOCAL_X[CORNER_COUNT] = { -AGENT_WIDTH / 2, AGENT_WIDTH / 2, AGENT_WIDTH / 2, -AGENT_WIDTH / 2 };
+	static const float CORNER_LOCAL_Y[CORNER_COUNT] = { AGENT_HEIGHT / 2, AGENT_HEIGHT / 2, -AGENT_HEIGHT / 2, -AGENT_HEIGHT / 2 };
+
+	// The edges of the body as corner pairs: left, right, top and bottom.
+	static const int EDGE_COUNT = 4;
+	static const int EDGE_TAIL[EDGE_COUNT] = { CORNER_TOP_LEFT, CORNER_TOP_RIGHT, CORNER_TOP_LEFT, CORNER_BOTTOM_RIGHT };
+	static const int EDGE_HEAD[EDGE_COUNT] = { CORNER_BOTTOM_LEFT, CORNER_BOTTOM_RIGHT, CORNER_TOP_RIGHT, CORNER_BOTTOM_LEFT };
+
+	// Returns 1 if the edge from (px, py) along (ex, ey) crosses segment 'j', the same as casting a
+	// double sided ray along the edge and keeping hits closer than its length. Flipping the signs
+	// to make the denominator positive lets 0 <= s < 1 and 0 <= t <= 1 be tested without dividing,
+	// and the '&'s keep it free of branches so loops over it vectorize.
+	inline int EdgeCrosses(float px, float py, float ex, float ey,
+						   const float* tx, const float* ty, const float* vx, const float* vy, int j)
+	{
+		const float denominator = vy[j] * ex - vx[j] * ey;
+		const float sign = denominator < 0.0f ? -1.0f : 1.0f;
+		const float ox = tx[j] - px;
+		const float oy = ty[j] - py;
+		const float d = denominator * sign;
+		const float s = (vy[j] * ox - vx[j] * oy) * sign;
+		const float t = (ey * ox - ex * oy) * sign;
+		return (d > 0.0f) & (s >= 0.0f) & (s < d) & (t >= 0.0f) & (t <= d);
+	}
+
+	AgentPool::AgentPool(int countIn)
+		: count(0)
+		, checkpointCount(0)
+	{
+		Resize(countIn);
+	}
+
+	void AgentPool::Resize(int countIn)
+	{
+		count = countIn;
+
+		positionX.assign(count, 0.0f);
+		positionY.assign(count, 0.0f);
+		heading.assign(count, 0.0f);
+		headingSin.assign(count, 0.0f);
+		headingCos.assign(count, 1.0f);
+
+		feelerX.assign(FEELER_COUNT * count, 0.0f);
+		feelerY.assign(FEELER_COUNT * count, 0.0f);
+		feelerEndX.assign(FEELER_COUNT * count, 0.0f);
+		feelerEndY.assign(FEELER_COUNT * count, 0.0f);
+		depths.assign(FEELER_COUNT * count, FEELER_LENGTH);
+
+		cornerX.assign(CORNER_COUNT * count, 0.0f);
+		cornerY.assign(CORNER_COUNT * count, 0.0f);
+
+		distanceDelta.assign(count, 0.0f);
+		fitness.assign(count, 0.0f);
+		failed.assign(count, 0);
+
+		checkpointsHit.assign(checkpointCount * count, 0);
+
+		BuildFeelers();
+		BuildBounds();
+	}
+
+	int AgentPool::GetCount() const
+	{
+		return count;
+	}
+
+	void AgentPool::Reset(int agent, const Clarity::Vector2& position, float rotation)
+	{
+		positionX[agent] = position.x;
+		positionY[agent] = position.y;
+		heading[agent] = rotation;
+		RefreshHeading(agent);
+
+		for (int f = 0; f < FEELER_COUNT; f++)
+		{
+			depths[f * count + agent] = FEELER_LENGTH;
+		}
+
+		distanceDelta[agent] = 0.0f;
+		fitness[agent] = 0.0f;
+		failed[agent] = 0;
+		if (checkpointCount > 0)
+		{
+			memset(&checkpointsHit[agent * checkpointCount], 0, checkpointCount);
+		}
+
+		BuildFeelers(agent, agent + 1);
+		BuildBounds(agent, agent + 1);
+	}
+
+	void AgentPool::ResetAll(const Clarity::Vector2& position, float rotation)
+	{
+		for (int a = 0; a < count; a++)
+		{
+			positionX[a] = position.x;
+			positionY[a] = position.y;
+			heading[a] = rotation;
+			RefreshHeading(a);
+		}
+
+		std::fill(depths.begin(), depths.end(), FEELER_LENGTH);
+		std::fill(distanceDelta.begin(), distanceDelta.end(), 0.0f);
+		std::fill(fitness.begin(), fitness.end(), 0.0f);
+		std::fill(failed.begin(), failed.end(), 0);
+		std::fill(checkpointsHit.begin(), checkpointsHit.end(), 0);
+
+		BuildFeelers();
+		BuildBounds();
+	}
+
+	void AgentPool::RefreshHeading(int agent)
+	{
+		headingSin[agent] = std::sin(Clarity::RADIANS_PER_DEGREE * heading[agent]);
+		headingCos[agent] = std::cos(Clarity::RADIANS_PER_DEGREE * heading[agent]);
+	}
+
+	void AgentPool::BuildFeelers()
+	{
+		BuildFeelers(0, count);
+	}
+
+	void AgentPool::BuildFeelers(int first, int end)
+	{
+		// Through locals so the compiler knows the stores below can't move the arrays.
+		const float* sine = headingSin.data();
+		const float* cosine = headingCos.data();
+		const float* x = positionX.data();
+		const float* y = positionY.data();
+
+		for (int f = 0; f < FEELER_COUNT; f++)
+		{
+			const float thetaSin = std::sin(Clarity::RADIANS_PER_DEGREE * FEELER_THETAS[f]);
+			const float thetaCos = std::cos(Clarity::RADIANS_PER_DEGREE * FEELER_THETAS[f]);
+
+			float* dirX = &feelerX[f * count];
+			float* dirY = &feelerY[f * count];
+			float* endX = &feelerEndX[f * count];
+			float* endY = &feelerEndY[f * count];
+
+			// The heading turned by the feeler's angle, (0, 1) rotated by heading + theta. Few
+			// arrays per loop keeps the compiler's aliasing checks cheap enough to vectorize.
+			for (int a = first; a < end; a++)
+			{
+				dirX[a] = -(sine[a] * thetaCos + cosine[a] * thetaSin);
+				dirY[a] = cosine[a] * thetaCos - sine[a] * thetaSin;
+			}
+			for (int a = first; a < end; a++)
+			{
+				endX[a] = x[a] + dirX[a] * FEELER_LENGTH;
+			}
+			for (int a = first; a < end; a++)
+			{
+				endY[a] = y[a] + dirY[a] * FEELER_LENGTH;
+			}
+		}
+	}
+
+	void AgentPool::BuildBounds()
+	{
+		BuildBounds(0, count);
+	}
+
+	void AgentPool::BuildBounds(int first, int end)
+	{
+		for (int c = 0; c < CORNER_COUNT; c++)
+		{
+			const float localX = CORNER_LOCAL_X[c];
+			const float localY = CORNER_LOCAL_Y[c];
+			float* outX = &cornerX[c * count];
+			float* outY = &cornerY[c * count];
+
+			for (int a = first; a < end; a++)
+			{
+				outX[a] = localX * headingCos[a] - localY * headingSin[a] + positionX[a];
+				outY[a] = localX * headingSin[a] + localY * headingCos[a] + positionY[a];
+			}
+		}
+	}
+
+	void AgentPool::UpdateSensors(const TrackGeometry& track)
+	{
+		for (int a = 0; a < count; a++)
+		{
+			if (failed[a])
+				continue;
+
+			track.QueryCandidates(GetSensorBounds(a), candidates);
+			nearbySegments.Gather(track.GetSensorSegments(), candidates);
+			UpdateSensors(a, nearbySegments);
+		}
+	}
+
+	void AgentPool::UpdateSensors(int agent, const SensorSegments& segments)
+	{
+		float originX[FEELER_COUNT];
+		float originY[FEELER_COUNT];
+		float directionX[FEELER_COUNT];
+		float directionY[FEELER_COUNT];
+		float nearest[FEELER_COUNT];
+		for (int f = 0; f < FEELER_COUNT; f++)
+		{
+			originX[f] = positionX[agent];
+			originY[f] = positionY[agent];
+			directionX[f] = feelerX[f * count + agent];
+			directionY[f] = feelerY[f * count + agent];
+		}
+
+		// Feelers that touch nothing are left at FEELER_LENGTH.
+		GetRayCastKernel()(segments, originX, originY, directionX, directionY, FEELER_COUNT, FEELER_LENGTH, nearest);
+
+		for (int f = 0; f < FEELER_COUNT; f++)
+		{
+			depths[f * count + agent] = nearest[f];
+		}
+	}
+
+	void AgentPool::UpdateSensors(const DistanceField& field)
+	{
+		for (int a = 0; a < count; a++)
+		{
+			if (failed[a])
+				continue;
+
+			UpdateSensors(a, field);
+		}
+	}
+
+	void AgentPool::UpdateSensors(int agent, const DistanceField& field)
+	{
+		for (int f = 0; f < FEELER_COUNT; f++)
+		{
+			depths[f * count + agent] = field.Trace(positionX[agent], positionY[agent], feelerX[f * count + agent],
+													feelerY[f * count + agent], FEELER_LENGTH);
+		}
+	}
+
+	int AgentPool::CheckForCollision(const TrackGeometry& track)
+	{
+		int crashed = 0;
+		for (int a = 0; a < count; a++)
+		{
+			if (failed[a])
+				continue;
+
+			track.QueryCandidates(GetSensorBounds(a), candidates);
+			nearbySegments.Gather(track.GetSensorSegments(), candidates);
+			if (CheckForCollision(a, nearbySegments))
+			{
+				crashed++;
+			}
+		}
+		return crashed;
+	}
+
+	bool AgentPool::CheckForCollision(int agent, const SensorSegments& segments)
+	{
+		const int total = segments.GetPaddedCount();
+		const float* tx = segments.GetTailX();
+		const float* ty = segments.GetTailY();
+		const float* vx = segments.GetVectorX();
+		const float* vy = segments.GetVectorY();
+
+		// Padding has a zero vector, so its denominator is zero and it never crosses.
+		int hits = 0;
+		for (int e = 0; e < EDGE_COUNT; e++)
+		{
+			const float px = cornerX[EDGE_TAIL[e] * count + agent];
+			const float py = cornerY[EDGE_TAIL[e] * count + agent];
+			const float ex = cornerX[EDGE_HEAD[e] * count + agent] - px;
+			const float ey = cornerY[EDGE_HEAD[e] * count + agent] - py;
+
+			for (int j = 0; j < total; j++)
+			{
+				hits |= EdgeCrosses(px, py, ex, ey, tx, ty, vx, vy, j);
+			}
+		}
+
+		if (hits != 0)
+		{
+			failed[agent] = 1;
+		}
+		return hits != 0;
+	}
+
+	int AgentPool::CheckForCollision(const DistanceField& field)
+	{
+		int crashed = 0;
+		for (int a = 0; a < count; a++)
+		{
+			if (failed[a])
+				continue;
+
+			if (CheckForCollision(a, field))
+			{
+				crashed++;
+			}
+		}
+		return crashed;
+	}
+
+	bool AgentPool::CheckForCollision(int agent, const DistanceField& field)
+	{
+		// The corners, then the middle of each edge.
+		float x[CORNER_COUNT + EDGE_COUNT];
+		float y[CORNER_COUNT + EDGE_COUNT];
+		for (int c = 0; c < CORNER_COUNT; c++)
+		{
+			x[c] = cornerX[c * count + agent];
+			y[c] = cornerY[c * count + agent];
+		}
+		for (int e = 0; e < EDGE_COUNT; e++)
+		{
+			x[CORNER_COUNT + e] = (x[EDGE_TAIL[e]] + x[EDGE_HEAD[e]]) * 0.5f;
+			y[CORNER_COUNT + e] = (y[EDGE_TAIL[e]] + y[EDGE_HEAD[e]]) * 0.5f;
+		}
+
+		if (field.Overlaps(x, y, CORNER_COUNT + EDGE_COUNT))
+		{
+			failed[agent] = 1;
+			return true;
+		}
+		return false;
+	}
+
+	bool AgentPool::CrossesSegment(int agent, const SensorSegments& segments, int index) const
+	{
+		const float* tx = segments.GetTailX();
+		const float* ty = segments.GetTailY();
+		const float* vx = segments.GetVectorX();
+		const float* vy = segments.GetVectorY();
+
+		int crosses = 0;
+		for (int e = 0; e < EDGE_COUNT; e++)
+		{
+			const float px = cornerX[EDGE_TAIL[e] * count + agent];
+			const float py = cornerY[EDGE_TAIL[e] * count + agent];
+			const float ex = cornerX[EDGE_HEAD[e] * count + agent] - px;
+			const float ey = cornerY[EDGE_HEAD[e] * count + agent] - py;
+			crosses |= EdgeCrosses(px, py, ex, ey, tx, ty, vx, vy, index);
+		}
+		return crosses != 0;
+	}
+
+	void AgentPool::GetInputs(float* out) const
+	{
+		for (int f = 0; f < FEELER_COUNT; f++)
+		{
+			const float* row = &depths[f * count];
+			for (int a = 0; a < count; a++)
+			{
+				out[a * FEELER_COUNT + f] = 1 - row[a] / FEELER_LENGTH;
+			}
+		}
+	}
+
+	void AgentPool::Update(const float* outputsIn, float t)
+	{
+		Drive(outputsIn, t, 0, count);
+	}
+
+	void AgentPool::Drive(const float* outputsIn, float t, int first, int end)
+	{
+		for (int a = first; a < end; a++)
+		{
+			const float leftForce = outputsIn[a * NN_OUTPUT_COUNT + NN_OUTPUT_LEFT_FORCE];
+			const float rightForce = outputsIn[a * NN_OUTPUT_COUNT + NN_OUTPUT_RIGHT_FORCE];
+
+			// Crashed agents stay where they are.
+			const float running = failed[a] ? 0.0f : 1.0f;
+
+			// Convert the outputs to a proportion of how much to turn.
+			const float leftTheta = MAX_ROTATION_PER_SECOND * leftForce;
+			const float rightTheta = MAX_ROTATION_PER_SECOND * rightForce;
+			heading[a] += (leftTheta - rightTheta) * t * running;
+
+			const float speed = std::min(std::max(std::fabs(leftForce + rightForce) / 2 * SPEED, -SPEED), SPEED);
+			distanceDelta[a] = speed * t * running;
+		}
+
+		// Kept in a loop of its own so the compiler can use a vector sin/cos.
+		for (int a = first; a < end; a++)
+		{
+			headingSin[a] = std::sin(Clarity::RADIANS_PER_DEGREE * heading[a]);
+			headingCos[a] = std::cos(Clarity::RADIANS_PER_DEGREE * heading[a]);
+		}
+
+		float* x = positionX.data();
+		float* y = positionY.data();
+		float* score = fitness.data();
+		const float* sine = headingSin.data();
+		const float* cosine = headingCos.data();
+		const float* delta = distanceDelta.data();
+		for (int a = first; a < end; a++)
+		{
+			x[a] -= sine[a] * delta[a];
+		}
+		for (int a = first; a < end; a++)
+		{
+			y[a] += cosine[a] * delta[a];
+		}
+		for (int a = first; a < end; a++)
+		{
+			score[a] += delta[a] / 2.0f;
+		}
+
+		BuildFeelers(first, end);
+		BuildBounds(first, end);
+	}
+
+	void AgentPool::ScoreCheckpoints(const SensorSegments& checkpoints)
+	{
+		if (checkpointCount != checkpoints.GetCount())
+		{
+			checkpointCount = checkpoints.GetCount();
+			checkpointsHit.assign(checkpointCount * count, 0);
+		}
+
+		const float* tx = checkpoints.GetTailX();
+		const float* ty = checkpoints.GetTailY();
+		const float* vx = checkpoints.GetVectorX();
+		const float* vy = checkpoints.GetVectorY();
+
+		for (int a = 0; a < count; a++)
+		{
+			if (failed[a])
+				continue;
+
+			float px[EDGE_COUNT];
+			float py[EDGE_COUNT];
+			float ex[EDGE_COUNT];
+			float ey[EDGE_COUNT];
+			for (int e = 0; e < EDGE_COUNT; e++)
+			{
+				px[e] = cornerX[EDGE_TAIL[e] * count + a];
+				py[e] = cornerY[EDGE_TAIL[e] * count + a];
+				ex[e] = cornerX[EDGE_HEAD[e] * count + a] - px[e];
+				ey[e] = cornerY[EDGE_HEAD[e] * count + a] - py[e];
+			}
+
+			// Every checkpoint is tested, the hit flags only decide whether a crossing scores.
+			unsigned char* hit = &checkpointsHit[a * checkpointCount];
+			float bonus = 0.0f;
+			for (int i = 0; i < checkpointCount; i++)
+			{
+				int crosses = 0;
+				for (int e = 0; e < EDGE_COUNT; e++)
+				{
+					crosses |= EdgeCrosses(px[e], py[e], ex[e], ey[e], tx, ty, vx, vy, i);
+				}
+
+				const int fresh = crosses & (hit[i] == 0);
+				bonus += CHECK_POINT_BONUS * fresh;
+				hit[i] |= fresh;
+			}
+			fitness[a] += bonus;
+		}
+	}
+
+	int AgentPool::Step(const TrackGeometry& track, const SensorSegments& checkpoints, BatchedNeuralNet& net, float t)
+	{
+		// Sense and crash in one pass so each agent only asks the grid once, noting who is left.
+		const DistanceField* field = track.GetDistanceField();
+		running.clear();
+		for (int a = 0; a < count; a++)
+		{
+			if (failed[a])
+				continue;
+
+			if (field != NULL)
+			{
+				UpdateSensors(a, *field);
+				if (!CheckForCollision(a, *field))
+				{
+					running.push_back(a);
+				}
+				continue;
+			}
+
+			track.QueryCandidates(GetSensorBounds(a), candidates);
+			nearbySegments.Gather(track.GetSensorSegments(), candidates);
+			UpdateSensors(a, nearbySegments);
+			if (!CheckForCollision(a, nearbySegments))
+			{
+				running.push_back(a);
+			}
+		}
+
+		// Only the agents still driving go through the net. Late in an episode that is usually
+		// a handful out of the whole population.
+		const int total = (int)running.size();
+		inputs.resize(total * FEELER_COUNT);
+		batchOutputs.resize(total * NN_OUTPUT_COUNT);
+		for (int i = 0; i < total; i++)
+		{
+			for (int f = 0; f < FEELER_COUNT; f++)
+			{
+				inputs[i * FEELER_COUNT + f] = 1 - depths[f * count + running[i]] / FEELER_LENGTH;
+			}
+		}
+		net.UpdateBatch(inputs.data(), running.data(), total, batchOutputs.data());
+
+		// Crashed agents keep whatever outputs they last had, Update masks them out anyway.
+		outputs.resize(count * NN_OUTPUT_COUNT, 0.0f);
+		for (int i = 0; i < total; i++)
+		{
+			for (int o = 0; o < NN_OUTPUT_COUNT; o++)
+			{
+				outputs[running[i] * NN_OUTPUT_COUNT + o] = batchOutputs[i * NN_OUTPUT_COUNT + o];
+			}
+		}
+
+		// Drive each run of neighbouring agents still going in one go, so nothing is spent on the
+		// crashed ones while the passes stay straight loops over the arrays.
+		for (int i = 0; i < total; )
+		{
+			int j = i + 1;
+			while (j < total && running[j] == running[j - 1] + 1)
+			{
+				j++;
+			}
+			Drive(outputs.data(), t, running[i], running[j - 1] + 1);
+			i = j;
+		}
+		ScoreCheckpoints(checkpoints);
+
+		return total;
+	}
+
+	void AgentPool::SetPosition(int agent, const Clarity::Vector2& position)
+	{
+		positionX[agent] = position.x;
+		positionY[agent] = position.y;
+		BuildFeelers(agent, agent + 1);
+		BuildBounds(agent, agent + 1);
+	}
+
+	Clarity::Vector2 AgentPool::GetPosition(int agent) const
+	{
+		return Clarity::Vector2(positionX[agent], positionY[agent]);
+	}
+
+	void AgentPool::SetRotation(int agent, float rotation)
+	{
+		heading[agent] = rotation;
+		RefreshHeading(agent);
+	}
+
+	float AgentPool::GetRotation(int agent) const
+	{
+		return heading[agent];
+	}
+
+	Clarity::Vector2 AgentPool::GetFeeler(int agent, int feeler) const
+	{
+		return Clarity::Vector2(feelerX[feeler * count + agent], feelerY[feeler * count + agent]);
+	}
+
+	Clarity::Vector2 AgentPool::GetFeelerEnd(int agent, int feeler) const
+	{
+		return Clarity::Vector2(feelerEndX[feeler * count + agent], feelerEndY[feeler * count + agent]);
+	}
+
+	float AgentPool::GetIntersectionDepth(int agent, int feeler) const
+	{
+		return depths[feeler * count + agent];
+	}
+
+	Clarity::Vector2 AgentPool::GetCorner(int agent, int corner) const
+	{
+		return Clarity::Vector2(cornerX[corner * count + agent], cornerY[corner * count + agent]);
+	}
+
+	Clarity::Circle AgentPool::GetSensorBounds(int agent) const
+	{
+		return Clarity::Circle(GetPosition(agent), FEELER_LENGTH);
+	}
+
+	bool AgentPool::HasFailed(int agent) const
+	{
+		return failed[agent] != 0;
+	}
+
+	void AgentPool::ClearFailure(int agent)
+	{
+		failed[agent] = 0;
+	}
+
+	float AgentPool::GetDistanceDelta(int agent) const
+	{
+		return distanceDelta[agent];
+	}
+
+	float AgentPool::GetFitness(int agent) const
+	{
+		return fitness[agent];
+	}
+
+}; // End namespace CarDemo.
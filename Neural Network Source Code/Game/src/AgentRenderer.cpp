@@ -0,0 +1,98 @@
+//****************************************************************************
+//**
+//**    AgentRenderer.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include "AgentRenderer.h"
+
+#include <GF1_Sprite.h>
+#include <GF1_Colour.h>
+#include <GF1_Graphics.h>
+
+#include "Agent.h"
+#include "GameGlobals.h"
+#include "GF1Conversions.h"
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+	AgentRenderer::AgentRenderer()
+		: sprite(NULL)
+	{
+		sprite = new GF1::Sprite("Resources/Car.png", (int)AGENT_WIDTH, (int)AGENT_HEIGHT, 1, 1, false);
+	}
+
+	AgentRenderer::~AgentRenderer()
+	{
+		if (sprite != NULL)
+		{
+			delete sprite;
+			sprite = NULL;
+		}
+	}
+
+	void AgentRenderer::DrawFeelers(const Agent& agent)
+	{
+		const GF1::Vector3 position = ToGF1Vector(agent.GetPosition());
+		const Sensor& sensor = agent.GetSensor();
+
+		GF1::DrawLine(position, ToGF1Vector(sensor.feelerEnds[FEELER_NORTH]), GF1::Colour::BLUE, false, 2);
+		GF1::DrawLine(position, ToGF1Vector(sensor.feelerEnds[FEELER_EAST]), GF1::Colour::BLUE, false, 2);
+		GF1::DrawLine(position, ToGF1Vector(sensor.feelerEnds[FEELER_NORTH_EAST]), GF1::Colour::BLUE, false, 2);
+		GF1::DrawLine(position, ToGF1Vector(sensor.feelerEnds[FEELER_NORTH_WEST]), GF1::Colour::BLUE, false, 2);
+		GF1::DrawLine(position, ToGF1Vector(sensor.feelerEnds[FEELER_WEST]), GF1::Colour::BLUE, false, 2);
+	}
+
+	void AgentRenderer::DrawAgentBounds(const Agent& agent)
+	{
+		GF1::DrawLine(ToGF1Vector(agent.GetCorner(CORNER_TOP_LEFT)), ToGF1Vector(agent.GetCorner(CORNER_TOP_RIGHT)), GF1::Colour::WHITE, false, 1);
+		GF1::DrawLine(ToGF1Vector(agent.GetCorner(CORNER_TOP_RIGHT)), ToGF1Vector(agent.GetCorner(CORNER_BOTTOM_RIGHT)), GF1::Colour::WHITE, false, 1);
+		GF1::DrawLine(ToGF1Vector(agent.GetCorner(CORNER_BOTTOM_RIGHT)), ToGF1Vector(agent.GetCorner(CORNER_BOTTOM_LEFT)), GF1::Colour::WHITE, false, 1);
+		GF1::DrawLine(ToGF1Vector(agent.GetCorner(CORNER_BOTTOM_LEFT)), ToGF1Vector(agent.GetCorner(CORNER_TOP_LEFT)), GF1::Colour::WHITE, false, 1);
+	}
+
+	void AgentRenderer::Render(const Agent& agent)
+	{
+		sprite->SetPosition(ToGF1Vector(agent.GetPosition()));
+		sprite->SetAngle(agent.GetRotation());
+		sprite->Render();
+		DrawFeelers(agent);
+		DrawAgentBounds(agent);
+
+		// Draw feeler intersections.
+		for (unsigned int i = 0; i < FEELER_COUNT; i++)
+		{
+			// Only draw if the depths as less than the feeler length, other wise we will get green
+			// dots floating around even through they arent touching anything.
+			const float depth = agent.GetIntersectionDepth(i);
+			if (depth < FEELER_LENGTH)
+			{
+				Clarity::Vector2 vec = agent.GetSensor().feelers[i];
+				if (vec.MagnitudeSquared() > 0.0f)
+				{
+					vec.Normalise();
+				}
+				vec *= depth;
+				vec += agent.GetPosition();
+				GF1::DrawFilledCircle(ToGF1Vector(vec), 5, GF1::Colour::GREEN);
+			}
+		}
+
+		// Draw the boundingCircle
+		GF1::DrawCircle(ToGF1Vector(agent.GetPosition()), FEELER_LENGTH, GF1::Colour::BLUE, false, 1);
+
+		// Draw the collision point against the wall if this bot sucks
+		if (agent.GetCollidedCorner() != -1)
+		{
+			GF1::DrawFilledCircle(ToGF1Vector(agent.GetCorner(agent.GetCollidedCorner())), 3, GF1::Colour::RED, false);
+		}
+	}
+
+}; // End namespace CarDemo.
\ No newline at end of file
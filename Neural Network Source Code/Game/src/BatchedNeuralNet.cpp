@@ -0,0 +1,291 @@
+//****************************************************************************
+//**
+//**    BatchedNeuralNet.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <assert.h>
+
+#include "BatchedNeuralNet.h"
+
+#include "AlignedMemory.h"
+#include "LayerKernels.h"
+#include "Activation.h"
+#include "NeuralNet.h"
+#include "NLayer.h"
+#include "GeneticAlgorithm.h"
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+
+	BatchedNeuralNet::BatchedNeuralNet()
+		: perGenome(false)
+		, capacity(0)
+	{
+		for (int i = 0; i < 2; i++)
+		{
+			buffers[i] = NULL;
+			runBuffers[i] = NULL;
+		}
+	}
+
+	BatchedNeuralNet::~BatchedNeuralNet()
+	{
+		ReleaseBuffers();
+	}
+
+	void BatchedNeuralNet::ReleaseBuffers()
+	{
+		for (int i = 0; i < 2; i++)
+		{
+			if (buffers[i] != NULL)
+			{
+				AlignedFree(buffers[i]);
+				buffers[i] = NULL;
+			}
+			if (runBuffers[i] != NULL)
+			{
+				AlignedFree(runBuffers[i]);
+				runBuffers[i] = NULL;
+			}
+		}
+		capacity = 0;
+	}
+
+	void BatchedNeuralNet::SetSharedNet(const NeuralNet& net)
+	{
+		net.GetLayout(layout);
+		perGenome = false;
+
+		sharedWeights.clear();
+		for (int i = 0; i < net.GetNumOfHiddenLayers(); i++)
+		{
+			sharedWeights.push_back(net.GetHiddenLayer(i)->GetWeightMatrix());
+		}
+		sharedWeights.push_back(net.GetOutputLayer()->GetWeightMatrix());
+
+		// The shapes may have changed, so the buffers will be regrown on the next update.
+		ReleaseBuffers();
+	}
+
+	void BatchedNeuralNet::SetTopology(int numOfHiddenLayers, int numOfInputs, int neuronsPerHidden, int numOfOutputs,
+										EvalFunction hiddenFunction, EvalFunction outputFunction)
+	{
+		SetLayout(NetworkLayout(numOfHiddenLayers, numOfInputs, neuronsPerHidden, numOfOutputs, hiddenFunction, outputFunction));
+	}
+
+	void BatchedNeuralNet::SetLayout(const NetworkLayout& layoutIn)
+	{
+		layout = layoutIn;
+		perGenome = true;
+		sharedWeights.clear();
+
+		ReleaseBuffers();
+	}
+
+	void BatchedNeuralNet::SetGenomeWeights(const float* weights, int genomeStride, int count)
+	{
+		assert(genomeStride == 0 || genomeStride >= layout.GetTotalWeights());
+
+		genomes.resize(count);
+		for (int i = 0; i < count; i++)
+		{
+			genomes[i] = weights + i * genomeStride;
+		}
+	}
+
+	void BatchedNeuralNet::SetGenomeWeights(const GeneticAlgorithm& genAlg)
+	{
+		SetGenomeWeights(genAlg.GetPopulationWeights(), genAlg.GetTotalWeights(), genAlg.GetTotalPopulation());
+	}
+
+	void BatchedNeuralNet::Reserve(int maxBatch)
+	{
+		if (maxBatch <= capacity)
+			return;
+
+		ReleaseBuffers();
+
+		// Big enough to hold the inputs or the widest layer for every agent.
+		for (int i = 0; i < 2; i++)
+		{
+			buffers[i] = AllocateFloats(layout.GetWidest() * maxBatch);
+			runBuffers[i] = AllocateFloats(layout.GetWidest() * maxBatch);
+		}
+		capacity = maxBatch;
+	}
+
+	void BatchedNeuralNet::UpdateBatch(const float* inputs, int count, float* outputs)
+	{
+		if (count <= 0 || layout.GetTotalLayers() == 0)
+			return;
+
+		Reserve(count);
+
+		if (perGenome)
+		{
+			UpdatePerGenome(inputs, NULL, count, outputs);
+		}
+		else
+		{
+			UpdateShared(inputs, count, outputs);
+		}
+	}
+
+	void BatchedNeuralNet::UpdateBatch(const float* inputs, const int* agents, int count, float* outputs)
+	{
+		if (count <= 0 || layout.GetTotalLayers() == 0)
+			return;
+
+		Reserve(count);
+
+		if (perGenome)
+		{
+			UpdatePerGenome(inputs, agents, count, outputs);
+		}
+		else
+		{
+			// Every agent shares the weights, so which ones they are makes no difference.
+			UpdateShared(inputs, count, outputs);
+		}
+	}
+
+	void BatchedNeuralNet::UpdateShared(const float* inputs, int count, float* outputs)
+	{
+		DenseBatchKernel kernel = GetDenseBatchKernel();
+		const int inputAmount = layout.GetTotalInputs();
+		const int outputAmount = layout.GetTotalOutputs();
+
+		// Turn the agent-major inputs feature-major so every weight can be broadcast down a
+		// contiguous run of agents.
+		float* source = buffers[0];
+		for (int a = 0; a < count; a++)
+		{
+			for (int j = 0; j < inputAmount; j++)
+			{
+				source[j * count + a] = inputs[a * inputAmount + j];
+			}
+		}
+
+		int current = 1;
+		for (int l = 0; l < layout.GetTotalLayers(); l++)
+		{
+			const LayerLayout& shape = layout.GetLayer(l);
+
+			float* dest = buffers[current];
+			kernel(sharedWeights[l], shape.neurons, shape.inputs, source, count, dest);
+
+			ApplyActivation(shape.function, dest, shape.neurons * count);
+
+			source = dest;
+			current = 1 - current;
+		}
+
+		// And back to agent-major for the caller.
+		for (int n = 0; n < outputAmount; n++)
+		{
+			for (int a = 0; a < count; a++)
+			{
+				outputs[a * outputAmount + n] = source[n * count + a];
+			}
+		}
+	}
+
+	void BatchedNeuralNet::UpdatePerGenome(const float* inputs, const int* agents, int count, float* outputs)
+	{
+		assert(agents != NULL || count <= (int)genomes.size());
+
+		DenseKernel kernel = GetDenseKernel();
+		DenseBatchKernel batchKernel = GetDenseBatchKernel();
+		const float* source = inputs;
+		int current = 0;
+
+		for (int l = 0; l < layout.GetTotalLayers(); l++)
+		{
+			const LayerLayout& shape = layout.GetLayer(l);
+
+			// The last layer writes straight into the callers buffer.
+			float* dest = (l + 1 == layout.GetTotalLayers()) ? outputs : buffers[current];
+
+			for (int a = 0; a < count; )
+			{
+				const float* genome = genomes[agents != NULL ? agents[a] : a];
+
+				int end = a + 1;
+				while (end < count && genomes[agents != NULL ? agents[end] : end] == genome)
+				{
+					end++;
+				}
+
+				if (end - a == 1)
+				{
+					kernel(genome + shape.offset, shape.neurons, shape.inputs,
+						   source + a * shape.inputs, dest + a * shape.neurons);
+				}
+				else
+				{
+					BatchRun(batchKernel, genome + shape.offset, shape, source, a, end - a, dest);
+				}
+				a = end;
+			}
+
+			ApplyActivation(shape.function, dest, shape.neurons * count);
+
+			source = dest;
+			current = 1 - current;
+		}
+	}
+
+	void BatchedNeuralNet::BatchRun(DenseBatchKernel kernel, const float* weights, const LayerLayout& shape,
+									const float* source, int first, int runLength, float* dest)
+	{
+		// The batch kernel wants the run feature-major, the rest of the pass is agent-major.
+		float* runInput = runBuffers[0];
+		float* runOutput = runBuffers[1];
+		for (int a = 0; a < runLength; a++)
+		{
+			for (int j = 0; j < shape.inputs; j++)
+			{
+				runInput[j * runLength + a] = source[(first + a) * shape.inputs + j];
+			}
+		}
+
+		kernel(weights, shape.neurons, shape.inputs, runInput, runLength, runOutput);
+
+		for (int n = 0; n < shape.neurons; n++)
+		{
+			for (int a = 0; a < runLength; a++)
+			{
+				dest[(first + a) * shape.neurons + n] = runOutput[n * runLength + a];
+			}
+		}
+	}
+
+	int BatchedNeuralNet::GetTotalInputs() const
+	{
+		return layout.GetTotalInputs();
+	}
+
+	int BatchedNeuralNet::GetTotalOutputs() const
+	{
+		return layout.GetTotalOutputs();
+	}
+
+	int BatchedNeuralNet::GetTotalWeights() const
+	{
+		return layout.GetTotalWeights();
+	}
+
+	const NetworkLayout& BatchedNeuralNet::GetLayout() const
+	{
+		return layout;
+	}
+
+}; // End namespace CarDemo.
\ No newline at end of file
@@ -0,0 +1,51 @@
+//****************************************************************************
+//**
+//**    BenchmarkMain.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+// Console build of the game's BENCHMARK_BUILD, for platforms without GF1. Times the activation
+// modes and prints the quantization report, run from the bin directory like the game.
+//
+//    benchmarks [-net file] [-recording file]
+
+#include <iostream>
+#include <string.h>
+
+#include "Benchmarks.h"
+
+#include "MemoryLeak.h"
+
+using namespace CarDemo;
+
+int main(int argc, char** argv)
+{
+	const char* netFile = "Resources/ExportedNNs/UberNeuralNet1.txt";
+	const char* recordingFile = "ExportedNNs/SensorRecording.txt";
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "-net") == 0)
+		{
+			netFile = argv[i + 1];
+		}
+		else if (strcmp(argv[i], "-recording") == 0)
+		{
+			recordingFile = argv[i + 1];
+		}
+		else
+		{
+			std::cout << "Unknown option " << argv[i] << std::endl;
+			return 1;
+		}
+	}
+
+	RunActivationBenchmark(std::cout);
+	RunQuantizationReport(std::cout, netFile, recordingFile);
+	return 0;
+}
@@ -0,0 +1,183 @@
+//****************************************************************************
+//**
+//**    Benchmarks.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <math.h>
+#include <time.h>
+#include <vector>
+
+#include "Benchmarks.h"
+
+#include "Activation.h"
+#include "LayerKernels.h"
+#include "GameGlobals.h"
+#include "NeuralNet.h"
+#include "QuantizedNeuralNet.h"
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+	// A layer-sized buffer, squashed over and over so it stays in the L1 cache.
+	const int BENCHMARK_VALUES = 1024;
+	const int BENCHMARK_PASSES = 20000;
+
+	static const char* ModeName(ActivationMode mode)
+	{
+		switch (mode)
+		{
+		case ACTIVATION_EXACT:
+			return "exact ";
+		case ACTIVATION_APPROX:
+			return "approx";
+		case ACTIVATION_TABLE:
+			return "table ";
+		}
+		return "?";
+	}
+
+	static const char* LevelName(KernelLevel level)
+	{
+		switch (level)
+		{
+		case KERNEL_SCALAR:
+			return "scalar";
+		case KERNEL_SSE2:
+			return "sse2  ";
+		case KERNEL_AVX2:
+			return "avx2  ";
+		}
+		return "?";
+	}
+
+	void RunActivationBenchmark(std::ostream& out)
+	{
+		// Pre-activation values are sums of a handful of weighted inputs, so spread them over
+		// the range where the curve actually bends plus a few that saturate.
+		std::vector<float> source(BENCHMARK_VALUES);
+		for (int i = 0; i < BENCHMARK_VALUES; i++)
+		{
+			source[i] = RandomClamped() * 12.0f;
+		}
+
+		std::vector<float> values(BENCHMARK_VALUES);
+		const KernelLevel best = DetectKernelLevel();
+
+		out << "Activation benchmark, " << BENCHMARK_VALUES << " values x " << BENCHMARK_PASSES << " passes" << std::endl;
+
+		for (int m = ACTIVATION_EXACT; m <= ACTIVATION_TABLE; m++)
+		{
+			for (int l = KERNEL_SCALAR; l <= best; l++)
+			{
+				const ActivationMode mode = (ActivationMode)m;
+				const KernelLevel level = (KernelLevel)l;
+
+				// Accuracy, measured once against the double precision curve.
+				values = source;
+				ApplySigmoid(&values[0], BENCHMARK_VALUES, mode, level);
+
+				double maxError = 0.0;
+				for (int i = 0; i < BENCHMARK_VALUES; i++)
+				{
+					const double expected = 1.0 / (1.0 + exp(-(double)source[i]));
+					const double error = fabs(expected - values[i]);
+					if (error > maxError)
+					{
+						maxError = error;
+					}
+				}
+
+				// Speed. The buffer is refreshed every pass so the sigmoid always sees the same
+				// spread of inputs rather than collapsing towards 0.5.
+				const clock_t start = clock();
+				for (int p = 0; p < BENCHMARK_PASSES; p++)
+				{
+					values = source;
+					ApplySigmoid(&values[0], BENCHMARK_VALUES, mode, level);
+				}
+				const clock_t end = clock();
+
+				const double seconds = (double)(end - start) / CLOCKS_PER_SEC;
+				const double nsPerValue = seconds * 1e9 / ((double)BENCHMARK_VALUES * BENCHMARK_PASSES);
+
+				out << ModeName(mode) << " " << LevelName(level)
+					<< "  " << nsPerValue << " ns/value"
+					<< "  max error " << maxError << std::endl;
+			}
+		}
+	}
+
+	// Synthetic stand in for a recording, sensor inputs are 1 - (depth / FEELER_LENGTH).
+	const int SYNTHETIC_SAMPLES = 4096;
+
+	static const char* FormatName(QuantizeFormat format)
+	{
+		return format == QUANTIZE_FP16 ? "fp16" : "int8";
+	}
+
+	void RunQuantizationReport(std::ostream& out, const char* netFilename, const char* recordingFilename)
+	{
+		NeuralNet net;
+		net.LoadNet(netFilename);
+		if (net.GetOutputLayer() == NULL)
+		{
+			out << "Couldn't load " << netFilename << std::endl;
+			return;
+		}
+
+		const int inputAmount = net.GetTotalInputs();
+		std::vector<float> recording;
+		int inputsPerSample = 0;
+
+		if (LoadSensorRecording(recordingFilename, recording, inputsPerSample) && inputsPerSample == inputAmount && !recording.empty())
+		{
+			out << "Feeding the inputs recorded in " << recordingFilename << " (open loop)" << std::endl;
+		}
+		else
+		{
+			out << "No usable recording at " << recordingFilename << ", using random sensor readings" << std::endl;
+			recording.resize(SYNTHETIC_SAMPLES * inputAmount);
+			for (unsigned int i = 0; i < recording.size(); i++)
+			{
+				recording[i] = RandomFloat();
+			}
+		}
+
+		const int samples = recording.size() / inputAmount;
+		std::vector<float> outputs(net.GetTotalOutputs());
+
+		const clock_t floatStart = clock();
+		for (int s = 0; s < samples; s++)
+		{
+			net.SetInput(&recording[s * inputAmount], inputAmount);
+			net.Update();
+		}
+		const double floatSeconds = (double)(clock() - floatStart) / CLOCKS_PER_SEC;
+		out << "float  " << floatSeconds * 1e9 / samples << " ns/update" << std::endl;
+
+		const QuantizeFormat formats[2] = { QUANTIZE_INT8, QUANTIZE_FP16 };
+		for (int f = 0; f < 2; f++)
+		{
+			QuantizedNeuralNet quantized;
+			quantized.Quantize(net, formats[f], &recording[0], samples);
+
+			const clock_t start = clock();
+			for (int s = 0; s < samples; s++)
+			{
+				quantized.Update(&recording[s * inputAmount], &outputs[0]);
+			}
+			const double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+			out << FormatName(formats[f]) << "   " << seconds * 1e9 / samples << " ns/update" << std::endl;
+			PrintQuantizationReport(quantized.CompareOpenLoop(net, &recording[0], samples), out);
+		}
+	}
+
+}; // End namespace CarDemo.
\ No newline at end of file
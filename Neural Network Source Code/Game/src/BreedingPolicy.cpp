@@ -0,0 +1,100 @@
+//****************************************************************************
+//**
+//**    BreedingPolicy.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <string.h>
+
+#include "BreedingPolicy.h"
+
+#include "GameGlobals.h"
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+	static const char* const SELECTION_NAMES[SELECTION_COUNT] = { "truncation", "tournament", "ranked", "sus" };
+	static const char* const CROSSOVER_NAMES[CROSSOVER_COUNT] = { "single-point", "neuron", "multi-point", "uniform", "none" };
+	static const char* const MUTATION_NAMES[MUTATION_COUNT] = { "uniform", "none", "gaussian", "self-adaptive" };
+
+	BreedingPolicy::BreedingPolicy()
+		: eliteCount(1)
+		, mutateElites(true)
+		, immigrantFraction(4.0f / 15.0f)
+		, selection(SELECTION_TRUNCATION)
+		, selectionSize(4)
+		, rankPressure(1.5f)
+		, crossover(CROSSOVER_NEURON_POINT)
+		, crossoverPoints(2)
+		, mutation(MUTATION_UNIFORM)
+		, mutationRate(MUTATION_RATE)
+		, maxPerturbation(MAX_PERBETUATION)
+		, mutationSigma(MAX_PERBETUATION / 3.0f)
+		, minimumSigma(0.001f)
+	{
+	}
+
+	static int FindName(const char* const* names, int count, const char* name)
+	{
+		if (name == NULL)
+			return -1;
+
+		for (int i = 0; i < count; i++)
+		{
+			if (strcmp(names[i], name) == 0)
+				return i;
+		}
+		return -1;
+	}
+
+	const char* GetSelectionName(SelectionOperator selection)
+	{
+		return selection >= 0 && selection < SELECTION_COUNT ? SELECTION_NAMES[selection] : "";
+	}
+
+	const char* GetCrossoverName(CrossoverOperator crossover)
+	{
+		return crossover >= 0 && crossover < CROSSOVER_COUNT ? CROSSOVER_NAMES[crossover] : "";
+	}
+
+	const char* GetMutationName(MutationOperator mutation)
+	{
+		return mutation >= 0 && mutation < MUTATION_COUNT ? MUTATION_NAMES[mutation] : "";
+	}
+
+	bool ParseSelection(const char* name, SelectionOperator& out)
+	{
+		const int index = FindName(SELECTION_NAMES, SELECTION_COUNT, name);
+		if (index < 0)
+			return false;
+
+		out = (SelectionOperator)index;
+		return true;
+	}
+
+	bool ParseCrossover(const char* name, CrossoverOperator& out)
+	{
+		const int index = FindName(CROSSOVER_NAMES, CROSSOVER_COUNT, name);
+		if (index < 0)
+			return false;
+
+		out = (CrossoverOperator)index;
+		return true;
+	}
+
+	bool ParseMutation(const char* name, MutationOperator& out)
+	{
+		const int index = FindName(MUTATION_NAMES, MUTATION_COUNT, name);
+		if (index < 0)
+			return false;
+
+		out = (MutationOperator)index;
+		return true;
+	}
+
+}; // End namespace CarDemo.
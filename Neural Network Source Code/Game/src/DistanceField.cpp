@@ -0,0 +1,458 @@
+//****************************************************************************
+//**
+//**    DistanceField.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+
+#include "DistanceField.h"
+
+#include "AgentPool.h"
+#include "GameGlobals.h"
+#include "NetFile.h"
+#include "TrackGeometry.h"
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+	// A trace that hasn't reached a wall or its end by then gives up where it is, which only
+	// happens running a hair's breadth along a wall.
+	static const int MAX_TRACE_STEPS = 64;
+
+	// Appends 'loop' to 'out', plus a segment from its end back to its start if it doesn't get
+	// there on its own.
+	static void AddClosedLoop(const std::vector<Clarity::LineSegment2> &loop, std::vector<Clarity::LineSegment2> &out)
+	{
+		if (loop.empty())
+			return;
+
+		out.insert(out.end(), loop.begin(), loop.end());
+
+		const Clarity::Vector2& end = loop.back().GetHead();
+		const Clarity::Vector2& start = loop.front().GetTail();
+		if (end.x != start.x || end.y != start.y)
+		{
+			out.push_back(Clarity::LineSegment2(end, start));
+		}
+	}
+
+	DistanceField::DistanceField()
+		: originX(0.0f)
+		, originY(0.0f)
+		, cellSize(1.0f)
+		, inverseCellSize(1.0f)
+		, range(0.0f)
+		, columns(0)
+		, rows(0)
+	{
+	}
+
+	void DistanceField::Build(const TrackGeometry& track, float cellSizeIn, float rangeIn)
+	{
+		Clear();
+
+		// The editor leaves a small gap between the last and first segment of each wall. The sign
+		// below needs closed loops, so close them.
+		std::vector<Clarity::LineSegment2> walls;
+		AddClosedLoop(track.GetInnerSections(), walls);
+		AddClosedLoop(track.GetOuterSections(), walls);
+
+		SensorSegments segments;
+		segments.Set(walls);
+		const int total = segments.GetCount();
+		if (total == 0 || cellSizeIn <= 0.0f)
+			return;
+
+		const float* tx = segments.GetTailX();
+		const float* ty = segments.GetTailY();
+		const float* vx = segments.GetVectorX();
+		const float* vy = segments.GetVectorY();
+
+		float minX = tx[0];
+		float minY = ty[0];
+		float maxX = tx[0];
+		float maxY = ty[0];
+		for (int i = 0; i < total; i++)
+		{
+			minX = std::min(minX, std::min(tx[i], tx[i] + vx[i]));
+			minY = std::min(minY, std::min(ty[i], ty[i] + vy[i]));
+			maxX = std::max(maxX, std::max(tx[i], tx[i] + vx[i]));
+			maxY = std::max(maxY, std::max(ty[i], ty[i] + vy[i]));
+		}
+
+		cellSize = cellSizeIn;
+		inverseCellSize = 1.0f / cellSize;
+		range = rangeIn;
+		originX = minX - range;
+		originY = minY - range;
+		columns = (int)std::ceil((maxX - minX + 2 * range) * inverseCellSize) + 1;
+		rows = (int)std::ceil((maxY - minY + 2 * range) * inverseCellSize) + 1;
+		samples.assign(columns * rows, range);
+
+		// Distance to the nearest wall. A segment can only bring a sample below 'range' inside its
+		// bounding box grown by 'range', so that's all each one visits.
+		for (int i = 0; i < total; i++)
+		{
+			const float lengthSquared = vx[i] * vx[i] + vy[i] * vy[i];
+			const float inverseLength = lengthSquared > 0.0f ? 1.0f / lengthSquared : 0.0f;
+
+			const int firstX = std::max(0, (int)std::floor((std::min(tx[i], tx[i] + vx[i]) - range - originX) * inverseCellSize));
+			const int lastX = std::min(columns - 1, (int)std::ceil((std::max(tx[i], tx[i] + vx[i]) + range - originX) * inverseCellSize));
+			const int firstY = std::max(0, (int)std::floor((std::min(ty[i], ty[i] + vy[i]) - range - originY) * inverseCellSize));
+			const int lastY = std::min(rows - 1, (int)std::ceil((std::max(ty[i], ty[i] + vy[i]) + range - originY) * inverseCellSize));
+
+			for (int y = firstY; y <= lastY; y++)
+			{
+				float* row = &samples[y * columns];
+				const float oy = originY + y * cellSize - ty[i];
+				for (int x = firstX; x <= lastX; x++)
+				{
+					const float ox = originX + x * cellSize - tx[i];
+					const float along = std::min(std::max((ox * vx[i] + oy * vy[i]) * inverseLength, 0.0f), 1.0f);
+					const float dx = ox - vx[i] * along;
+					const float dy = oy - vy[i] * along;
+					row[x] = std::min(row[x], std::sqrt(dx * dx + dy * dy));
+				}
+			}
+		}
+
+		// The road is everywhere a line out to the left crosses the walls an odd number of times:
+		// inside the outer wall and outside the inner one. One sorted list of crossings per row
+		// signs the whole row.
+		std::vector<float> crossings;
+		for (int y = 0; y < rows; y++)
+		{
+			const float py = originY + y * cellSize;
+
+			crossings.clear();
+			for (int i = 0; i < total; i++)
+			{
+				const float headY = ty[i] + vy[i];
+				if ((ty[i] > py) != (headY > py))
+				{
+					crossings.push_back(tx[i] + (py - ty[i]) * vx[i] / vy[i]);
+				}
+			}
+			std::sort(crossings.begin(), crossings.end());
+
+			float* row = &samples[y * columns];
+			unsigned int next = 0;
+			bool road = false;
+			for (int x = 0; x < columns; x++)
+			{
+				const float px = originX + x * cellSize;
+				while (next < crossings.size() && crossings[next] <= px)
+				{
+					road = !road;
+					next++;
+				}
+
+				if (!road)
+				{
+					row[x] = -row[x];
+				}
+			}
+		}
+	}
+
+	bool DistanceField::Save(const char* filename, unsigned int polygonHash) const
+	{
+		if (IsEmpty())
+			return false;
+
+		const unsigned int size = sizeof(DistanceFieldHeader) + samples.size() * sizeof(float);
+		std::vector<unsigned char> buffer(size, 0);
+		memcpy(&buffer[sizeof(DistanceFieldHeader)], &samples[0], samples.size() * sizeof(float));
+
+		DistanceFieldHeader* header = (DistanceFieldHeader*)&buffer[0];
+		header->magic = DISTANCE_FIELD_MAGIC;
+		header->version = DISTANCE_FIELD_VERSION;
+		header->fileSize = size;
+		header->polygonHash = polygonHash;
+		header->columns = columns;
+		header->rows = rows;
+		header->originX = originX;
+		header->originY = originY;
+		header->cellSize = cellSize;
+		header->range = range;
+		header->checksum = NetFileChecksum(&buffer[sizeof(DistanceFieldHeader)], size - sizeof(DistanceFieldHeader));
+
+		FILE* file = fopen(filename, "wb");
+		if (file == NULL)
+			return false;
+
+		const bool written = fwrite(&buffer[0], 1, size, file) == size;
+		fclose(file);
+		return written;
+	}
+
+	bool DistanceField::Load(const char* filename, unsigned int polygonHash, float cellSizeIn, float rangeIn)
+	{
+		FILE* file = fopen(filename, "rb");
+		if (file == NULL)
+			return false;
+
+		DistanceFieldHeader header;
+		const bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+						   header.magic == DISTANCE_FIELD_MAGIC &&
+						   header.version == DISTANCE_FIELD_VERSION &&
+						   header.polygonHash == polygonHash &&
+						   header.cellSize == cellSizeIn &&
+						   header.range == rangeIn &&
+						   header.columns > 1 && header.rows > 1 &&
+						   header.fileSize == sizeof(header) + (unsigned long long)header.columns * header.rows * sizeof(float);
+		if (!valid)
+		{
+			fclose(file);
+			return false;
+		}
+
+		std::vector<float> data(header.columns * header.rows);
+		const bool read = fread(&data[0], sizeof(float), data.size(), file) == data.size();
+		fclose(file);
+
+		if (!read || NetFileChecksum((const unsigned char*)&data[0], data.size() * sizeof(float)) != header.checksum)
+			return false;
+
+		samples.swap(data);
+		originX = header.originX;
+		originY = header.originY;
+		cellSize = header.cellSize;
+		inverseCellSize = 1.0f / cellSize;
+		range = header.range;
+		columns = header.columns;
+		rows = header.rows;
+		return true;
+	}
+
+	bool DistanceField::LoadOrBuild(const TrackGeometry& track, const char* polygonFile, float cellSizeIn, float rangeIn)
+	{
+		unsigned int hash = 0;
+		if (!HashFile(polygonFile, hash))
+			return false;
+
+		char cacheFile[256];
+		snprintf(cacheFile, sizeof(cacheFile), "%s/Track%08x_%g_%g.sdf", DISTANCE_FIELD_CACHE_DIRECTORY, hash, cellSizeIn, rangeIn);
+		if (Load(cacheFile, hash, cellSizeIn, rangeIn))
+			return true;
+
+		// Not being able to cache it only costs the next run a rebuild.
+		Build(track, cellSizeIn, rangeIn);
+		Save(cacheFile, hash);
+		return true;
+	}
+
+	void DistanceField::Clear()
+	{
+		samples.clear();
+		columns = 0;
+		rows = 0;
+	}
+
+	bool DistanceField::IsEmpty() const
+	{
+		return samples.empty();
+	}
+
+	float DistanceField::Sample(float x, float y) const
+	{
+		const float fx = (x - originX) * inverseCellSize;
+		const float fy = (y - originY) * inverseCellSize;
+		if (!(fx >= 0.0f && fy >= 0.0f))
+			return -range;
+
+		// Both are positive, so truncating is flooring, without the library call.
+		const int cellX = (int)fx;
+		const int cellY = (int)fy;
+		if (cellX >= columns - 1 || cellY >= rows - 1)
+			return -range;
+
+		const float u = fx - cellX;
+		const float v = fy - cellY;
+		const float* row = &samples[cellY * columns + cellX];
+		const float bottom = row[0] + (row[1] - row[0]) * u;
+		const float top = row[columns] + (row[columns + 1] - row[columns]) * u;
+		return bottom + (top - bottom) * v;
+	}
+
+	float DistanceField::Trace(float px, float py, float dx, float dy, float maxDistance) const
+	{
+		// Nothing is closer than the distance at a point, so it's always safe to step that far.
+		// Close enough to a wall counts as touching it, the rest of the way is taken head on.
+		const float touching = cellSize * 0.25f;
+		float travelled = 0.0f;
+		for (int i = 0; i < MAX_TRACE_STEPS; i++)
+		{
+			const float distance = Sample(px + dx * travelled, py + dy * travelled);
+			if (distance < touching)
+				return std::min(std::max(travelled + distance, 0.0f), maxDistance);
+
+			travelled += distance;
+			if (travelled >= maxDistance)
+				return maxDistance;
+		}
+		return travelled;
+	}
+
+	bool DistanceField::Overlaps(const float* x, const float* y, int points) const
+	{
+		for (int i = 0; i < points; i++)
+		{
+			if (Sample(x[i], y[i]) <= 0.0f)
+				return true;
+		}
+		return false;
+	}
+
+	float DistanceField::GetCellSize() const
+	{
+		return cellSize;
+	}
+
+	float DistanceField::GetRange() const
+	{
+		return range;
+	}
+
+	int DistanceField::GetColumns() const
+	{
+		return columns;
+	}
+
+	int DistanceField::GetRows() const
+	{
+		return rows;
+	}
+
+	bool HashFile(const char* filename, unsigned int& out)
+	{
+		FILE* file = fopen(filename, "rb");
+		if (file == NULL)
+			return false;
+
+		std::vector<unsigned char> data;
+		unsigned char block[4096];
+		size_t read = 0;
+		while ((read = fread(block, 1, sizeof(block), file)) > 0)
+		{
+			data.insert(data.end(), block, block + read);
+		}
+		fclose(file);
+
+		out = NetFileChecksum(data.empty() ? NULL : &data[0], data.size());
+		return true;
+	}
+
+	void ValidateDistanceField(const TrackGeometry& track, const DistanceField& field, DistanceFieldReport& out)
+	{
+		memset(&out, 0, sizeof(out));
+		if (field.IsEmpty())
+			return;
+
+		// A car every eight units or so of road, in eight headings.
+		const int headings = 8;
+		const float spacing = 8.0f;
+		const int stride = std::max(1, (int)(spacing / field.GetCellSize() + 0.5f));
+		const float step = stride * field.GetCellSize();
+
+		const SensorSegments& segments = track.GetSensorSegments();
+		float minX = segments.GetTailX()[0];
+		float minY = segments.GetTailY()[0];
+		float maxX = minX;
+		float maxY = minY;
+		for (int i = 0; i < segments.GetCount(); i++)
+		{
+			minX = std::min(minX, segments.GetTailX()[i]);
+			minY = std::min(minY, segments.GetTailY()[i]);
+			maxX = std::max(maxX, segments.GetTailX()[i]);
+			maxY = std::max(maxY, segments.GetTailY()[i]);
+		}
+
+		// Off the whole numbers, where the track's vertices are. A ray straight through the
+		// vertex between two walls can slip past both in the exact test.
+		const float offset = step * 0.37f;
+
+		std::vector<Clarity::Vector2> positions;
+		for (float y = minY + offset; y <= maxY; y += step)
+		{
+			for (float x = minX + offset; x <= maxX; x += step)
+			{
+				if (field.Sample(x, y) > 0.0f)
+				{
+					positions.push_back(Clarity::Vector2(x, y));
+				}
+			}
+		}
+
+		AgentPool pool((int)positions.size() * headings);
+		for (unsigned int i = 0; i < positions.size(); i++)
+		{
+			for (int h = 0; h < headings; h++)
+			{
+				pool.Reset(i * headings + h, positions[i], h * 360.0f / headings);
+			}
+		}
+		const int count = pool.GetCount();
+
+		// The body against the walls, the exact way and then through the field.
+		pool.CheckForCollision(track);
+		std::vector<unsigned char> crashed(count);
+		for (int a = 0; a < count; a++)
+		{
+			crashed[a] = pool.HasFailed(a) ? 1 : 0;
+			pool.ClearFailure(a);
+		}
+
+		pool.CheckForCollision(field);
+		for (int a = 0; a < count; a++)
+		{
+			if (crashed[a] && !pool.HasFailed(a))
+				out.missedCollisions++;
+			else if (!crashed[a] && pool.HasFailed(a))
+				out.falseCollisions++;
+			pool.ClearFailure(a);
+		}
+		out.bodies = count;
+
+		// Feelers likewise, for the cars that are clear of the walls. A crashed car's feelers
+		// are never read, and from inside a wall the two ways disagree about what's in front.
+		std::vector<float> exact(count * FEELER_COUNT);
+		pool.UpdateSensors(track);
+		for (int a = 0; a < count; a++)
+		{
+			for (int f = 0; f < FEELER_COUNT; f++)
+			{
+				exact[a * FEELER_COUNT + f] = pool.GetIntersectionDepth(a, f);
+			}
+		}
+
+		pool.UpdateSensors(field);
+		double totalError = 0.0;
+		for (int a = 0; a < count; a++)
+		{
+			if (crashed[a])
+				continue;
+
+			for (int f = 0; f < FEELER_COUNT; f++)
+			{
+				const float error = std::fabs(pool.GetIntersectionDepth(a, f) - exact[a * FEELER_COUNT + f]);
+				totalError += error;
+				out.maxDepthError = std::max(out.maxDepthError, error);
+				out.raysWithinCell += error <= field.GetCellSize() ? 1 : 0;
+				out.rays++;
+			}
+		}
+		out.meanDepthError = out.rays > 0 ? (float)(totalError / out.rays) : 0.0f;
+	}
+
+}; // End namespace CarDemo.
@@ -7,6 +7,7 @@
 #include "EditorInterface.h"
 #include "GameTimer.h"
 #include "GameGlobals.h"
+#include "GF1Conversions.h"
 #include "GameSettings.h"
 
 #include "MemoryLeak.h"
@@ -21,34 +21,43 @@
 #include <GF1_Graphics.h>
 
 #include "Agent.h"
+#include "AgentRenderer.h"
 #include "GeneticAlgorithm.h"
 #include "NeuralNet.h"
+#include "QuantizedNeuralNet.h"
+#include "PopulationEvaluator.h"
+#include "TrackGeometry.h"
+#include "Genome.h"
 
 #include "GameSettings.h"
 #include "GameGlobals.h"
+#include "GF1Conversions.h"
 #include "MemoryLeak.h"
 
 namespace CarDemo 
 {
 
-	EntityManager::EntityManager()
+	EntityManager::EntityManager(const TrackGeometry& trackIn)
+		: track(&trackIn)
+		, stepAccumulator(0.0f)
+		, layout(1, FEELER_COUNT, HIDDEN_LAYER_NEURONS, NN_OUTPUT_COUNT)
 	{
 		font = new GF1::Sprite("Resources/TimesNewRomanWhite.png", 16, 16, 16*16, 1, false);
 		pointSprite = new GF1::Sprite("Resources/PolyPointHighlighted.png", 8, 8, 1, 1, false);
 
+		evaluator = NULL;
 		genAlg = new GeneticAlgorithm();
-		int totalWeights = FEELER_COUNT * HIDDEN_LAYER_NEURONS + HIDDEN_LAYER_NEURONS * NN_OUTPUT_COUNT + HIDDEN_LAYER_NEURONS + NN_OUTPUT_COUNT;
-		genAlg->GenerateNewPopulation(MAX_GENOME_POPULATION, totalWeights);
-		currentAgentFitness = 0.0f;
+		genAlg->GenerateCrossoverSplits(layout);
+		genAlg->GenerateNewPopulation(MAX_GENOME_POPULATION, layout.GetTotalWeights());
 		bestFitness = 0.0f;
 
 		neuralNet = new NeuralNet();
-		neuralNet->FromGenome(*genAlg->GetNextGenome(), FEELER_COUNT, HIDDEN_LAYER_NEURONS, NN_OUTPUT_COUNT);
-		testAgent = new Agent();
+		neuralNet->FromGenome(genAlg->GetNextGenome(), layout);
 
-		testAgent->SetRotation(DEFAULT_ROTATION);
-		testAgent->SetPosition(DEFAULT_POSITION);
-		testAgent->Attach(neuralNet);
+		agentRenderer = new AgentRenderer();
+		simulation = new Simulation(*track, checkpoints);
+		simulation->GetAgent().RecordInputs(&sensorRecording);
+		simulation->Reset(neuralNet);
 	}
 
 	EntityManager::~EntityManager()
@@ -65,16 +74,28 @@ namespace CarDemo
 			pointSprite = NULL;
 		}
 
+		if (evaluator != NULL)
+		{
+			delete evaluator;
+			evaluator = NULL;
+		}
+
 		if (genAlg != NULL)
 		{
 			delete genAlg;
 			genAlg = NULL;
 		}
 
-		if (testAgent != NULL)
+		if (simulation != NULL)
+		{
+			delete simulation;
+			simulation = NULL;
+		}
+
+		if (agentRenderer != NULL)
 		{
-			delete testAgent;
-			testAgent = NULL;
+			delete agentRenderer;
+			agentRenderer = NULL;
 		}
 
 		if (neuralNet != NULL)
@@ -86,92 +107,10 @@ namespace CarDemo
 
 	void EntityManager::LoadCheckPoints(char* filename)
 	{
-		FILE* file = fopen(filename,"rt");
-		int tempID = 0;
-
-		if (file!=NULL)
-		{
+		LoadCheckpoints(filename, checkpoints);
 
-			Clarity::Vector2 start;
-			Clarity::Vector2 end;
-			int totalCheckpoints = 0;
-			int currentCheckpoint = 0;
-
-			char buffComp[1024] ={0};
-
-			while(fgets(buffComp,1024,file))
-			{
-				char buff[1024] = {0};
-
-				if(buffComp[strlen(buffComp)-1]=='\n')
-				{
-					for(unsigned int i = 0; i<strlen(buffComp)-1;i++)
-					{
-						buff[i] = buffComp[i];
-					}
-				}
-
-				if(0 == strcmp(buff, "<Declaration>"))
-				{
-				}
-				else if (0==strcmp(buff,"</Declaration>"))
-				{
-					break;
-				}
-				else if (0==strcmp(buff,"-Build-"))
-				{
-					checkpoints.resize(totalCheckpoints);
-				}
-				else if(0 == strcmp(buff, "<Checkpoint>"))
-				{
-					start.Set(0.0f, 0.0f);
-					end.Set(0.0f, 0.0f);
-				}
-				else if (0==strcmp(buff,"</Checkpoint>"))
-				{
-					checkpoints[currentCheckpoint].Set(end, start);
-					currentCheckpoint++;
-				}
-			
-				else
-				{
-					char* token = strtok(buff, "=");
-					if(token != NULL)
-					{
-						char* value = strtok(NULL,"=");
-
-
-						if(0 == strcmp(token,"sX"))
-						{
-							start.x = (float)atof(value);
-						}
-						else if(0 == strcmp(token,"sY"))
-						{
-							start.y = (float)atof(value);
-						}
-						else if(0 == strcmp(token,"eX"))
-						{
-							end.x = (float)atof(value);
-						}
-						else if(0 == strcmp(token,"eY"))
-						{
-							end.y = (float)atof(value);
-						}
-						else if(0 == strcmp("TotalCheckpoints", token))
-						{
-							totalCheckpoints = atoi(value);
-						}
-					}
-				}
-			}
-			fclose(file);
-		}
-		
-		checkpointFlags.resize(checkpoints.size());
-		for (unsigned int i = 0; i < checkpointFlags.size(); i++)
-		{
-			checkpointFlags[i] = Checkpoint_Active;
-		}
+		// The episode's checkpoint flags have to match the new list.
+		simulation->Reset(neuralNet);
 	}
 
 	void EntityManager::LoadExternalNetwork(char* filename)
@@ -180,44 +119,88 @@ namespace CarDemo
 		network->LoadNet(filename);
 	}
 
+	bool EntityManager::ResumePopulation(const char* filename)
+	{
+		if (!genAlg->LoadCheckpoint(filename))
+			return false;
+
+		Genome genome = genAlg->GetNextGenome();
+		if (genAlg->GetTotalPopulation() != MAX_GENOME_POPULATION || genome.IsEmpty() ||
+			genome.totalWeights != layout.GetTotalWeights())
+		{
+			// Saved from a different topology, start over.
+			genAlg->GenerateNewPopulation(MAX_GENOME_POPULATION, layout.GetTotalWeights());
+			genome = genAlg->GetNextGenome();
+			neuralNet->FromGenome(genome, layout);
+			simulation->Reset(neuralNet);
+			return false;
+		}
+
+		// The old genomes are gone, so the net must stop viewing them.
+		neuralNet->FromGenome(genome, layout);
+		simulation->Reset(neuralNet);
+		return true;
+	}
+
 	void EntityManager::ExportCurrentAgent()
 	{
-		testAgent->GetNeuralNet()->ExportNet("NeuralNet.txt");
+		neuralNet->ExportNet("NeuralNet.txt");
+		ExportSensorRecording("SensorRecording.txt", sensorRecording, FEELER_COUNT);
 	}
 
 	void EntityManager::NextTestSubject()
 	{
-		genAlg->SetGenomeFitness(currentAgentFitness,  genAlg->GetCurrentGenomeIndex());
-		currentAgentFitness = 0.0f;
-		Genome* genome = genAlg->GetNextGenome();
+		genAlg->SetGenomeFitness(simulation->GetFitness(),  genAlg->GetCurrentGenomeIndex());
+		Genome genome = genAlg->GetNextGenome();
 
-		neuralNet->FromGenome(*genome, FEELER_COUNT, HIDDEN_LAYER_NEURONS, NN_OUTPUT_COUNT);
+		// Every genome shares the layout, so this just repoints the net's layers at the new weights.
+		neuralNet->BindGenome(genome);
 
-		testAgent->SetRotation(DEFAULT_ROTATION);
-		testAgent->SetPosition(DEFAULT_POSITION);
-		testAgent->Attach(neuralNet);
-		testAgent->ClearFailure();
-
-		// Reset the checkpoint flags
-		for (unsigned int i = 0; i < checkpointFlags.size(); i++)
-		{
-			checkpointFlags[i] = Checkpoint_Active;
-		}
+		// Back to the start line with fresh checkpoints.
+		simulation->Reset(neuralNet);
 	}
 
 	void EntityManager::BreedNewPopulation()
 	{
 		genAlg->ClearPopulation();
-		int totalWeights = FEELER_COUNT * HIDDEN_LAYER_NEURONS + HIDDEN_LAYER_NEURONS * NN_OUTPUT_COUNT + HIDDEN_LAYER_NEURONS + NN_OUTPUT_COUNT;
-		genAlg->GenerateNewPopulation(CarDemo::MAX_GENOME_POPULATION, totalWeights);
+		genAlg->GenerateNewPopulation(CarDemo::MAX_GENOME_POPULATION, layout.GetTotalWeights());
+
+		// The old genomes are gone, so the net must stop viewing them.
+		neuralNet->FromGenome(genAlg->GetNextGenome(), layout);
+		simulation->Reset(neuralNet);
 	}
 
 	void EntityManager::EvolveGenomes()
 	{
 		genAlg->BreedPopulation();
+
+		// Generation boundary, snapshot the new population before testing it. The write
+		// happens on a background thread.
+		genAlg->SaveCheckpoint(POPULATION_CHECKPOINT);
+
 		NextTestSubject();
 	}
 
+	void EntityManager::EvaluateGeneration()
+	{
+		if (evaluator == NULL)
+		{
+			evaluator = new PopulationEvaluator(*track, checkpoints, layout);
+		}
+
+		evaluator->Evaluate(*genAlg);
+
+		for (int i = 0; i < genAlg->GetTotalPopulation(); i++)
+		{
+			if (genAlg->GetGenome(i).fitness > bestFitness)
+			{
+				bestFitness = genAlg->GetGenome(i).fitness;
+			}
+		}
+
+		EvolveGenomes();
+	}
+
 	int EntityManager::GetCurrentMemberOfPopulation() const
 	{
 		return genAlg->GetCurrentGenomeIndex();
@@ -225,14 +208,31 @@ namespace CarDemo
 
 	void EntityManager::ExportAllNeuralNetworks()
 	{
+		// The binary snapshot is what a run resumes from, the text nets are for reading
+		// and for loading single genomes elsewhere.
+		genAlg->SaveCheckpoint(POPULATION_CHECKPOINT);
+
+		NeuralNet net;
+		char buff[128] = {0};
+		for (int i = 0; i < genAlg->GetTotalPopulation(); i++)
+		{
+			Genome genome = genAlg->GetGenome(i);
+			if (genome.IsEmpty())
+				continue;
+
+			net.FromGenome(genome, layout);
+			sprintf(buff, "Genome%i.txt", genome.ID);
+			net.ExportNet(buff);
+		}
 	}
 
 	void EntityManager::Render()
 	{
-		testAgent->Render();
+		agentRenderer->Render(simulation->GetAgent());
 
 		// Render the checkpoints.
-		for (unsigned int i = 0; i < checkpoints.size(); i++)
+		const std::vector<CheckpointFlag>& checkpointFlags = simulation->GetCheckpointFlags();
+		for (unsigned int i = 0; i < checkpoints.size() && i < checkpointFlags.size(); i++)
 		{
 			if (checkpointFlags[i] == Checkpoint_Inactive)
 				continue;
@@ -253,7 +253,7 @@ namespace CarDemo
 		char buff[128] = {0};
 		int genomeNumber = genAlg->GetCurrentGenomeIndex();
 
-		sprintf(buff, "Genome: %i of %i", genomeNumber + 1, MAX_GENOME_POPULATION);
+		sprintf(buff, "Genome: %i of %i", genomeNumber + 1, genAlg->GetTotalPopulation());
 		printPos.Set(-(gSettings.WORLD_WIDTH/2),
 						 -(gSettings.WORLD_HEIGHT/2)+90.0f,
 						 0.0f);
@@ -261,7 +261,7 @@ namespace CarDemo
 
 		ZeroMemory(&buff, sizeof(char) * 128);
 		printPos.y -= 18.0f;
-		sprintf(buff, "Fitness: %.2f", this->currentAgentFitness);
+		sprintf(buff, "Fitness: %.2f", simulation->GetFitness());
 		GF1::print(font, printPos, buff);
 
 		ZeroMemory(&buff, sizeof(char) * 128);
@@ -275,71 +275,36 @@ namespace CarDemo
 		GF1::print(font, printPos, buff);
 	}
 
-	const Clarity::Circle& EntityManager::GetAgentSensorBounds()
-	{
-		return testAgent->GetSensorBounds();
-	}
-
-	void EntityManager::TestAgentToPolySections(std::vector<Clarity::LineSegment2> polySections)
+	Clarity::Circle EntityManager::GetAgentSensorBounds()
 	{
-		testAgent->UpdateSensors(polySections);
-		testAgent->CheckForCollision(polySections);
+		return simulation->GetAgent().GetSensorBounds();
 	}
 
 	void EntityManager::Update(float t)
 	{
-		if (testAgent->HasFailed())
+		stepAccumulator += t;
+		while (stepAccumulator >= SIMULATION_TIME_STEP)
 		{
-			if (genAlg->GetCurrentGenomeIndex() == MAX_GENOME_POPULATION - 1)
+			stepAccumulator -= SIMULATION_TIME_STEP;
+
+			const bool running = simulation->Step();
+			if (simulation->GetFitness() > bestFitness)
 			{
-				EvolveGenomes();
-				return;
+				bestFitness = simulation->GetFitness();
 			}
-			NextTestSubject();
-		}
-		// Update the agent.
-		testAgent->Update(t);
-		currentAgentFitness += testAgent->GetDistanceDelta() / 2.0f;
-		if (currentAgentFitness > bestFitness)
-		{
-			bestFitness = currentAgentFitness;
-		}
-
-		std::vector<Clarity::LineSegment2> agentBounds;
-		testAgent->GetLocalBounds(agentBounds);
-		Clarity::Ray2 ray(Clarity::Vector2::ZERO, Clarity::Vector2::ZERO);
-		float distance = 0.0f;
-
-		// Test the agent against the active checkpoints.
-		for (unsigned int i = 0; i < checkpoints.size(); i++)
-		{
-			// See if the checkpoint has already been hit.
-			if (checkpointFlags[i] == Checkpoint_Inactive)
-				continue;
 
-			for (unsigned int j = 0; j < agentBounds.size(); j++)
+			if (!running)
 			{
-				ray.Set(agentBounds[j].GetTail(), agentBounds[j].GetDirection());
-				if (Clarity::Intersects(checkpoints[i], false, ray, &distance))
-				{
-					if (distance < agentBounds[j].GetLength())
-					{
-						currentAgentFitness += CHECK_POINT_BONUS;
-						checkpointFlags[i] = Checkpoint_Inactive;
-						if (currentAgentFitness > bestFitness)
-						{
-							bestFitness = currentAgentFitness;
-						}
-						return;
-					}
-				}
+				FinishEpisode();
 			}
 		}
 	}
 
-	void EntityManager::ForceToNextAgent()
+	void EntityManager::FinishEpisode()
 	{
-		if (genAlg->GetCurrentGenomeIndex() == MAX_GENOME_POPULATION - 1)
+		genAlg->SetGenomeFitness(simulation->GetFitness(), genAlg->GetCurrentGenomeIndex());
+
+		if (genAlg->GetCurrentGenomeIndex() == genAlg->GetTotalPopulation() - 1)
 		{
 			EvolveGenomes();
 			return;
@@ -347,6 +312,11 @@ namespace CarDemo
 		NextTestSubject();
 	}
 
+	void EntityManager::ForceToNextAgent()
+	{
+		FinishEpisode();
+	}
+
 	void EntityManager::Restart()
 	{
 	}
@@ -0,0 +1,98 @@
+//****************************************************************************
+//**
+//**    GACheckpoint.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <stdio.h>
+#include <filesystem>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include "GACheckpoint.h"
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+	static_assert(sizeof(GACheckpointHeader) == 64, "GACheckpointHeader must stay 64 bytes");
+	static_assert(sizeof(GACheckpointGenome) == 8, "GACheckpointGenome must stay 8 bytes");
+
+	CheckpointWriter::CheckpointWriter()
+		: succeeded(true)
+	{
+	}
+
+	CheckpointWriter::~CheckpointWriter()
+	{
+		Wait();
+	}
+
+	bool CheckpointWriter::Write(const char* filenameIn, std::vector<unsigned char>& snapshot)
+	{
+		const bool previous = Wait();
+
+		filename = filenameIn;
+		data.swap(snapshot);
+		snapshot.clear();
+
+		thread = std::thread(&CheckpointWriter::WriteFile, this);
+		return previous;
+	}
+
+	bool CheckpointWriter::Wait()
+	{
+		if (thread.joinable())
+		{
+			thread.join();
+		}
+		return succeeded;
+	}
+
+	void CheckpointWriter::WriteFile()
+	{
+		succeeded = false;
+
+		// A failure here shows up as the fopen failing.
+		const std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+		if (!directory.empty())
+		{
+			std::error_code error;
+			std::filesystem::create_directories(directory, error);
+		}
+
+		std::string temp = filename + ".tmp";
+		FILE* file = fopen(temp.c_str(), "wb");
+		if (file == NULL)
+			return;
+
+		const bool written = data.empty() || fwrite(&data[0], 1, data.size(), file) == data.size();
+		const bool closed = fclose(file) == 0;
+		if (!written || !closed)
+		{
+			remove(temp.c_str());
+			return;
+		}
+
+#if defined(_WIN32)
+		// rename won't replace an existing file on Windows, and removing it first would leave a
+		// moment with no snapshot at all.
+		succeeded = MoveFileExA(temp.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+		succeeded = rename(temp.c_str(), filename.c_str()) == 0;
+#endif
+		if (!succeeded)
+		{
+			remove(temp.c_str());
+		}
+	}
+
+}; // End namespace CarDemo.
\ No newline at end of file
@@ -47,8 +47,11 @@ namespace CarDemo
 		polygon = new TrackPolygon();
 		polygon->LoadPolygon("Resources/Track1Polygon.txt");
 
-		entityManager = new EntityManager();
+		entityManager = new EntityManager(polygon->GetGeometry());
 		entityManager->LoadCheckPoints("Resources/Track1Checkpoints.txt");
+
+		// Pick up where the last run left off. Restarting with R starts from scratch.
+		entityManager->ResumePopulation(POPULATION_CHECKPOINT);
 	}
 
 	GameInterface::~GameInterface()
@@ -124,12 +127,17 @@ namespace CarDemo
 			{
 				entityManager->ForceToNextAgent();
 			}
-			// Test the cars feelers to the track polygon.
+			if (IsKeyHit(KEY_E))
+			{
+				// Run the whole generation headless across every core.
+				entityManager->EvaluateGeneration();
+			}
+			// The simulation does its own collision tests in fixed steps.
 			entityManager->Update(delta * gameTimeScaling);
+
+			// Only highlights the walls near the car.
 			std::vector<Clarity::LineSegment2> polygons;
 			polygon->QueryPossibleCollisions(entityManager->GetAgentSensorBounds(), polygons);
-			entityManager->TestAgentToPolySections(polygons);
-			entityManager->Update(delta * gameTimeScaling);
 		}
 	}
 
@@ -141,7 +149,7 @@ namespace CarDemo
 			entityManager = NULL;
 		}
 
-		entityManager = new EntityManager();
+		entityManager = new EntityManager(polygon->GetGeometry());
 		entityManager->LoadCheckPoints("Resources/Track1Checkpoints.txt");
 	}
 
@@ -9,16 +9,162 @@
 //**
 //****************************************************************************
 
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+
 #include "GeneticAlgorithm.h"
 
 #include "Genome.h"
 #include "NeuralNet.h"
+#include "GACheckpoint.h"
+#include "NetFile.h"
+#include "NetworkLayout.h"
+#include "Selection.h"
 
 #include "GameGlobals.h"
 #include "MemoryLeak.h"
 
 namespace CarDemo 
 {
+	// ----------------------------------------------------------------------
+	// Crossover operators. Each is a small object whose call is inlined into the loop of
+	// BreedChildren, which is compiled once per crossover. Mutation is a separate pass, see
+	// MutateChildren.
+	// ----------------------------------------------------------------------
+
+	// Cuts both parents at one random point and swaps the tails.
+	struct SinglePointCrossover
+	{
+		int totalWeights;
+
+		void operator()(const float* parent1, const float* parent2, float* baby1, float* baby2, RandomStream& random) const
+		{
+			const int crossover = random.NextBelow(totalWeights);
+
+			// Go from start to crossover point, copying the weights from g1.
+			for (int i = 0; i < crossover; i++)
+			{
+				baby1[i] = parent1[i];
+				baby2[i] = parent2[i];
+			}
+			// Go from crossover point to the end, copying the weights from g2 to child.
+			for (int i = crossover; i < totalWeights; i++)
+			{
+				baby1[i] = parent2[i];
+				baby2[i] = parent1[i];
+			}
+		}
+	};
+
+	// Fills [begin, end) of both children, each from its own parent or, if 'swapped', the other's.
+	static inline void CrossSegment(const float* parent1, const float* parent2, float* baby1, float* baby2,
+									int begin, int end, bool swapped)
+	{
+		const size_t bytes = (end - begin) * sizeof(float);
+		memcpy(baby1 + begin, (swapped ? parent2 : parent1) + begin, bytes);
+		memcpy(baby2 + begin, (swapped ? parent1 : parent2) + begin, bytes);
+	}
+
+	// The crossovers below cut only between neuron blocks: 'blocks' neurons, block 'i' running
+	// from splits[i] to splits[i + 1].
+
+	// Swaps the parents' tails at one neuron boundary.
+	struct NeuronPointCrossover
+	{
+		const int* splits;
+		int blocks;
+
+		void operator()(const float* parent1, const float* parent2, float* baby1, float* baby2, RandomStream& random) const
+		{
+			const int crossover = splits[random.NextBelow(blocks)];
+			CrossSegment(parent1, parent2, baby1, baby2, 0, crossover, false);
+			CrossSegment(parent1, parent2, baby1, baby2, crossover, splits[blocks], true);
+		}
+	};
+
+	// Cuts at 'points' different neuron boundaries and alternates the parents between them.
+	struct MultiPointCrossover
+	{
+		const int* splits;
+		int blocks;
+		int points;
+
+		void operator()(const float* parent1, const float* parent2, float* baby1, float* baby2, RandomStream& random) const
+		{
+			// Draws the inner boundaries to cut at, kept in order as they come; a boundary drawn
+			// twice is drawn again.
+			int cuts[MAX_CROSSOVER_POINTS];
+			const int total = std::min(std::min(points, MAX_CROSSOVER_POINTS), blocks - 1);
+			for (int i = 0; i < total; )
+			{
+				const int cut = 1 + random.NextBelow(blocks - 1);
+
+				int j = i;
+				while (j > 0 && cuts[j - 1] > cut)
+				{
+					j--;
+				}
+				if (j > 0 && cuts[j - 1] == cut)
+					continue;
+
+				memmove(cuts + j + 1, cuts + j, (i - j) * sizeof(int));
+				cuts[j] = cut;
+				i++;
+			}
+
+			int start = 0;
+			for (int i = 0; i < total; i++)
+			{
+				CrossSegment(parent1, parent2, baby1, baby2, start, splits[cuts[i]], (i & 1) != 0);
+				start = splits[cuts[i]];
+			}
+			CrossSegment(parent1, parent2, baby1, baby2, start, splits[blocks], (total & 1) != 0);
+		}
+	};
+
+	// Tosses a coin for every neuron. Neighbouring neurons that land the same way are copied
+	// together.
+	struct UniformCrossover
+	{
+		const int* splits;
+		int blocks;
+
+		void operator()(const float* parent1, const float* parent2, float* baby1, float* baby2, RandomStream& random) const
+		{
+			unsigned int coins = 0;
+			int start = 0;
+			bool swapped = false;
+			for (int b = 0; b < blocks; b++)
+			{
+				if ((b & 31) == 0)
+				{
+					coins = random.Next();
+				}
+
+				const bool toss = ((coins >> (b & 31)) & 1) != 0;
+				if (toss != swapped)
+				{
+					CrossSegment(parent1, parent2, baby1, baby2, start, splits[b], swapped);
+					start = splits[b];
+					swapped = toss;
+				}
+			}
+			CrossSegment(parent1, parent2, baby1, baby2, start, splits[blocks], swapped);
+		}
+	};
+
+	struct CopyCrossover
+	{
+		int totalWeights;
+
+		void operator()(const float* parent1, const float* parent2, float* baby1, float* baby2, RandomStream&) const
+		{
+			memcpy(baby1, parent1, totalWeights * sizeof(float));
+			memcpy(baby2, parent2, totalWeights * sizeof(float));
+		}
+	};
 
 	GeneticAlgorithm::GeneticAlgorithm()
 	{
@@ -26,60 +172,77 @@ namespace CarDemo
 		this->totalPopulation = 0;
 		genomeID = 0;
 		generation = 1;
+		totalGenomeWeights = 0;
+		checkpointWriter = new CheckpointWriter();
+
+		// Seeded from the thread's stream, so the run's seed fixes the GA too.
+		SetSeed(ThreadRandom().Next64());
 	}
 
 	GeneticAlgorithm::~GeneticAlgorithm()
 	{
+		if (checkpointWriter != NULL)
+		{
+			delete checkpointWriter;
+			checkpointWriter = NULL;
+		}
 		ClearPopulation();
 	}
 
-	Genome* GeneticAlgorithm::GetNextGenome()
+	void GeneticAlgorithm::SetSeed(unsigned long long seed)
 	{
-		currentGenome++;
-		if (currentGenome >= population.size())
-			return NULL;
+		random.Seed(seed);
+	}
 
-		return population[this->currentGenome];
+	void GeneticAlgorithm::AllocatePopulation()
+	{
+		const unsigned int totalFloats = totalPopulation * totalGenomeWeights;
+		weights.resize(totalFloats);
+		childWeights.resize(totalFloats);
+		fitnesses.resize(totalPopulation);
+		IDs.resize(totalPopulation);
+		childIDs.resize(totalPopulation);
+		sigmas.resize(totalPopulation, policy.mutationSigma);
+		childSigmas.resize(totalPopulation, policy.mutationSigma);
+		spareChild.resize(totalGenomeWeights);
 	}
 
-	Genome* GeneticAlgorithm::GetBestGenome()
+	float* GeneticAlgorithm::GetChildWeights(int child)
 	{
-		int bestGenome = -1;
-		float fitness = 0;
-		for (unsigned int i = 0; i < population.size(); i++)
-		{
-			if (population[i]->fitness > fitness)
-			{
-				fitness = population[i]->fitness;
-				bestGenome = i;
-			}
-		}
+		return &childWeights[child * totalGenomeWeights];
+	}
 
-		return population[bestGenome];
+	void GeneticAlgorithm::SwapPopulations()
+	{
+		// Only the buffers trade places, nothing is copied or allocated.
+		weights.swap(childWeights);
+		IDs.swap(childIDs);
+		sigmas.swap(childSigmas);
+		fitnesses.assign(totalPopulation, 0.0f);
 	}
 
-	Genome* GeneticAlgorithm::GetWorstGenome()
+	Genome GeneticAlgorithm::GetNextGenome()
 	{
-		int worstGenome = -1;
-		float fitness = 1000000;
-		for (unsigned int i = 0; i < population.size(); i++)
-		{
-			if (population[i]->fitness < fitness)
-			{
-				fitness = population[i]->fitness;
-				worstGenome = i;
-			}
-		}
+		currentGenome++;
+		return GetGenome(currentGenome);
+	}
+
+	Genome GeneticAlgorithm::GetBestGenome() const
+	{
+		return GetGenome(SelectBest(fitnesses.data(), totalPopulation));
+	}
 
-		return population[worstGenome];
+	Genome GeneticAlgorithm::GetWorstGenome() const
+	{
+		return GetGenome(SelectWorst(fitnesses.data(), totalPopulation));
 	}
 	
-	Genome* GeneticAlgorithm::GetGenome(int index)
+	Genome GeneticAlgorithm::GetGenome(int index) const
 	{
-		if (index >= totalPopulation)
-			return NULL;
+		if (index < 0 || index >= (int)totalPopulation || totalGenomeWeights <= 0)
+			return Genome();
 
-		return population[index];
+		return Genome(IDs[index], fitnesses[index], &weights[index * totalGenomeWeights], totalGenomeWeights);
 	}
 
 	int GeneticAlgorithm::GetCurrentGenomeIndex() const
@@ -89,7 +252,7 @@ namespace CarDemo
 
 	int GeneticAlgorithm::GetCurrentGenomeID() const
 	{
-		return population[currentGenome]->ID;
+		return IDs[currentGenome];
 	}
 
 	int GeneticAlgorithm::GetCurrentGeneration() const
@@ -102,100 +265,227 @@ namespace CarDemo
 		return totalPopulation;
 	}
 
+	int GeneticAlgorithm::GetTotalWeights() const
+	{
+		return totalGenomeWeights;
+	}
+
+	const float* GeneticAlgorithm::GetPopulationWeights() const
+	{
+		if (weights.empty())
+			return NULL;
+
+		return &weights[0];
+	}
+
 	void GeneticAlgorithm::GenerateCrossoverSplits(int neuronsPerHidden, int inputs, int outputs)
 	{
-		// Unimplemented
+		GenerateCrossoverSplits(NetworkLayout(1, inputs, neuronsPerHidden, outputs));
+	}
+
+	void GeneticAlgorithm::GenerateCrossoverSplits(const NetworkLayout& layout)
+	{
+		crossoverSplits.clear();
+		for (int i = 0; i < layout.GetTotalLayers(); i++)
+		{
+			// Each neuron is a row of its inputs' weights and the bias.
+			const LayerLayout& layer = layout.GetLayer(i);
+			for (int n = 0; n < layer.neurons; n++)
+			{
+				crossoverSplits.push_back(layer.offset + n * (layer.inputs + 1));
+			}
+		}
+		crossoverSplits.push_back(layout.GetTotalWeights());
 	}
 	
-	void GeneticAlgorithm::GetBestCases(int totalGenomes, std::vector<Genome*> &out)
+	void GeneticAlgorithm::SetBreedingPolicy(const BreedingPolicy& policyIn)
+	{
+		policy = policyIn;
+	}
+
+	const BreedingPolicy& GeneticAlgorithm::GetBreedingPolicy() const
+	{
+		return policy;
+	}
+
+	void GeneticAlgorithm::SelectParents(int pairs)
 	{
-		int genomeCount = 0;
-		int runCount = 0;
+		const float* fitness = fitnesses.data();
+		const int picks = pairs * 2;
 
-		while (genomeCount < totalGenomes)
+		switch (policy.selection)
 		{
-			if (runCount > 10)
-				return;
+		case SELECTION_TOURNAMENT:
+			SelectTournament(fitness, totalPopulation, policy.selectionSize, picks, random, parents);
+			break;
 
-			runCount++;
+		case SELECTION_RANKED:
+			SelectRanked(fitness, totalPopulation, policy.rankPressure, picks, random, parents);
+			break;
 
-			// Find the best cases for cross breeding based on fitness score.
-			float bestFitness = 0;
-			int bestIndex = -1;
-			for (unsigned int i = 0; i < this->totalPopulation; i++)
+		case SELECTION_STOCHASTIC_UNIVERSAL:
+			SelectStochasticUniversal(fitness, totalPopulation, picks, random, parents);
+			break;
+
+		default:
 			{
-				if (population[i]->fitness > bestFitness)
+				// Every pairing of the fittest in turn: 0 with 1, 2, 3..., then 1 with 2, 3...,
+				// and round again if there are more pairs to make than pairings.
+				const int truncation = std::min(std::max(policy.selectionSize, 1), (int)bestCases.size());
+				int first = 0;
+				int second = std::min(1, truncation - 1);
+
+				parents.clear();
+				for (int i = 0; i < pairs; i++)
 				{
-					bool isUsed = false;
+					parents.push_back(bestCases[first]);
+					parents.push_back(bestCases[second]);
 
-					for (unsigned int j = 0; j < out.size(); j++)
+					second++;
+					if (second >= truncation)
 					{
-						if (out[j]->ID == population[i]->ID)
+						first++;
+						second = first + 1;
+						if (second >= truncation)
 						{
-							isUsed = true;
+							first = 0;
+							second = std::min(1, truncation - 1);
 						}
 					}
-
-					if (isUsed == false)
-					{
-						bestIndex = i;
-						bestFitness = population[bestIndex]->fitness;
-					}
 				}
 			}
-
-			if (bestIndex != -1)
-			{
-				genomeCount++;
-				out.push_back(population[bestIndex]);
-			}
-
+			break;
 		}
 	}
 
-	
-	void GeneticAlgorithm::CrossBreed(Genome* g1, Genome* g2, Genome* &baby1, Genome* &baby2)
+	template <class Crossover>
+	void GeneticAlgorithm::BreedChildren(const Crossover& crossover, int first, int end)
 	{
-		// Select a random cross over point.
-		unsigned int totalWeights = g1->weights.size();
-		unsigned int crossover = rand() % totalWeights;
+		for (int child = first, pair = 0; child < end; child += 2, pair++)
+		{
+			const int mother = parents[pair * 2];
+			const int father = parents[pair * 2 + 1];
+			const bool hasSecond = child + 1 < end;
+			float* baby1 = GetChildWeights(child);
+			float* baby2 = hasSecond ? GetChildWeights(child + 1) : &spareChild[0];
 
-		baby1 = new Genome();
-		baby1->ID = genomeID;
-		baby1->weights.resize(totalWeights);
-		genomeID++;
+			crossover(&weights[mother * totalGenomeWeights], &weights[father * totalGenomeWeights], baby1, baby2, random);
 
-		baby2 = new Genome();
-		baby2->ID = genomeID;
-		baby2->weights.resize(totalWeights);
-		genomeID++;
+			// Both children start from the geometric mean of their parents' sigmas.
+			const float sigma = std::sqrt(sigmas[mother] * sigmas[father]);
+
+			childIDs[child] = genomeID;
+			childSigmas[child] = sigma;
+			genomeID++;
+
+			if (hasSecond)
+			{
+				childIDs[child + 1] = genomeID;
+				childSigmas[child + 1] = sigma;
+				genomeID++;
+			}
+		}
+
+		MutateChildren(first, end);
+	}
 
-		// Go from start to crossover point, copying the weights from g1.
-		for (unsigned int i = 0; i < crossover; i++)
+	void GeneticAlgorithm::BreedChildren(int first, int end)
+	{
+		if (crossoverSplits.empty() || crossoverSplits.back() != totalGenomeWeights)
 		{
-			baby1->weights[i] = g1->weights[i];
-			baby2->weights[i] = g2->weights[i];
+			// No layout to go by, so every weight is a block of its own.
+			crossoverSplits.resize(totalGenomeWeights + 1);
+			for (int i = 0; i <= totalGenomeWeights; i++)
+			{
+				crossoverSplits[i] = i;
+			}
 		}
-		// Go from start to crossover point, copying the weights from g2 to child.
-		for (unsigned int i = crossover; i < totalWeights; i++)
+
+		const int* splits = &crossoverSplits[0];
+		const int blocks = crossoverSplits.size() - 1;
+
+		switch (policy.crossover)
 		{
-			baby1->weights[i] = g2->weights[i];
-			baby2->weights[i] = g1->weights[i];
+		case CROSSOVER_NEURON_POINT:
+			{
+				const NeuronPointCrossover crossover = { splits, blocks };
+				BreedChildren(crossover, first, end);
+			}
+			break;
+
+		case CROSSOVER_MULTI_POINT:
+			{
+				const MultiPointCrossover crossover = { splits, blocks, policy.crossoverPoints };
+				BreedChildren(crossover, first, end);
+			}
+			break;
+
+		case CROSSOVER_UNIFORM:
+			{
+				const UniformCrossover crossover = { splits, blocks };
+				BreedChildren(crossover, first, end);
+			}
+			break;
+
+		case CROSSOVER_NONE:
+			{
+				const CopyCrossover crossover = { totalGenomeWeights };
+				BreedChildren(crossover, first, end);
+			}
+			break;
+
+		default:
+			{
+				const SinglePointCrossover crossover = { totalGenomeWeights };
+				BreedChildren(crossover, first, end);
+			}
+			break;
 		}
 	}
 
-	Genome* GeneticAlgorithm::CreateNewGenome(unsigned int totalWeights)
+	void GeneticAlgorithm::MutateChildren(int first, int end)
 	{
-		Genome* genome = new Genome();
-		genome->ID = genomeID;
-		genome->fitness = 0.0f;
-		genome->weights.resize(totalWeights);
-		for (unsigned int j = 0; j < totalWeights; j++)
+		const int count = end - first;
+		if (count <= 0)
+			return;
+
+		switch (policy.mutation)
 		{
-			genome->weights[j] = RandomClamped();
+		case MUTATION_UNIFORM:
+			ApplyMutation(GetUniformMutationKernel(), GetChildWeights(first), count * totalGenomeWeights,
+						  policy.mutationRate, policy.maxPerturbation, mutationLanes);
+			break;
+
+		case MUTATION_GAUSSIAN:
+			ApplyMutation(GetGaussianMutationKernel(), GetChildWeights(first), count * totalGenomeWeights,
+						  policy.mutationRate, policy.mutationSigma, mutationLanes);
+			break;
+
+		case MUTATION_SELF_ADAPTIVE:
+			{
+				// Each genome's sigma moves first, so the weights are disturbed by the new one.
+				const MutationKernel kernel = GetGaussianMutationKernel();
+				const float tau = 1.0f / std::sqrt((float)totalGenomeWeights);
+				for (int child = first; child < end; child++)
+				{
+					const float sigma = std::max(childSigmas[child] * std::exp(tau * random.NextGaussian()), policy.minimumSigma);
+					childSigmas[child] = sigma;
+					ApplyMutation(kernel, GetChildWeights(child), totalGenomeWeights, policy.mutationRate, sigma, mutationLanes);
+				}
+			}
+			break;
+
+		default:
+			break;
 		}
+	}
+
+	void GeneticAlgorithm::CreateNewGenome(int child)
+	{
+		childIDs[child] = genomeID;
+		childSigmas[child] = policy.mutationSigma;
+		random.FillClamped(GetChildWeights(child), totalGenomeWeights);
 		genomeID++;
-		return genome;
 	}
 
 	void GeneticAlgorithm::GenerateNewPopulation(unsigned int totalPop, unsigned int totalWeights)
@@ -204,83 +494,78 @@ namespace CarDemo
 		ClearPopulation();
 		currentGenome = -1;
 		totalPopulation = totalPop;
-		population.resize(totalPop);
-		for (unsigned int i = 0; i < population.size(); i++)
+		totalGenomeWeights = totalWeights;
+		AllocatePopulation();
+
+		// Each genome gets a stream of its own, so its weights depend only on the seed and
+		// its place in the population, not on how many draws the genomes before it took.
+		std::vector<RandomStream> streams(totalPop);
+		if (totalPop > 0)
+		{
+			random.Split(&streams[0], totalPop);
+		}
+
+		for (unsigned int i = 0; i < totalPopulation; i++)
 		{
-			Genome* genome = new Genome();
-			genome->ID = genomeID;
-			genome->fitness = 0.0f;
-			genome->weights.resize(totalWeights);
-			for (unsigned int j = 0; j < totalWeights; j++)
+			IDs[i] = genomeID;
+			fitnesses[i] = 0.0f;
+			sigmas[i] = policy.mutationSigma;
+			if (totalWeights > 0)
 			{
-				genome->weights[j] = RandomClamped();
+				streams[i].FillClamped(&weights[i * totalWeights], totalWeights);
 			}
 			genomeID++;
-			population[i] = genome;
 		}
 	}
 
 	void GeneticAlgorithm::BreedPopulation()
 	{
-		std::vector<Genome*> bestGenomes;
-
-		// Find the 4 best genomes.
-		this->GetBestCases(4, bestGenomes);
-
-		// Breed them with each other twice to form 3*2 + 2*2 + 1*2 = 12 children
-		std::vector<Genome*> children;
-
-		// Carry on the best dude.
-		Genome* bestDude = new Genome();
-		bestDude->fitness = 0.0f;
-		bestDude->ID = bestGenomes[0]->ID;
-		bestDude->weights = bestGenomes[0]->weights;
-		Mutate(bestDude);
-		children.push_back(bestDude);
-
-		// Child genomes.
-		Genome* baby1 = NULL;
-		Genome* baby2 = NULL;
-
-		// Breed with genome 0.
-		CrossBreed(bestGenomes[0], bestGenomes[1], baby1, baby2);
-		Mutate(baby1);
-		Mutate(baby2);
-		children.push_back(baby1);
-		children.push_back(baby2);
-		CrossBreed(bestGenomes[0], bestGenomes[2], baby1, baby2);
-		Mutate(baby1);
-		Mutate(baby2);
-		children.push_back(baby1);
-		children.push_back(baby2);
-		CrossBreed(bestGenomes[0], bestGenomes[3], baby1, baby2);
-		Mutate(baby1);
-		Mutate(baby2);
-		children.push_back(baby1);
-		children.push_back(baby2);
-
-		// Breed with genome 1.
-		CrossBreed(bestGenomes[1], bestGenomes[2], baby1, baby2);
-		Mutate(baby1);
-		Mutate(baby2);
-		children.push_back(baby1);
-		children.push_back(baby2);
-		CrossBreed(bestGenomes[1], bestGenomes[3], baby1, baby2);
-		Mutate(baby1);
-		Mutate(baby2);
-		children.push_back(baby1);
-		children.push_back(baby2);
+		const int population = totalPopulation;
+		if (population <= 0 || totalGenomeWeights <= 0)
+			return;
 
-		// For the remainding n population, add some random kiddies.
-		unsigned int remainingChildren = (totalPopulation - children.size());
-		for (unsigned int i = 0; i < remainingChildren; i++)
+		const int elites = std::min(std::max(policy.eliteCount, 0), population);
+		const int immigrants = std::min(std::max((int)(policy.immigrantFraction * population + 0.5f), 0), population - elites);
+		const int bred = population - elites - immigrants;
+
+		// Find the elites, and for truncation selection the pool of parents too.
+		int best = elites;
+		if (policy.selection == SELECTION_TRUNCATION)
 		{
+			best = std::max(best, std::max(policy.selectionSize, 1));
+		}
+		SelectElites(fitnesses.data(), population, best, bestCases);
+
+		mutationLanes.Seed(random);
 
-			children.push_back(this->CreateNewGenome(bestGenomes[0]->weights.size()));
+		int child = 0;
+
+		// Carry on the best dudes.
+		for (; child < elites; child++)
+		{
+			childIDs[child] = IDs[bestCases[child]];
+			childSigmas[child] = sigmas[bestCases[child]];
+			memcpy(GetChildWeights(child), &weights[bestCases[child] * totalGenomeWeights], totalGenomeWeights * sizeof(float));
+		}
+		if (policy.mutateElites)
+		{
+			MutateChildren(0, elites);
 		}
 
-		ClearPopulation();
-		population = children;
+		if (bred > 0)
+		{
+			SelectParents((bred + 1) / 2);
+			BreedChildren(child, child + bred);
+			child += bred;
+		}
+
+		// For the remainding n population, add some random kiddies.
+		for (; child < population; child++)
+		{
+			this->CreateNewGenome(child);
+		}
+
+		SwapPopulations();
 
 		currentGenome = -1;
 		generation++;
@@ -288,37 +573,164 @@ namespace CarDemo
 
 	void GeneticAlgorithm::ClearPopulation()
 	{
-		for (unsigned int i = 0; i < population.size(); i++)
+		// The arenas keep their memory for the next population.
+		totalPopulation = 0;
+		weights.clear();
+		childWeights.clear();
+		fitnesses.clear();
+		IDs.clear();
+		childIDs.clear();
+		sigmas.clear();
+		childSigmas.clear();
+	}
+
+
+	void GeneticAlgorithm::SetGenomeFitness(float fitness, int index)
+	{
+		if (index < 0 || index >= (int)totalPopulation)
+			return;
+
+		fitnesses[index] = fitness;
+	}
+	
+	void GeneticAlgorithm::SaveState(std::vector<unsigned char> &out) const
+	{
+		const unsigned int genomeBytes = totalPopulation * sizeof(GACheckpointGenome);
+		const unsigned int weightBytes = totalPopulation * totalGenomeWeights * sizeof(float);
+		const unsigned int sigmaBytes = totalPopulation * sizeof(float);
+		const unsigned int size = sizeof(GACheckpointHeader) + genomeBytes + weightBytes + sigmaBytes;
+
+		out.assign(size, 0);
+
+		GACheckpointGenome* genomes = (GACheckpointGenome*)&out[sizeof(GACheckpointHeader)];
+		for (unsigned int i = 0; i < totalPopulation; i++)
 		{
-			if (population[i] != NULL)
-			{
-				delete population[i];
-				population[i] = NULL;
-			}
+			genomes[i].ID = IDs[i];
+			genomes[i].fitness = fitnesses[i];
 		}
 
-		population.clear();
+		// The arena is already laid out exactly like the file.
+		if (weightBytes > 0)
+		{
+			memcpy(&out[sizeof(GACheckpointHeader) + genomeBytes], &weights[0], weightBytes);
+		}
+		if (sigmaBytes > 0)
+		{
+			memcpy(&out[sizeof(GACheckpointHeader) + genomeBytes + weightBytes], &sigmas[0], sigmaBytes);
+		}
+
+		GACheckpointHeader* header = (GACheckpointHeader*)&out[0];
+		header->magic = GA_CHECKPOINT_MAGIC;
+		header->version = GA_CHECKPOINT_VERSION;
+		header->fileSize = size;
+		header->generation = generation;
+		header->genomeID = genomeID;
+		header->currentGenome = currentGenome;
+		header->totalPopulation = totalPopulation;
+		header->totalWeights = totalGenomeWeights;
+		random.GetState(header->randomState);
+		header->checksum = NetFileChecksum(&out[sizeof(GACheckpointHeader)], size - sizeof(GACheckpointHeader));
 	}
 
+	bool GeneticAlgorithm::LoadState(const unsigned char* data, unsigned int size)
+	{
+		if (data == NULL || size < sizeof(GACheckpointHeader))
+			return false;
+
+		GACheckpointHeader header;
+		memcpy(&header, data, sizeof(header));
+		if (header.magic != GA_CHECKPOINT_MAGIC || header.version < GA_CHECKPOINT_VERSION_XORSHIFT ||
+			header.version > GA_CHECKPOINT_VERSION || header.fileSize != size)
+		{
+			return false;
+		}
+
+		const unsigned long long genomeBytes = (unsigned long long)header.totalPopulation * sizeof(GACheckpointGenome);
+		const unsigned long long weightBytes = (unsigned long long)header.totalPopulation * header.totalWeights * sizeof(float);
+		const unsigned long long sigmaBytes = header.version > GA_CHECKPOINT_VERSION_NO_SIGMAS ?
+			(unsigned long long)header.totalPopulation * sizeof(float) : 0;
+		if (sizeof(GACheckpointHeader) + genomeBytes + weightBytes + sigmaBytes != size ||
+			NetFileChecksum(data + sizeof(GACheckpointHeader), size - sizeof(GACheckpointHeader)) != header.checksum)
+		{
+			return false;
+		}
+
+		ClearPopulation();
 
-	void GeneticAlgorithm::Mutate(Genome* genome)
+		totalPopulation = header.totalPopulation;
+		totalGenomeWeights = header.totalWeights;
+		AllocatePopulation();
+
+		const unsigned char* genomes = data + sizeof(GACheckpointHeader);
+		for (unsigned int i = 0; i < totalPopulation; i++)
+		{
+			GACheckpointGenome entry;
+			memcpy(&entry, genomes + i * sizeof(GACheckpointGenome), sizeof(entry));
+			IDs[i] = entry.ID;
+			fitnesses[i] = entry.fitness;
+		}
+
+		if (weightBytes > 0)
+		{
+			memcpy(&weights[0], genomes + genomeBytes, (size_t)weightBytes);
+		}
+		if (sigmaBytes > 0)
+		{
+			memcpy(&sigmas[0], genomes + genomeBytes + weightBytes, (size_t)sigmaBytes);
+		}
+
+		generation = header.generation;
+		genomeID = header.genomeID;
+		currentGenome = header.currentGenome;
+		if (header.version == GA_CHECKPOINT_VERSION_XORSHIFT)
+		{
+			// The old 64 bit xorshift state; it seeds the new generator, so the run carries on
+			// with different draws than it would have.
+			random.Seed(((unsigned long long)header.randomState[1] << 32) | header.randomState[0]);
+		}
+		else
+		{
+			random.SetState(header.randomState);
+		}
+		return true;
+	}
+
+	bool GeneticAlgorithm::SaveCheckpoint(const char* filename)
+	{
+		std::vector<unsigned char> snapshot;
+		SaveState(snapshot);
+		return checkpointWriter->Write(filename, snapshot);
+	}
+
+	bool GeneticAlgorithm::WaitForCheckpoint()
+	{
+		return checkpointWriter->Wait();
+	}
+
+	bool GeneticAlgorithm::LoadCheckpoint(const char* filename)
 	{
-		for (unsigned int i = 0; i < genome->weights.size(); ++i)
+		FILE* file = fopen(filename, "rb");
+		if (file == NULL)
+			return false;
+
+		std::vector<unsigned char> data;
+		fseek(file, 0, SEEK_END);
+		const long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		if (size > 0)
 		{
-			// Generate a random chance of mutating the weight in the genome.
-			if (RandomClamped() < CarDemo::MUTATION_RATE)
+			data.resize(size);
+			if (fread(&data[0], 1, size, file) != (size_t)size)
 			{
-				genome->weights[i] += (RandomClamped() * MAX_PERBETUATION);
+				data.clear();
 			}
 		}
-	}
-	
-	void GeneticAlgorithm::SetGenomeFitness(float fitness, int index)
-	{
-		if (index >= population.size())
-			return;
+		fclose(file);
+
+		if (data.empty())
+			return false;
 
-		population[index]->fitness = fitness;
+		return LoadState(&data[0], data.size());
 	}
 	
 }; // End namespace CarDemo.
@@ -0,0 +1,217 @@
+//****************************************************************************
+//**
+//**    HeadlessMain.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+// Console trainer built on the headless simulation core, no window, GF1 or Win32 needed.
+// Runs whole generations as fast as the cores allow and leaves the population checkpoint
+// behind for the game to resume from, in ExportedNNs (made if it's missing). A checkpoint
+// that can't be written stops the run.
+//
+//    headless_trainer [-track file] [-checkpoints file] [-generations n] [-threads n]
+//                     [-sdf cellSize] [-sdf-validate cellSize] [-seed n]
+//                     [-population n] [-elites n] [-immigrants fraction]
+//                     [-selection truncation|tournament|ranked|sus] [-selection-size n]
+//                     [-crossover single-point|neuron|multi-point|uniform|none]
+//                     [-crossover-points n] [-mutation uniform|none|gaussian|self-adaptive]
+//                     [-mutation-rate rate] [-mutation-sigma sigma]
+//
+// The population and breeding flags set the GA's BreedingPolicy, see BreedingPolicy.h for
+// what each does; left out, they breed the way the game does. -mutation-rate is the chance a
+// weight moves for gaussian mutation, uniform mutation keeps the game's original odds.
+// -seed picks the run's random numbers; the same seed and population always train the same.
+// -sdf senses and collides through a distance field of the track, cached in ExportedNNs.
+// -sdf-validate just reports how far such a field strays from the exact tests and exits.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "BreedingPolicy.h"
+#include "DistanceField.h"
+#include "EntityManager.h"
+#include "GeneticAlgorithm.h"
+#include "Genome.h"
+#include "PopulationEvaluator.h"
+#include "RandomStream.h"
+#include "Simulation.h"
+#include "TrackGeometry.h"
+
+#include "MemoryLeak.h"
+
+using namespace CarDemo;
+
+int main(int argc, char** argv)
+{
+	const char* trackFile = "Resources/Track1Polygon.txt";
+	const char* checkpointFile = "Resources/Track1Checkpoints.txt";
+	int generations = 100;
+	int threads = 0;
+	float fieldCellSize = 0.0f;
+	bool validateField = false;
+	unsigned long long seed = DEFAULT_RANDOM_SEED;
+	int population = MAX_GENOME_POPULATION;
+	BreedingPolicy policy;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "-track") == 0)
+			trackFile = argv[i + 1];
+		else if (strcmp(argv[i], "-checkpoints") == 0)
+			checkpointFile = argv[i + 1];
+		else if (strcmp(argv[i], "-generations") == 0)
+			generations = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-threads") == 0)
+			threads = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-sdf") == 0)
+			fieldCellSize = (float)atof(argv[i + 1]);
+		else if (strcmp(argv[i], "-sdf-validate") == 0)
+		{
+			fieldCellSize = (float)atof(argv[i + 1]);
+			validateField = true;
+		}
+		else if (strcmp(argv[i], "-seed") == 0)
+			seed = strtoull(argv[i + 1], NULL, 0);
+		else if (strcmp(argv[i], "-population") == 0)
+			population = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-elites") == 0)
+			policy.eliteCount = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-immigrants") == 0)
+			policy.immigrantFraction = (float)atof(argv[i + 1]);
+		else if (strcmp(argv[i], "-selection-size") == 0)
+			policy.selectionSize = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-crossover-points") == 0)
+			policy.crossoverPoints = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-mutation-rate") == 0)
+			policy.mutationRate = (float)atof(argv[i + 1]);
+		else if (strcmp(argv[i], "-mutation-sigma") == 0)
+			policy.mutationSigma = (float)atof(argv[i + 1]);
+		else if ((strcmp(argv[i], "-selection") == 0 && !ParseSelection(argv[i + 1], policy.selection)) ||
+				 (strcmp(argv[i], "-crossover") == 0 && !ParseCrossover(argv[i + 1], policy.crossover)) ||
+				 (strcmp(argv[i], "-mutation") == 0 && !ParseMutation(argv[i + 1], policy.mutation)))
+		{
+			printf("Unknown operator '%s' for %s.\n", argv[i + 1], argv[i]);
+			return 1;
+		}
+	}
+
+	if (population < 1)
+	{
+		printf("The population needs at least one genome.\n");
+		return 1;
+	}
+
+	SetRandomSeed(seed);
+	printf("Seed %llu.\n", seed);
+
+	TrackGeometry track;
+	if (!track.Load(trackFile))
+	{
+		printf("Couldn't load track '%s'.\n", trackFile);
+		return 1;
+	}
+
+	DistanceField field;
+	if (fieldCellSize > 0.0f)
+	{
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if (!field.LoadOrBuild(track, trackFile, fieldCellSize, FEELER_LENGTH))
+		{
+			printf("Couldn't build a distance field for '%s'.\n", trackFile);
+			return 1;
+		}
+
+		const std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - start;
+		printf("Distance field %i x %i, %.3fs.\n", field.GetColumns(), field.GetRows(), elapsed.count());
+
+		if (validateField)
+		{
+			DistanceFieldReport report;
+			ValidateDistanceField(track, field, report);
+			printf("Feelers: %i rays, mean error %.3f, max error %.3f, %.1f%% within a cell.\n", report.rays,
+				   report.meanDepthError, report.maxDepthError, report.rays > 0 ? 100.0f * report.raysWithinCell / report.rays : 0.0f);
+			printf("Collisions: %i bodies, %i missed, %i false.\n", report.bodies, report.missedCollisions,
+				   report.falseCollisions);
+			return 0;
+		}
+
+		track.SetDistanceField(&field);
+	}
+
+	std::vector<Checkpoint> checkpoints;
+	if (!LoadCheckpoints(checkpointFile, checkpoints))
+	{
+		printf("Couldn't load checkpoints '%s'.\n", checkpointFile);
+		return 1;
+	}
+
+	NetworkLayout layout(1, FEELER_COUNT, HIDDEN_LAYER_NEURONS, NN_OUTPUT_COUNT);
+
+	GeneticAlgorithm genAlg;
+	genAlg.SetBreedingPolicy(policy);
+	genAlg.GenerateCrossoverSplits(layout);
+	genAlg.GenerateNewPopulation(population, layout.GetTotalWeights());
+	if (genAlg.LoadCheckpoint(POPULATION_CHECKPOINT))
+	{
+		if (genAlg.GetTotalPopulation() != population ||
+			genAlg.GetTotalWeights() != layout.GetTotalWeights())
+		{
+			// Saved from a different topology, start over.
+			genAlg.GenerateNewPopulation(population, layout.GetTotalWeights());
+		}
+		else
+		{
+			printf("Resumed generation %i.\n", genAlg.GetCurrentGeneration());
+		}
+	}
+
+	PopulationEvaluator evaluator(track, checkpoints, layout, threads);
+	printf("Training %i genomes on %i threads, %s selection, %s crossover, %s mutation.\n", population,
+		   evaluator.GetThreadCount(), GetSelectionName(policy.selection), GetCrossoverName(policy.crossover),
+		   GetMutationName(policy.mutation));
+
+	for (int i = 0; i < generations; i++)
+	{
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		evaluator.Evaluate(genAlg);
+
+		float best = 0.0f;
+		float total = 0.0f;
+		for (int j = 0; j < genAlg.GetTotalPopulation(); j++)
+		{
+			const float fitness = genAlg.GetGenome(j).fitness;
+			total += fitness;
+			if (fitness > best)
+				best = fitness;
+		}
+
+		const std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - start;
+		printf("Generation %i: best %.2f, average %.2f, %.3fs\n", genAlg.GetCurrentGeneration(), best,
+			   total / genAlg.GetTotalPopulation(), elapsed.count());
+
+		genAlg.BreedPopulation();
+
+		// Training on without checkpoints would lose the run to the first preemption.
+		if (!genAlg.SaveCheckpoint(POPULATION_CHECKPOINT))
+		{
+			printf("Couldn't write '%s', stopping.\n", POPULATION_CHECKPOINT);
+			genAlg.WaitForCheckpoint();
+			return 1;
+		}
+	}
+
+	if (!genAlg.WaitForCheckpoint())
+	{
+		printf("Couldn't write '%s'.\n", POPULATION_CHECKPOINT);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,707 @@
+//****************************************************************************
+//**
+//**    LayerKernels.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <atomic>
+#include <string.h>
+
+#include "LayerKernels.h"
+#include "NLayer.h"
+
+#if defined(CARDEMO_X86)
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+	// The level set by SetKernelLevel, or -1 for the best the CPU supports. Every pool worker
+	// reads it, so it's atomic; the kernels themselves are looked up from it on each call.
+	static std::atomic<int> gKernelLevel(-1);
+
+	// Sums the remaining inputs of one row that did not fit in a full vector, plus the bias.
+	inline float RowTail(const float* row, int start, int inputs, const float* input)
+	{
+		float sum = 0.0f;
+		for (int j = start; j < inputs; j++)
+		{
+			sum += row[j] * input[j];
+		}
+		return sum + row[inputs] * BIAS;
+	}
+
+	void DenseLayerScalar(const float* weights, int neurons, int inputs, const float* input, float* out)
+	{
+		const int stride = inputs + 1;
+		for (int i = 0; i < neurons; i++)
+		{
+			out[i] = RowTail(weights + i * stride, 0, inputs, input);
+		}
+	}
+
+	// RowTail for a row of half floats.
+	inline float HalfRowTail(const unsigned short* row, int start, int inputs, const float* input)
+	{
+		float sum = 0.0f;
+		for (int j = start; j < inputs; j++)
+		{
+			sum += HalfToFloat(row[j]) * input[j];
+		}
+		return sum + HalfToFloat(row[inputs]) * BIAS;
+	}
+
+	void DenseHalfScalar(const unsigned short* weights, int neurons, int inputs, const float* input, float* out)
+	{
+		const int stride = inputs + 1;
+		for (int i = 0; i < neurons; i++)
+		{
+			out[i] = HalfRowTail(weights + i * stride, 0, inputs, input);
+		}
+	}
+
+	void DenseBatchScalar(const float* weights, int neurons, int inputs, const float* input, int count, float* out)
+	{
+		const int stride = inputs + 1;
+		for (int n = 0; n < neurons; n++)
+		{
+			const float* row = weights + n * stride;
+			float* dest = out + n * count;
+			const float bias = row[inputs] * BIAS;
+
+			for (int a = 0; a < count; a++)
+			{
+				dest[a] = bias;
+			}
+
+			for (int j = 0; j < inputs; j++)
+			{
+				const float w = row[j];
+				const float* x = input + j * count;
+				for (int a = 0; a < count; a++)
+				{
+					dest[a] += w * x[a];
+				}
+			}
+		}
+	}
+
+	void DenseInt8Scalar(const signed char* weights, int neurons, int stride, const short* input, int* out)
+	{
+		for (int n = 0; n < neurons; n++)
+		{
+			const signed char* row = weights + n * stride;
+			int sum = 0;
+			for (int j = 0; j < stride; j++)
+			{
+				sum += row[j] * input[j];
+			}
+			out[n] = sum;
+		}
+	}
+
+#if defined(CARDEMO_X86)
+
+	KERNEL_TARGET_SSE2
+	void DenseInt8SSE2(const signed char* weights, int neurons, int stride, const short* input, int* out)
+	{
+		for (int n = 0; n < neurons; n++)
+		{
+			const signed char* row = weights + n * stride;
+			__m128i acc = _mm_setzero_si128();
+
+			for (int j = 0; j < stride; j += 16)
+			{
+				// SSE2 has no sign extending load, so duplicate each byte into both halves of a
+				// 16 bit lane and shift the copy back down arithmetically.
+				const __m128i w = _mm_loadu_si128((const __m128i*)(row + j));
+				const __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(w, w), 8);
+				const __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(w, w), 8);
+
+				acc = _mm_add_epi32(acc, _mm_madd_epi16(lo, _mm_loadu_si128((const __m128i*)(input + j))));
+				acc = _mm_add_epi32(acc, _mm_madd_epi16(hi, _mm_loadu_si128((const __m128i*)(input + j + 8))));
+			}
+
+			acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+			acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+			out[n] = _mm_cvtsi128_si32(acc);
+		}
+	}
+
+	KERNEL_TARGET_AVX2
+	void DenseInt8AVX2(const signed char* weights, int neurons, int stride, const short* input, int* out)
+	{
+		for (int n = 0; n < neurons; n++)
+		{
+			const signed char* row = weights + n * stride;
+			__m256i acc = _mm256_setzero_si256();
+
+			for (int j = 0; j < stride; j += 16)
+			{
+				const __m256i w = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(row + j)));
+				acc = _mm256_add_epi32(acc, _mm256_madd_epi16(w, _mm256_loadu_si256((const __m256i*)(input + j))));
+			}
+
+			__m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+			sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+			sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+			out[n] = _mm_cvtsi128_si32(sum);
+		}
+	}
+
+	KERNEL_TARGET_SSE2
+	void DenseBatchSSE2(const float* weights, int neurons, int inputs, const float* input, int count, float* out)
+	{
+		const int stride = inputs + 1;
+		for (int n = 0; n < neurons; n++)
+		{
+			const float* row = weights + n * stride;
+			float* dest = out + n * count;
+			const float bias = row[inputs] * BIAS;
+			int a = 0;
+
+			// Four independent accumulators (sixteen agents) keep the adds from stalling on each other.
+			for (; a + 16 <= count; a += 16)
+			{
+				__m128 acc0 = _mm_set1_ps(bias);
+				__m128 acc1 = acc0;
+				__m128 acc2 = acc0;
+				__m128 acc3 = acc0;
+
+				for (int j = 0; j < inputs; j++)
+				{
+					const __m128 w = _mm_set1_ps(row[j]);
+					const float* x = input + j * count + a;
+					acc0 = _mm_add_ps(acc0, _mm_mul_ps(w, _mm_loadu_ps(x)));
+					acc1 = _mm_add_ps(acc1, _mm_mul_ps(w, _mm_loadu_ps(x + 4)));
+					acc2 = _mm_add_ps(acc2, _mm_mul_ps(w, _mm_loadu_ps(x + 8)));
+					acc3 = _mm_add_ps(acc3, _mm_mul_ps(w, _mm_loadu_ps(x + 12)));
+				}
+
+				_mm_storeu_ps(dest + a, acc0);
+				_mm_storeu_ps(dest + a + 4, acc1);
+				_mm_storeu_ps(dest + a + 8, acc2);
+				_mm_storeu_ps(dest + a + 12, acc3);
+			}
+
+			for (; a + 4 <= count; a += 4)
+			{
+				__m128 acc = _mm_set1_ps(bias);
+				for (int j = 0; j < inputs; j++)
+				{
+					acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(row[j]), _mm_loadu_ps(input + j * count + a)));
+				}
+				_mm_storeu_ps(dest + a, acc);
+			}
+
+			for (; a < count; a++)
+			{
+				float sum = bias;
+				for (int j = 0; j < inputs; j++)
+				{
+					sum += row[j] * input[j * count + a];
+				}
+				dest[a] = sum;
+			}
+		}
+	}
+
+	KERNEL_TARGET_AVX2
+	void DenseBatchAVX2(const float* weights, int neurons, int inputs, const float* input, int count, float* out)
+	{
+		const int stride = inputs + 1;
+		for (int n = 0; n < neurons; n++)
+		{
+			const float* row = weights + n * stride;
+			float* dest = out + n * count;
+			const float bias = row[inputs] * BIAS;
+			int a = 0;
+
+			for (; a + 32 <= count; a += 32)
+			{
+				__m256 acc0 = _mm256_set1_ps(bias);
+				__m256 acc1 = acc0;
+				__m256 acc2 = acc0;
+				__m256 acc3 = acc0;
+
+				for (int j = 0; j < inputs; j++)
+				{
+					const __m256 w = _mm256_set1_ps(row[j]);
+					const float* x = input + j * count + a;
+					acc0 = _mm256_fmadd_ps(w, _mm256_loadu_ps(x), acc0);
+					acc1 = _mm256_fmadd_ps(w, _mm256_loadu_ps(x + 8), acc1);
+					acc2 = _mm256_fmadd_ps(w, _mm256_loadu_ps(x + 16), acc2);
+					acc3 = _mm256_fmadd_ps(w, _mm256_loadu_ps(x + 24), acc3);
+				}
+
+				_mm256_storeu_ps(dest + a, acc0);
+				_mm256_storeu_ps(dest + a + 8, acc1);
+				_mm256_storeu_ps(dest + a + 16, acc2);
+				_mm256_storeu_ps(dest + a + 24, acc3);
+			}
+
+			for (; a + 8 <= count; a += 8)
+			{
+				__m256 acc = _mm256_set1_ps(bias);
+				for (int j = 0; j < inputs; j++)
+				{
+					acc = _mm256_fmadd_ps(_mm256_set1_ps(row[j]), _mm256_loadu_ps(input + j * count + a), acc);
+				}
+				_mm256_storeu_ps(dest + a, acc);
+			}
+
+			for (; a < count; a++)
+			{
+				float sum = bias;
+				for (int j = 0; j < inputs; j++)
+				{
+					sum += row[j] * input[j * count + a];
+				}
+				dest[a] = sum;
+			}
+		}
+	}
+
+	KERNEL_TARGET_SSE2
+	void DenseLayerSSE2(const float* weights, int neurons, int inputs, const float* input, float* out)
+	{
+		const int stride = inputs + 1;
+		int i = 0;
+
+		// Work on four rows at once so the horizontal sums can be done with a single transpose.
+		for (; i + 4 <= neurons; i += 4)
+		{
+			const float* r0 = weights + i * stride;
+			const float* r1 = r0 + stride;
+			const float* r2 = r1 + stride;
+			const float* r3 = r2 + stride;
+
+			__m128 a0 = _mm_setzero_ps();
+			__m128 a1 = _mm_setzero_ps();
+			__m128 a2 = _mm_setzero_ps();
+			__m128 a3 = _mm_setzero_ps();
+
+			int j = 0;
+			for (; j + 4 <= inputs; j += 4)
+			{
+				const __m128 x = _mm_loadu_ps(input + j);
+				a0 = _mm_add_ps(a0, _mm_mul_ps(_mm_loadu_ps(r0 + j), x));
+				a1 = _mm_add_ps(a1, _mm_mul_ps(_mm_loadu_ps(r1 + j), x));
+				a2 = _mm_add_ps(a2, _mm_mul_ps(_mm_loadu_ps(r2 + j), x));
+				a3 = _mm_add_ps(a3, _mm_mul_ps(_mm_loadu_ps(r3 + j), x));
+			}
+
+			// After the transpose lane 'n' of each register holds a partial sum for row 'n'.
+			_MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+			__m128 sum = _mm_add_ps(_mm_add_ps(a0, a1), _mm_add_ps(a2, a3));
+
+			const __m128 tail = _mm_set_ps(RowTail(r3, j, inputs, input),
+										   RowTail(r2, j, inputs, input),
+										   RowTail(r1, j, inputs, input),
+										   RowTail(r0, j, inputs, input));
+
+			_mm_storeu_ps(out + i, _mm_add_ps(sum, tail));
+		}
+
+		// Left over rows.
+		for (; i < neurons; i++)
+		{
+			out[i] = RowTail(weights + i * stride, 0, inputs, input);
+		}
+	}
+
+	KERNEL_TARGET_AVX2
+	void DenseLayerAVX2(const float* weights, int neurons, int inputs, const float* input, float* out)
+	{
+		// Masks for loading the last 0-7 floats of a row without reading past the end of it.
+		static const int maskTable[16] = { -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+		const int stride = inputs + 1;
+		const int fullInputs = inputs & ~7;
+		const int remainder = inputs - fullInputs;
+		const __m256i tailMask = _mm256_loadu_si256((const __m256i*)(maskTable + 8 - remainder));
+		const __m256 tailInput = _mm256_maskload_ps(input + fullInputs, tailMask);
+		int i = 0;
+
+		for (; i + 4 <= neurons; i += 4)
+		{
+			const float* r0 = weights + i * stride;
+			const float* r1 = r0 + stride;
+			const float* r2 = r1 + stride;
+			const float* r3 = r2 + stride;
+
+			__m256 a0 = _mm256_setzero_ps();
+			__m256 a1 = _mm256_setzero_ps();
+			__m256 a2 = _mm256_setzero_ps();
+			__m256 a3 = _mm256_setzero_ps();
+
+			for (int j = 0; j < fullInputs; j += 8)
+			{
+				const __m256 x = _mm256_loadu_ps(input + j);
+				a0 = _mm256_fmadd_ps(_mm256_loadu_ps(r0 + j), x, a0);
+				a1 = _mm256_fmadd_ps(_mm256_loadu_ps(r1 + j), x, a1);
+				a2 = _mm256_fmadd_ps(_mm256_loadu_ps(r2 + j), x, a2);
+				a3 = _mm256_fmadd_ps(_mm256_loadu_ps(r3 + j), x, a3);
+			}
+
+			if (remainder > 0)
+			{
+				a0 = _mm256_fmadd_ps(_mm256_maskload_ps(r0 + fullInputs, tailMask), tailInput, a0);
+				a1 = _mm256_fmadd_ps(_mm256_maskload_ps(r1 + fullInputs, tailMask), tailInput, a1);
+				a2 = _mm256_fmadd_ps(_mm256_maskload_ps(r2 + fullInputs, tailMask), tailInput, a2);
+				a3 = _mm256_fmadd_ps(_mm256_maskload_ps(r3 + fullInputs, tailMask), tailInput, a3);
+			}
+
+			// Reduce the four accumulators so that lane 'n' holds the sum for row 'n'.
+			const __m256 h = _mm256_hadd_ps(_mm256_hadd_ps(a0, a1), _mm256_hadd_ps(a2, a3));
+			const __m128 sum = _mm_add_ps(_mm256_castps256_ps128(h), _mm256_extractf128_ps(h, 1));
+
+			const __m128 bias = _mm_mul_ps(_mm_set_ps(r3[inputs], r2[inputs], r1[inputs], r0[inputs]), _mm_set1_ps(BIAS));
+
+			_mm_storeu_ps(out + i, _mm_add_ps(sum, bias));
+		}
+
+		for (; i < neurons; i++)
+		{
+			out[i] = RowTail(weights + i * stride, 0, inputs, input);
+		}
+	}
+
+	// Widens four halves with integer arithmetic, SSE2 has no conversion instruction. Moving
+	// the exponent and mantissa up 13 bits and rebiasing the exponent by 112 (127 - 15) gives
+	// the float; zero and infinity/NaN exponents are patched up afterwards.
+	KERNEL_TARGET_SSE2
+	static inline __m128 HalfToFloatSSE2(const unsigned short* half)
+	{
+		const __m128i h = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)half), _mm_setzero_si128());
+		const __m128i rebias = _mm_set1_epi32(112 << 23);
+		const __m128i exponent = _mm_and_si128(h, _mm_set1_epi32(0x7c00));
+
+		const __m128i sign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16);
+		__m128i bits = _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7fff)), 13), rebias);
+		bits = _mm_add_epi32(bits, _mm_and_si128(_mm_cmpeq_epi32(exponent, _mm_set1_epi32(0x7c00)), rebias));
+		bits = _mm_andnot_si128(_mm_cmpeq_epi32(exponent, _mm_setzero_si128()), bits);
+		return _mm_castsi128_ps(_mm_or_si128(sign, bits));
+	}
+
+	// DenseLayerSSE2, loading each group of four weights through HalfToFloatSSE2.
+	KERNEL_TARGET_SSE2
+	void DenseHalfSSE2(const unsigned short* weights, int neurons, int inputs, const float* input, float* out)
+	{
+		const int stride = inputs + 1;
+		int i = 0;
+
+		for (; i + 4 <= neurons; i += 4)
+		{
+			const unsigned short* r0 = weights + i * stride;
+			const unsigned short* r1 = r0 + stride;
+			const unsigned short* r2 = r1 + stride;
+			const unsigned short* r3 = r2 + stride;
+
+			__m128 a0 = _mm_setzero_ps();
+			__m128 a1 = _mm_setzero_ps();
+			__m128 a2 = _mm_setzero_ps();
+			__m128 a3 = _mm_setzero_ps();
+
+			int j = 0;
+			for (; j + 4 <= inputs; j += 4)
+			{
+				const __m128 x = _mm_loadu_ps(input + j);
+				a0 = _mm_add_ps(a0, _mm_mul_ps(HalfToFloatSSE2(r0 + j), x));
+				a1 = _mm_add_ps(a1, _mm_mul_ps(HalfToFloatSSE2(r1 + j), x));
+				a2 = _mm_add_ps(a2, _mm_mul_ps(HalfToFloatSSE2(r2 + j), x));
+				a3 = _mm_add_ps(a3, _mm_mul_ps(HalfToFloatSSE2(r3 + j), x));
+			}
+
+			_MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+			__m128 sum = _mm_add_ps(_mm_add_ps(a0, a1), _mm_add_ps(a2, a3));
+
+			const __m128 tail = _mm_set_ps(HalfRowTail(r3, j, inputs, input),
+										   HalfRowTail(r2, j, inputs, input),
+										   HalfRowTail(r1, j, inputs, input),
+										   HalfRowTail(r0, j, inputs, input));
+
+			_mm_storeu_ps(out + i, _mm_add_ps(sum, tail));
+		}
+
+		for (; i < neurons; i++)
+		{
+			out[i] = HalfRowTail(weights + i * stride, 0, inputs, input);
+		}
+	}
+
+	// DenseLayerAVX2 with the weights widened by F16C. The last 0-7 halves of a row are copied
+	// into a zeroed block first, halves can't be mask loaded.
+	KERNEL_TARGET_AVX2
+	void DenseHalfAVX2(const unsigned short* weights, int neurons, int inputs, const float* input, float* out)
+	{
+		static const int maskTable[16] = { -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+		const int stride = inputs + 1;
+		const int fullInputs = inputs & ~7;
+		const int remainder = inputs - fullInputs;
+		const __m256i tailMask = _mm256_loadu_si256((const __m256i*)(maskTable + 8 - remainder));
+		const __m256 tailInput = _mm256_maskload_ps(input + fullInputs, tailMask);
+		int i = 0;
+
+		for (; i + 4 <= neurons; i += 4)
+		{
+			const unsigned short* rows[4];
+			__m256 acc[4];
+			for (int r = 0; r < 4; r++)
+			{
+				rows[r] = weights + (i + r) * stride;
+				acc[r] = _mm256_setzero_ps();
+			}
+
+			for (int j = 0; j < fullInputs; j += 8)
+			{
+				const __m256 x = _mm256_loadu_ps(input + j);
+				for (int r = 0; r < 4; r++)
+				{
+					acc[r] = _mm256_fmadd_ps(_mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(rows[r] + j))), x, acc[r]);
+				}
+			}
+
+			if (remainder > 0)
+			{
+				for (int r = 0; r < 4; r++)
+				{
+					unsigned short tail[8] = { 0 };
+					memcpy(tail, rows[r] + fullInputs, remainder * sizeof(unsigned short));
+					acc[r] = _mm256_fmadd_ps(_mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)tail)), tailInput, acc[r]);
+				}
+			}
+
+			const __m256 h = _mm256_hadd_ps(_mm256_hadd_ps(acc[0], acc[1]), _mm256_hadd_ps(acc[2], acc[3]));
+			const __m128 sum = _mm_add_ps(_mm256_castps256_ps128(h), _mm256_extractf128_ps(h, 1));
+
+			const __m128 bias = _mm_mul_ps(_mm_set_ps(HalfToFloat(rows[3][inputs]), HalfToFloat(rows[2][inputs]),
+													  HalfToFloat(rows[1][inputs]), HalfToFloat(rows[0][inputs])),
+										   _mm_set1_ps(BIAS));
+
+			_mm_storeu_ps(out + i, _mm_add_ps(sum, bias));
+		}
+
+		for (; i < neurons; i++)
+		{
+			out[i] = HalfRowTail(weights + i * stride, 0, inputs, input);
+		}
+	}
+
+	static void CpuId(int info[4], int leaf, int subLeaf)
+	{
+#if defined(_MSC_VER)
+		__cpuidex(info, leaf, subLeaf);
+#else
+		__cpuid_count(leaf, subLeaf, info[0], info[1], info[2], info[3]);
+#endif
+	}
+
+	// Reads the OS enabled register state, tells us if the OS saves the AVX registers.
+	static unsigned long long ReadXCR0()
+	{
+#if defined(_MSC_VER)
+		return _xgetbv(0);
+#else
+		unsigned int eax = 0;
+		unsigned int edx = 0;
+		__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return ((unsigned long long)edx << 32) | eax;
+#endif
+	}
+
+	KernelLevel DetectKernelLevel()
+	{
+		int info[4] = {0};
+		CpuId(info, 0, 0);
+		const int maxLeaf = info[0];
+
+		CpuId(info, 1, 0);
+		const bool sse2 = (info[3] & (1 << 26)) != 0;
+		const bool fma = (info[2] & (1 << 12)) != 0;
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		const bool f16c = (info[2] & (1 << 29)) != 0;
+
+		bool avx2 = false;
+		if (maxLeaf >= 7)
+		{
+			CpuId(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+		}
+
+		// The OS must also be saving the XMM and YMM registers across context switches.
+		if (osxsave && avx && avx2 && fma && f16c && (ReadXCR0() & 0x6) == 0x6)
+		{
+			return KERNEL_AVX2;
+		}
+
+		if (sse2)
+		{
+			return KERNEL_SSE2;
+		}
+
+		return KERNEL_SCALAR;
+	}
+
+#else
+
+	// Not an x86 build, everything runs through the reference kernel.
+	void DenseLayerSSE2(const float* weights, int neurons, int inputs, const float* input, float* out)
+	{
+		DenseLayerScalar(weights, neurons, inputs, input, out);
+	}
+
+	void DenseLayerAVX2(const float* weights, int neurons, int inputs, const float* input, float* out)
+	{
+		DenseLayerScalar(weights, neurons, inputs, input, out);
+	}
+
+	void DenseBatchSSE2(const float* weights, int neurons, int inputs, const float* input, int count, float* out)
+	{
+		DenseBatchScalar(weights, neurons, inputs, input, count, out);
+	}
+
+	void DenseBatchAVX2(const float* weights, int neurons, int inputs, const float* input, int count, float* out)
+	{
+		DenseBatchScalar(weights, neurons, inputs, input, count, out);
+	}
+
+	void DenseInt8SSE2(const signed char* weights, int neurons, int stride, const short* input, int* out)
+	{
+		DenseInt8Scalar(weights, neurons, stride, input, out);
+	}
+
+	void DenseInt8AVX2(const signed char* weights, int neurons, int stride, const short* input, int* out)
+	{
+		DenseInt8Scalar(weights, neurons, stride, input, out);
+	}
+
+	void DenseHalfSSE2(const unsigned short* weights, int neurons, int inputs, const float* input, float* out)
+	{
+		DenseHalfScalar(weights, neurons, inputs, input, out);
+	}
+
+	void DenseHalfAVX2(const unsigned short* weights, int neurons, int inputs, const float* input, float* out)
+	{
+		DenseHalfScalar(weights, neurons, inputs, input, out);
+	}
+
+	KernelLevel DetectKernelLevel()
+	{
+		return KERNEL_SCALAR;
+	}
+
+#endif // #if defined(CARDEMO_X86)
+
+	DenseKernel GetDenseKernel(KernelLevel level)
+	{
+		switch (level)
+		{
+		case KERNEL_AVX2:
+			return DenseLayerAVX2;
+		case KERNEL_SSE2:
+			return DenseLayerSSE2;
+		default:
+			return DenseLayerScalar;
+		};
+	}
+
+	DenseBatchKernel GetDenseBatchKernel(KernelLevel level)
+	{
+		switch (level)
+		{
+		case KERNEL_AVX2:
+			return DenseBatchAVX2;
+		case KERNEL_SSE2:
+			return DenseBatchSSE2;
+		default:
+			return DenseBatchScalar;
+		};
+	}
+
+	DenseInt8Kernel GetDenseInt8Kernel(KernelLevel level)
+	{
+		switch (level)
+		{
+		case KERNEL_AVX2:
+			return DenseInt8AVX2;
+		case KERNEL_SSE2:
+			return DenseInt8SSE2;
+		default:
+			return DenseInt8Scalar;
+		};
+	}
+
+	DenseHalfKernel GetDenseHalfKernel(KernelLevel level)
+	{
+		switch (level)
+		{
+		case KERNEL_AVX2:
+			return DenseHalfAVX2;
+		case KERNEL_SSE2:
+			return DenseHalfSSE2;
+		default:
+			return DenseHalfScalar;
+		};
+	}
+
+	// Asks the CPU once, however many threads get here first.
+	static KernelLevel GetSupportedKernelLevel()
+	{
+		static const KernelLevel supported = DetectKernelLevel();
+		return supported;
+	}
+
+	void SetKernelLevel(KernelLevel level)
+	{
+		const KernelLevel supported = GetSupportedKernelLevel();
+		if (level > supported)
+		{
+			level = supported;
+		}
+
+		gKernelLevel.store(level, std::memory_order_relaxed);
+	}
+
+	KernelLevel GetKernelLevel()
+	{
+		const int level = gKernelLevel.load(std::memory_order_relaxed);
+		return level < 0 ? GetSupportedKernelLevel() : (KernelLevel)level;
+	}
+
+	DenseKernel GetDenseKernel()
+	{
+		return GetDenseKernel(GetKernelLevel());
+	}
+
+	DenseBatchKernel GetDenseBatchKernel()
+	{
+		return GetDenseBatchKernel(GetKernelLevel());
+	}
+
+	DenseInt8Kernel GetDenseInt8Kernel()
+	{
+		return GetDenseInt8Kernel(GetKernelLevel());
+	}
+
+	DenseHalfKernel GetDenseHalfKernel()
+	{
+		return GetDenseHalfKernel(GetKernelLevel());
+	}
+
+}; // End namespace CarDemo.
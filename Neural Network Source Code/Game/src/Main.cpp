@@ -5,18 +5,30 @@
 #include "GameSettings.h"
 #include "GameInterface.h"
 #include "EditorInterface.h"
+#include "Benchmarks.h"
+#include "RandomStream.h"
 
 #include "MemoryLeak.h"
 
 #define GAME_BUILD
 //#define EDITOR_BUILD
+//#define BENCHMARK_BUILD
 
 using std::endl;
 using std::cout;
 
 void main()
 {
-	srand(time(0));
+	CarDemo::SetRandomSeed((unsigned long long)time(0));
+
+#if defined(BENCHMARK_BUILD)
+
+	// Console only, no window is needed to time the hot loops.
+	CarDemo::RunActivationBenchmark(cout);
+	CarDemo::RunQuantizationReport(cout, "Resources/ExportedNNs/UberNeuralNet1.txt", "ExportedNNs/SensorRecording.txt");
+	return;
+
+#endif
 
 	cout << GF1::GetVersion() << endl;
 
@@ -40,6 +40,7 @@
 #include <Clarity/Math/Ray2.h>
 #include <Clarity/Math/LineSegment2.h>
 
+#include <cmath>
 #include <limits>
 
 namespace Clarity
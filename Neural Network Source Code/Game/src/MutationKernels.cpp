@@ -0,0 +1,366 @@
+//****************************************************************************
+//**
+//**    MutationKernels.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <string.h>
+
+#include "MutationKernels.h"
+
+#include "RandomStream.h"
+
+#if defined(CARDEMO_X86)
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+	// The sum of four fractions has a variance of 4 / 12; this brings it back to one.
+	static const float NORMAL_SCALE = 1.7320508f / 65536.0f;
+
+	void MutationLanes::Seed(RandomStream& source)
+	{
+		// The odd first word rules out the all zero state.
+		for (int j = 0; j < MUTATION_LANES; j++)
+		{
+			s0[j] = source.Next() | 1u;
+			s1[j] = source.Next();
+			s2[j] = source.Next();
+			s3[j] = source.Next();
+		}
+	}
+
+	// The difference of a draw's two 16 bit halves as a fraction, -1 to 1.
+	static inline int TriangularBits(unsigned int bits)
+	{
+		return (int)(bits & 0xffff) - (int)(bits >> 16);
+	}
+
+	// The four 16 bit halves of two draws summed, less their mean.
+	static inline int NormalBits(unsigned int a, unsigned int b)
+	{
+		return (int)((a & 0xffff) + (a >> 16) + (b & 0xffff) + (b >> 16)) - 2 * 65536;
+	}
+
+	void MutateUniformScalar(float* weights, int count, float rate, float scale, MutationLanes& lanes)
+	{
+		for (int i = 0; i < count; i += MUTATION_LANES)
+		{
+			for (int j = 0; j < MUTATION_LANES; j++)
+			{
+				const float chance = (float)TriangularBits(lanes.Next(j)) * (1.0f / 65536.0f);
+				const float amount = (float)TriangularBits(lanes.Next(j)) * (1.0f / 65536.0f);
+				const float delta = amount * scale;
+				weights[i + j] += chance < rate ? delta : 0.0f;
+			}
+		}
+	}
+
+	void MutateGaussianScalar(float* weights, int count, float rate, float scale, MutationLanes& lanes)
+	{
+		const float step = scale * NORMAL_SCALE;
+		for (int i = 0; i < count; i += MUTATION_LANES)
+		{
+			for (int j = 0; j < MUTATION_LANES; j++)
+			{
+				const float chance = (float)(int)(lanes.Next(j) >> 8) * (1.0f / 16777216.0f);
+				const unsigned int a = lanes.Next(j);
+				const float delta = (float)NormalBits(a, lanes.Next(j)) * step;
+				weights[i + j] += chance < rate ? delta : 0.0f;
+			}
+		}
+	}
+
+#if defined(CARDEMO_X86)
+
+	// xoshiro128** on four lanes. The multiplies by 5 and 9 are shifts and adds, SSE2 having
+	// no 32 bit multiply.
+	KERNEL_TARGET_SSE2
+	static inline __m128i NextSSE2(__m128i& s0, __m128i& s1, __m128i& s2, __m128i& s3)
+	{
+		const __m128i scaled = _mm_add_epi32(s1, _mm_slli_epi32(s1, 2));
+		const __m128i rotated = _mm_or_si128(_mm_slli_epi32(scaled, 7), _mm_srli_epi32(scaled, 25));
+		const __m128i result = _mm_add_epi32(rotated, _mm_slli_epi32(rotated, 3));
+		const __m128i shifted = _mm_slli_epi32(s1, 9);
+
+		s2 = _mm_xor_si128(s2, s0);
+		s3 = _mm_xor_si128(s3, s1);
+		s1 = _mm_xor_si128(s1, s2);
+		s0 = _mm_xor_si128(s0, s3);
+		s2 = _mm_xor_si128(s2, shifted);
+		s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+
+		return result;
+	}
+
+	KERNEL_TARGET_SSE2
+	static inline __m128i TriangularBitsSSE2(__m128i bits)
+	{
+		return _mm_sub_epi32(_mm_and_si128(bits, _mm_set1_epi32(0xffff)), _mm_srli_epi32(bits, 16));
+	}
+
+	KERNEL_TARGET_SSE2
+	static inline __m128i NormalBitsSSE2(__m128i a, __m128i b)
+	{
+		const __m128i low = _mm_set1_epi32(0xffff);
+		const __m128i sum = _mm_add_epi32(_mm_add_epi32(_mm_and_si128(a, low), _mm_srli_epi32(a, 16)),
+										  _mm_add_epi32(_mm_and_si128(b, low), _mm_srli_epi32(b, 16)));
+		return _mm_sub_epi32(sum, _mm_set1_epi32(2 * 65536));
+	}
+
+	KERNEL_TARGET_SSE2
+	void MutateUniformSSE2(float* weights, int count, float rate, float scale, MutationLanes& lanes)
+	{
+		// Lanes 0 to 3 in [0], 4 to 7 in [1].
+		__m128i s0[2], s1[2], s2[2], s3[2];
+		for (int h = 0; h < 2; h++)
+		{
+			s0[h] = _mm_loadu_si128((const __m128i*)(lanes.s0 + h * 4));
+			s1[h] = _mm_loadu_si128((const __m128i*)(lanes.s1 + h * 4));
+			s2[h] = _mm_loadu_si128((const __m128i*)(lanes.s2 + h * 4));
+			s3[h] = _mm_loadu_si128((const __m128i*)(lanes.s3 + h * 4));
+		}
+
+		const __m128 rates = _mm_set1_ps(rate);
+		const __m128 scales = _mm_set1_ps(scale);
+		const __m128 fraction = _mm_set1_ps(1.0f / 65536.0f);
+
+		for (int i = 0; i < count; i += MUTATION_LANES)
+		{
+			for (int h = 0; h < 2; h++)
+			{
+				const __m128 chance = _mm_mul_ps(_mm_cvtepi32_ps(TriangularBitsSSE2(NextSSE2(s0[h], s1[h], s2[h], s3[h]))), fraction);
+				const __m128 amount = _mm_mul_ps(_mm_cvtepi32_ps(TriangularBitsSSE2(NextSSE2(s0[h], s1[h], s2[h], s3[h]))), fraction);
+				const __m128 delta = _mm_and_ps(_mm_cmplt_ps(chance, rates), _mm_mul_ps(amount, scales));
+
+				float* w = weights + i + h * 4;
+				_mm_storeu_ps(w, _mm_add_ps(_mm_loadu_ps(w), delta));
+			}
+		}
+
+		for (int h = 0; h < 2; h++)
+		{
+			_mm_storeu_si128((__m128i*)(lanes.s0 + h * 4), s0[h]);
+			_mm_storeu_si128((__m128i*)(lanes.s1 + h * 4), s1[h]);
+			_mm_storeu_si128((__m128i*)(lanes.s2 + h * 4), s2[h]);
+			_mm_storeu_si128((__m128i*)(lanes.s3 + h * 4), s3[h]);
+		}
+	}
+
+	KERNEL_TARGET_SSE2
+	void MutateGaussianSSE2(float* weights, int count, float rate, float scale, MutationLanes& lanes)
+	{
+		__m128i s0[2], s1[2], s2[2], s3[2];
+		for (int h = 0; h < 2; h++)
+		{
+			s0[h] = _mm_loadu_si128((const __m128i*)(lanes.s0 + h * 4));
+			s1[h] = _mm_loadu_si128((const __m128i*)(lanes.s1 + h * 4));
+			s2[h] = _mm_loadu_si128((const __m128i*)(lanes.s2 + h * 4));
+			s3[h] = _mm_loadu_si128((const __m128i*)(lanes.s3 + h * 4));
+		}
+
+		const __m128 rates = _mm_set1_ps(rate);
+		const __m128 step = _mm_set1_ps(scale * NORMAL_SCALE);
+		const __m128 fraction = _mm_set1_ps(1.0f / 16777216.0f);
+
+		for (int i = 0; i < count; i += MUTATION_LANES)
+		{
+			for (int h = 0; h < 2; h++)
+			{
+				const __m128 chance = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(NextSSE2(s0[h], s1[h], s2[h], s3[h]), 8)), fraction);
+				const __m128i a = NextSSE2(s0[h], s1[h], s2[h], s3[h]);
+				const __m128i b = NextSSE2(s0[h], s1[h], s2[h], s3[h]);
+				const __m128 delta = _mm_and_ps(_mm_cmplt_ps(chance, rates), _mm_mul_ps(_mm_cvtepi32_ps(NormalBitsSSE2(a, b)), step));
+
+				float* w = weights + i + h * 4;
+				_mm_storeu_ps(w, _mm_add_ps(_mm_loadu_ps(w), delta));
+			}
+		}
+
+		for (int h = 0; h < 2; h++)
+		{
+			_mm_storeu_si128((__m128i*)(lanes.s0 + h * 4), s0[h]);
+			_mm_storeu_si128((__m128i*)(lanes.s1 + h * 4), s1[h]);
+			_mm_storeu_si128((__m128i*)(lanes.s2 + h * 4), s2[h]);
+			_mm_storeu_si128((__m128i*)(lanes.s3 + h * 4), s3[h]);
+		}
+	}
+
+	KERNEL_TARGET_AVX2
+	static inline __m256i NextAVX2(__m256i& s0, __m256i& s1, __m256i& s2, __m256i& s3)
+	{
+		const __m256i scaled = _mm256_add_epi32(s1, _mm256_slli_epi32(s1, 2));
+		const __m256i rotated = _mm256_or_si256(_mm256_slli_epi32(scaled, 7), _mm256_srli_epi32(scaled, 25));
+		const __m256i result = _mm256_add_epi32(rotated, _mm256_slli_epi32(rotated, 3));
+		const __m256i shifted = _mm256_slli_epi32(s1, 9);
+
+		s2 = _mm256_xor_si256(s2, s0);
+		s3 = _mm256_xor_si256(s3, s1);
+		s1 = _mm256_xor_si256(s1, s2);
+		s0 = _mm256_xor_si256(s0, s3);
+		s2 = _mm256_xor_si256(s2, shifted);
+		s3 = _mm256_or_si256(_mm256_slli_epi32(s3, 11), _mm256_srli_epi32(s3, 21));
+
+		return result;
+	}
+
+	KERNEL_TARGET_AVX2
+	static inline __m256i TriangularBitsAVX2(__m256i bits)
+	{
+		return _mm256_sub_epi32(_mm256_and_si256(bits, _mm256_set1_epi32(0xffff)), _mm256_srli_epi32(bits, 16));
+	}
+
+	KERNEL_TARGET_AVX2
+	static inline __m256i NormalBitsAVX2(__m256i a, __m256i b)
+	{
+		const __m256i low = _mm256_set1_epi32(0xffff);
+		const __m256i sum = _mm256_add_epi32(_mm256_add_epi32(_mm256_and_si256(a, low), _mm256_srli_epi32(a, 16)),
+											 _mm256_add_epi32(_mm256_and_si256(b, low), _mm256_srli_epi32(b, 16)));
+		return _mm256_sub_epi32(sum, _mm256_set1_epi32(2 * 65536));
+	}
+
+	// The masked delta is added on its own, never fused into a multiply-add, so the result
+	// matches the other levels to the bit.
+	KERNEL_TARGET_AVX2
+	void MutateUniformAVX2(float* weights, int count, float rate, float scale, MutationLanes& lanes)
+	{
+		__m256i s0 = _mm256_loadu_si256((const __m256i*)lanes.s0);
+		__m256i s1 = _mm256_loadu_si256((const __m256i*)lanes.s1);
+		__m256i s2 = _mm256_loadu_si256((const __m256i*)lanes.s2);
+		__m256i s3 = _mm256_loadu_si256((const __m256i*)lanes.s3);
+
+		const __m256 rates = _mm256_set1_ps(rate);
+		const __m256 scales = _mm256_set1_ps(scale);
+		const __m256 fraction = _mm256_set1_ps(1.0f / 65536.0f);
+
+		for (int i = 0; i < count; i += MUTATION_LANES)
+		{
+			const __m256 chance = _mm256_mul_ps(_mm256_cvtepi32_ps(TriangularBitsAVX2(NextAVX2(s0, s1, s2, s3))), fraction);
+			const __m256 amount = _mm256_mul_ps(_mm256_cvtepi32_ps(TriangularBitsAVX2(NextAVX2(s0, s1, s2, s3))), fraction);
+			const __m256 delta = _mm256_and_ps(_mm256_cmp_ps(chance, rates, _CMP_LT_OQ), _mm256_mul_ps(amount, scales));
+
+			_mm256_storeu_ps(weights + i, _mm256_add_ps(_mm256_loadu_ps(weights + i), delta));
+		}
+
+		_mm256_storeu_si256((__m256i*)lanes.s0, s0);
+		_mm256_storeu_si256((__m256i*)lanes.s1, s1);
+		_mm256_storeu_si256((__m256i*)lanes.s2, s2);
+		_mm256_storeu_si256((__m256i*)lanes.s3, s3);
+	}
+
+	KERNEL_TARGET_AVX2
+	void MutateGaussianAVX2(float* weights, int count, float rate, float scale, MutationLanes& lanes)
+	{
+		__m256i s0 = _mm256_loadu_si256((const __m256i*)lanes.s0);
+		__m256i s1 = _mm256_loadu_si256((const __m256i*)lanes.s1);
+		__m256i s2 = _mm256_loadu_si256((const __m256i*)lanes.s2);
+		__m256i s3 = _mm256_loadu_si256((const __m256i*)lanes.s3);
+
+		const __m256 rates = _mm256_set1_ps(rate);
+		const __m256 step = _mm256_set1_ps(scale * NORMAL_SCALE);
+		const __m256 fraction = _mm256_set1_ps(1.0f / 16777216.0f);
+
+		for (int i = 0; i < count; i += MUTATION_LANES)
+		{
+			const __m256 chance = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(NextAVX2(s0, s1, s2, s3), 8)), fraction);
+			const __m256i a = NextAVX2(s0, s1, s2, s3);
+			const __m256i b = NextAVX2(s0, s1, s2, s3);
+			const __m256 delta = _mm256_and_ps(_mm256_cmp_ps(chance, rates, _CMP_LT_OQ),
+											   _mm256_mul_ps(_mm256_cvtepi32_ps(NormalBitsAVX2(a, b)), step));
+
+			_mm256_storeu_ps(weights + i, _mm256_add_ps(_mm256_loadu_ps(weights + i), delta));
+		}
+
+		_mm256_storeu_si256((__m256i*)lanes.s0, s0);
+		_mm256_storeu_si256((__m256i*)lanes.s1, s1);
+		_mm256_storeu_si256((__m256i*)lanes.s2, s2);
+		_mm256_storeu_si256((__m256i*)lanes.s3, s3);
+	}
+
+#else
+
+	void MutateUniformSSE2(float* weights, int count, float rate, float scale, MutationLanes& lanes)
+	{
+		MutateUniformScalar(weights, count, rate, scale, lanes);
+	}
+
+	void MutateGaussianSSE2(float* weights, int count, float rate, float scale, MutationLanes& lanes)
+	{
+		MutateGaussianScalar(weights, count, rate, scale, lanes);
+	}
+
+	void MutateUniformAVX2(float* weights, int count, float rate, float scale, MutationLanes& lanes)
+	{
+		MutateUniformScalar(weights, count, rate, scale, lanes);
+	}
+
+	void MutateGaussianAVX2(float* weights, int count, float rate, float scale, MutationLanes& lanes)
+	{
+		MutateGaussianScalar(weights, count, rate, scale, lanes);
+	}
+
+#endif // #if defined(CARDEMO_X86)
+
+	void ApplyMutation(MutationKernel kernel, float* weights, int count, float rate, float scale, MutationLanes& lanes)
+	{
+		const int body = count - count % MUTATION_LANES;
+		if (body > 0)
+		{
+			kernel(weights, body, rate, scale, lanes);
+		}
+
+		if (body < count)
+		{
+			float tail[MUTATION_LANES] = { 0 };
+			memcpy(tail, weights + body, (count - body) * sizeof(float));
+			kernel(tail, MUTATION_LANES, rate, scale, lanes);
+			memcpy(weights + body, tail, (count - body) * sizeof(float));
+		}
+	}
+
+	MutationKernel GetUniformMutationKernel(KernelLevel level)
+	{
+		switch (level)
+		{
+		case KERNEL_AVX2:
+			return MutateUniformAVX2;
+		case KERNEL_SSE2:
+			return MutateUniformSSE2;
+		default:
+			return MutateUniformScalar;
+		};
+	}
+
+	MutationKernel GetUniformMutationKernel()
+	{
+		return GetUniformMutationKernel(GetKernelLevel());
+	}
+
+	MutationKernel GetGaussianMutationKernel(KernelLevel level)
+	{
+		switch (level)
+		{
+		case KERNEL_AVX2:
+			return MutateGaussianAVX2;
+		case KERNEL_SSE2:
+			return MutateGaussianSSE2;
+		default:
+			return MutateGaussianScalar;
+		};
+	}
+
+	MutationKernel GetGaussianMutationKernel()
+	{
+		return GetGaussianMutationKernel(GetKernelLevel());
+	}
+
+}; // End namespace CarDemo.
@@ -10,130 +10,186 @@
 //****************************************************************************
 
 #include <iostream>
+#include <string.h>
 
 #include "NLayer.h"
+#include "AlignedMemory.h"
 
 #include "MemoryLeak.h"
 
 namespace CarDemo 
 {
 	NLayer::NLayer()
+		: totalNeurons(0)
+		, totalInputs(0)
+		, weights(NULL)
+		, matrix(NULL)
+		, function(EVAL_SIGMOID)
 	{
 	}
 
 	NLayer::~NLayer()
 	{
+		Release();
 	}
 
-	void NLayer::Evaluate(std::vector<float> input, std::vector<float> &output)
+	void NLayer::Allocate(int numOfNeurons, int numOfInputs)
 	{
-		int inputIndex = 0;
-		// Cycle over all the neurons and sum their weights against the inputs.
-		for (unsigned int i = 0; i < totalNeurons; i++)
-		{
-			float activation = 0.0f;
-
-			// Sum the weights to the activation value.
-			// We do the sizeof the weights - 1 so that we can add in the bias to the 
-			// activation afterwards.
-			for (unsigned int j = 0; j < neurons[i].numInputs - 1; j++)
-			{
-				activation += input[inputIndex] * neurons[i].weights[j];
-				inputIndex++;
-			}
+		// Only go back to the heap if the shape of the layer has changed.
+		if (weights != NULL && numOfNeurons == totalNeurons && numOfInputs == totalInputs)
+			return;
 
-			// Add the bias.
-			// The bias will act as a threshold value to 
-			activation += neurons[i].weights[neurons[i].numInputs] * BIAS;
+		Release();
+		totalNeurons = numOfNeurons;
+		totalInputs = numOfInputs;
+		weights = AllocateFloats(GetTotalWeights());
+		matrix = weights;
+	}
 
-			output.push_back(Sigmoid(activation, 1.0f));
-			inputIndex = 0;
+	void NLayer::Release()
+	{
+		if (weights != NULL)
+		{
+			AlignedFree(weights);
+			weights = NULL;
 		}
+		matrix = NULL;
 	}
 
-	void NLayer::SaveLayer(std::ofstream &fileOut, char* layerType)
+	void NLayer::Evaluate(const float* input, float* output) const
 	{
-		fileOut << "<NLayer>" << std::endl;
-		fileOut << "Type=" << layerType << std::endl;
-		fileOut << "Inputs=" << this->totalInputs << std::endl;
-		fileOut << "Neurons=" << this->neurons.size() << std::endl;
-		fileOut << "-Build-" << std::endl;
-		for (unsigned int i = 0; i < this->neurons.size(); i++)
+		// Sum each neurons weights against the inputs (plus the bias) with the fastest kernel the 
+		// CPU supports, then squash the sums.
+		switch (function)
 		{
-			fileOut << "<Neuron>" << std::endl;
-			fileOut << "Weights=" << this->neurons[i].weights.size() << std::endl;
-			for (unsigned int j = 0; j < neurons[i].weights.size(); j++)
-			{
-				fileOut << "W=" << neurons[i].weights[j] << std::endl; 
-			}
-			fileOut << "</Neuron>" << std::endl;
-		}
-			
-		fileOut << "</NLayer>" << std::endl;
+		case EVAL_STEP:
+			EvaluateAs<EVAL_STEP>(input, output);
+			break;
+		case EVAL_BIPOLAR:
+			EvaluateAs<EVAL_BIPOLAR>(input, output);
+			break;
+		case EVAL_RELU:
+			EvaluateAs<EVAL_RELU>(input, output);
+			break;
+		case EVAL_TANH:
+			EvaluateAs<EVAL_TANH>(input, output);
+			break;
+		case EVAL_LINEAR:
+			EvaluateAs<EVAL_LINEAR>(input, output);
+			break;
+		default:
+			EvaluateAs<EVAL_SIGMOID>(input, output);
+			break;
+		};
 	}
 
-	void NLayer::LoadLayer(std::vector<Neuron> in)
+	void NLayer::SetFunction(EvalFunction evalFunction)
 	{
-		totalNeurons = in.size();
-		neurons = in;
+		function = evalFunction;
 	}
 
-	void NLayer::PopulateLayer(int numOfNeurons, int numOfInputs)
+	EvalFunction NLayer::GetFunction() const
 	{
-		totalInputs = numOfInputs;
-		totalNeurons = numOfNeurons;
-		this->neurons.resize(numOfNeurons);
-		for (unsigned int i = 0; i < neurons.size(); i++)
-		{
-			neurons[i].Populate(numOfInputs);
-		}
+		return function;
 	}
 
-	void NLayer::SetWeights(std::vector<float> weights, int numOfNeurons, int numOfInputs)
+	void NLayer::SaveLayer(std::ofstream &fileOut, const char* layerType)
 	{
-		int index = 0;
-		totalInputs = numOfInputs;
-		totalNeurons = numOfNeurons;
-		this->neurons.resize(numOfNeurons);
-		// Copy the weights into the neurons.
-		for (unsigned int i = 0; i < numOfNeurons; i++)
+		const int stride = GetStride();
+
+		fileOut << "<NLayer>" << "\n";
+		fileOut << "Type=" << layerType << "\n";
+		fileOut << "Inputs=" << this->totalInputs << "\n";
+		fileOut << "Neurons=" << this->totalNeurons << "\n";
+		fileOut << "Function=" << GetEvalFunctionName(function) << "\n";
+		fileOut << "-Build-" << "\n";
+		for (int i = 0; i < totalNeurons; i++)
 		{
-			neurons[i].weights.resize(numOfInputs);
-			for (unsigned int j = 0; j < numOfInputs; j++)
+			const float* row = matrix + i * stride;
+
+			fileOut << "<Neuron>" << "\n";
+			fileOut << "Weights=" << stride << "\n";
+			for (int j = 0; j < stride; j++)
 			{
-				neurons[i].weights[j] = weights[index];
-				index++;
+				fileOut << "W=" << row[j] << "\n"; 
 			}
+			fileOut << "</Neuron>" << "\n";
 		}
+			
+		fileOut << "</NLayer>" << "\n";
 	}
 
-	void NLayer::GetWeights(std::vector<float> &out)
+	void NLayer::PopulateLayer(int numOfNeurons, int numOfInputs)
 	{
-		// Calculate the size of the output vector by calculating the amount of weights in each neurons.
-		// Avoids having to use a nasty push-back...
-		size_t size = 0;
-		for (unsigned int i = 0; i < this->totalNeurons; i++)
-		{
-			size += neurons[i].weights.size();
-		}
-		out.resize(size);
+		Allocate(numOfNeurons, numOfInputs);
 
-		// Iterate over each neuron and each connection weight and retrieve the weights
-		for (unsigned int i = 0; i < this->totalNeurons; i++)
+		// Initilise the weights, including the extra bias weight on the end of each row.
+		const int total = GetTotalWeights();
+		for (int i = 0; i < total; i++)
 		{
-			for (unsigned int j = 0; j < neurons[i].weights.size(); j++)
-			{
-				out[totalNeurons * i + j] = neurons[i].weights[j];
-			}
+			weights[i] = RandomClamped();
 		}
 	}
-	
-	void NLayer::SetNeurons(std::vector<Neuron> neurons, int numOfNeurons, int numOfInputs)
+
+	void NLayer::SetWeights(const float* weightsIn, int numOfNeurons, int numOfInputs)
 	{
-		totalInputs = numOfInputs;
+		Allocate(numOfNeurons, numOfInputs);
+		memcpy(weights, weightsIn, GetTotalWeights() * sizeof(float));
+	}
+
+	void NLayer::SetWeights(const std::vector<float> &weightsIn, int numOfNeurons, int numOfInputs)
+	{
+		assert((int)weightsIn.size() >= numOfNeurons * (numOfInputs + 1));
+		SetWeights(&weightsIn[0], numOfNeurons, numOfInputs);
+	}
+
+	void NLayer::GetWeights(std::vector<float> &out) const
+	{
+		// The matrix is already laid out the same way a genome expects it.
+		out.assign(matrix, matrix + GetTotalWeights());
+	}
+
+	void NLayer::SetView(const float* weightsIn, int numOfNeurons, int numOfInputs)
+	{
+		Release();
 		totalNeurons = numOfNeurons;
-		this->neurons = neurons;
+		totalInputs = numOfInputs;
+		matrix = weightsIn;
+	}
+
+	bool NLayer::IsView() const
+	{
+		return matrix != NULL && weights == NULL;
+	}
+
+	int NLayer::GetTotalNeurons() const
+	{
+		return totalNeurons;
+	}
+
+	int NLayer::GetTotalInputs() const
+	{
+		return totalInputs;
 	}
 
+	int NLayer::GetStride() const
+	{
+		return totalInputs + 1;
+	}
+
+	int NLayer::GetTotalWeights() const
+	{
+		return totalNeurons * GetStride();
+	}
+
+	const float* NLayer::GetWeightMatrix() const
+	{
+		return matrix;
+	}
+
+	float* NLayer::GetOwnedWeights()
+	{
+		return weights;
+	}
 	
 }; // End namespace CarDemo.
\ No newline at end of file
@@ -0,0 +1,262 @@
+//****************************************************************************
+//**
+//**    NetFile.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "NetFile.h"
+
+#include "NeuralNet.h"
+#include "NLayer.h"
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+	static_assert(sizeof(NetFileHeader) == 64, "NetFileHeader must stay 64 bytes");
+	static_assert(sizeof(NetFileLayer) == 32, "NetFileLayer must stay 32 bytes");
+
+	inline unsigned int AlignUp(unsigned int value, unsigned int alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	unsigned int NetFileChecksum(const unsigned char* data, unsigned int size)
+	{
+		unsigned int hash = 2166136261u;
+		for (unsigned int i = 0; i < size; i++)
+		{
+			hash ^= data[i];
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	bool WriteNetFile(const NeuralNet& net, const char* filename)
+	{
+		std::vector<const NLayer*> layers;
+		for (int i = 0; i < net.GetNumOfHiddenLayers(); i++)
+		{
+			layers.push_back(net.GetHiddenLayer(i));
+		}
+		if (net.GetOutputLayer() == NULL)
+			return false;
+		layers.push_back(net.GetOutputLayer());
+
+		// Lay the whole file out in memory first so it goes to disk in one write.
+		unsigned int size = AlignUp(sizeof(NetFileHeader) + layers.size() * sizeof(NetFileLayer), NET_FILE_ALIGNMENT);
+		std::vector<unsigned int> offsets(layers.size());
+		for (unsigned int i = 0; i < layers.size(); i++)
+		{
+			offsets[i] = size;
+			size = AlignUp(size + layers[i]->GetTotalWeights() * sizeof(float), NET_FILE_ALIGNMENT);
+		}
+
+		std::vector<unsigned char> buffer(size, 0);
+
+		NetFileLayer* table = (NetFileLayer*)&buffer[sizeof(NetFileHeader)];
+		for (unsigned int i = 0; i < layers.size(); i++)
+		{
+			table[i].inputs = layers[i]->GetTotalInputs();
+			table[i].neurons = layers[i]->GetTotalNeurons();
+			table[i].function = layers[i]->GetFunction();
+			table[i].offset = offsets[i];
+			table[i].weightCount = layers[i]->GetTotalWeights();
+
+			memcpy(&buffer[offsets[i]], layers[i]->GetWeightMatrix(), layers[i]->GetTotalWeights() * sizeof(float));
+		}
+
+		NetFileHeader* header = (NetFileHeader*)&buffer[0];
+		header->magic = NET_FILE_MAGIC;
+		header->version = NET_FILE_VERSION;
+		header->fileSize = size;
+		header->layerCount = layers.size();
+		header->inputs = net.GetTotalInputs();
+		header->outputs = net.GetTotalOutputs();
+		header->checksum = NetFileChecksum(&buffer[sizeof(NetFileHeader)], size - sizeof(NetFileHeader));
+
+		FILE* file = fopen(filename, "wb");
+		if (file == NULL)
+			return false;
+
+		const bool written = fwrite(&buffer[0], 1, size, file) == size;
+		fclose(file);
+		return written;
+	}
+
+	MappedNetFile::MappedNetFile()
+		: data(NULL)
+		, size(0)
+#if defined(_WIN32)
+		, fileHandle(INVALID_HANDLE_VALUE)
+		, mappingHandle(NULL)
+#else
+		, fileHandle(-1)
+#endif
+	{
+	}
+
+	MappedNetFile::~MappedNetFile()
+	{
+		Close();
+	}
+
+	bool MappedNetFile::Open(const char* filename, bool verifyChecksum)
+	{
+		Close();
+
+#if defined(_WIN32)
+		fileHandle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (fileHandle == INVALID_HANDLE_VALUE)
+			return false;
+
+		size = GetFileSize(fileHandle, NULL);
+		if (size == INVALID_FILE_SIZE || size < sizeof(NetFileHeader))
+		{
+			Close();
+			return false;
+		}
+
+		mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mappingHandle == NULL)
+		{
+			Close();
+			return false;
+		}
+
+		data = (const unsigned char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+#else
+		fileHandle = open(filename, O_RDONLY);
+		if (fileHandle < 0)
+			return false;
+
+		struct stat info;
+		if (fstat(fileHandle, &info) != 0 || info.st_size < (off_t)sizeof(NetFileHeader))
+		{
+			Close();
+			return false;
+		}
+		size = (unsigned int)info.st_size;
+
+		void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileHandle, 0);
+		data = mapping == MAP_FAILED ? NULL : (const unsigned char*)mapping;
+#endif
+
+		if (data == NULL || !Validate(verifyChecksum))
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	bool MappedNetFile::Validate(bool verifyChecksum)
+	{
+		const NetFileHeader* header = (const NetFileHeader*)data;
+		if (header->magic != NET_FILE_MAGIC || header->version != NET_FILE_VERSION ||
+			header->fileSize != size || header->layerCount == 0)
+		{
+			return false;
+		}
+
+		if (sizeof(NetFileHeader) + header->layerCount * sizeof(NetFileLayer) > size)
+			return false;
+
+		if (verifyChecksum && NetFileChecksum(data + sizeof(NetFileHeader), size - sizeof(NetFileHeader)) != header->checksum)
+			return false;
+
+		layout.Clear();
+
+		const NetFileLayer* table = (const NetFileLayer*)(data + sizeof(NetFileHeader));
+		for (unsigned int i = 0; i < header->layerCount; i++)
+		{
+			const NetFileLayer& layer = table[i];
+
+			// Every block must be aligned, the right size for its shape, inside the file, and
+			// each layer must take the previous layer's outputs as its inputs.
+			if (layer.offset % NET_FILE_ALIGNMENT != 0 ||
+				(unsigned long long)layer.weightCount != (unsigned long long)layer.neurons * (layer.inputs + 1ULL) ||
+				layer.offset + (unsigned long long)layer.weightCount * sizeof(float) > size ||
+				layer.function >= EVAL_FUNCTION_COUNT ||
+				(i > 0 && layer.inputs != table[i - 1].neurons))
+			{
+				return false;
+			}
+
+			layout.AddLayer(layer.inputs, layer.neurons, (EvalFunction)layer.function);
+		}
+
+		return layout.GetTotalInputs() == (int)header->inputs && layout.GetTotalOutputs() == (int)header->outputs;
+	}
+
+	void MappedNetFile::Close()
+	{
+#if defined(_WIN32)
+		if (data != NULL)
+		{
+			UnmapViewOfFile(data);
+		}
+		if (mappingHandle != NULL)
+		{
+			CloseHandle(mappingHandle);
+			mappingHandle = NULL;
+		}
+		if (fileHandle != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(fileHandle);
+			fileHandle = INVALID_HANDLE_VALUE;
+		}
+#else
+		if (data != NULL)
+		{
+			munmap((void*)data, size);
+		}
+		if (fileHandle >= 0)
+		{
+			close(fileHandle);
+			fileHandle = -1;
+		}
+#endif
+		data = NULL;
+		size = 0;
+		layout.Clear();
+	}
+
+	bool MappedNetFile::IsOpen() const
+	{
+		return data != NULL;
+	}
+
+	const NetworkLayout& MappedNetFile::GetLayout() const
+	{
+		return layout;
+	}
+
+	const float* MappedNetFile::GetLayerWeights(int index) const
+	{
+		if (data == NULL || index < 0 || index >= layout.GetTotalLayers())
+			return NULL;
+
+		const NetFileLayer* table = (const NetFileLayer*)(data + sizeof(NetFileHeader));
+		return (const float*)(data + table[index].offset);
+	}
+
+}; // End namespace CarDemo.
\ No newline at end of file
@@ -0,0 +1,134 @@
+//****************************************************************************
+//**
+//**    NetworkLayout.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <assert.h>
+
+#include "NetworkLayout.h"
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+
+	NetworkLayout::NetworkLayout()
+		: totalWeights(0)
+		, widest(0)
+	{
+	}
+
+	NetworkLayout::NetworkLayout(int numOfHiddenLayers, int numOfInputs, int neuronsPerHidden, int numOfOutputs,
+								 EvalFunction hiddenFunction, EvalFunction outputFunction)
+		: totalWeights(0)
+		, widest(0)
+	{
+		int inputs = numOfInputs;
+		for (int i = 0; i < numOfHiddenLayers; i++)
+		{
+			AddLayer(inputs, neuronsPerHidden, hiddenFunction);
+			inputs = neuronsPerHidden;
+		}
+		AddLayer(inputs, numOfOutputs, outputFunction);
+	}
+
+	void NetworkLayout::Clear()
+	{
+		layers.clear();
+		totalWeights = 0;
+		widest = 0;
+	}
+
+	void NetworkLayout::AddLayer(int inputs, int neurons, EvalFunction function)
+	{
+		assert(layers.empty() || layers.back().neurons == inputs);
+
+		LayerLayout layer;
+		layer.inputs = inputs;
+		layer.neurons = neurons;
+		layer.offset = totalWeights;
+		layer.function = function;
+		layers.push_back(layer);
+
+		totalWeights += neurons * (inputs + 1);
+		if (inputs > widest)
+		{
+			widest = inputs;
+		}
+		if (neurons > widest)
+		{
+			widest = neurons;
+		}
+	}
+
+	int NetworkLayout::GetTotalLayers() const
+	{
+		return layers.size();
+	}
+
+	const LayerLayout& NetworkLayout::GetLayer(int index) const
+	{
+		assert(index >= 0 && index < (int)layers.size());
+		return layers[index];
+	}
+
+	int NetworkLayout::GetNumOfHiddenLayers() const
+	{
+		return layers.empty() ? 0 : layers.size() - 1;
+	}
+
+	const LayerLayout& NetworkLayout::GetOutputLayer() const
+	{
+		assert(!layers.empty());
+		return layers.back();
+	}
+
+	int NetworkLayout::GetTotalInputs() const
+	{
+		return layers.empty() ? 0 : layers.front().inputs;
+	}
+
+	int NetworkLayout::GetTotalOutputs() const
+	{
+		return layers.empty() ? 0 : layers.back().neurons;
+	}
+
+	int NetworkLayout::GetTotalWeights() const
+	{
+		return totalWeights;
+	}
+
+	int NetworkLayout::GetWidest() const
+	{
+		return widest;
+	}
+
+	bool NetworkLayout::operator==(const NetworkLayout& other) const
+	{
+		if (layers.size() != other.layers.size())
+			return false;
+
+		for (unsigned int i = 0; i < layers.size(); i++)
+		{
+			if (layers[i].inputs != other.layers[i].inputs ||
+				layers[i].neurons != other.layers[i].neurons ||
+				layers[i].function != other.layers[i].function)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool NetworkLayout::operator!=(const NetworkLayout& other) const
+	{
+		return !(*this == other);
+	}
+
+}; // End namespace CarDemo.
\ No newline at end of file
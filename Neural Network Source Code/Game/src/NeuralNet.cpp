@@ -12,10 +12,14 @@
 #include <iostream>
 #include <fstream>
 
+#include <assert.h>
+
 #include "NeuralNet.h"
 
 #include "NLayer.h"
 #include "Genome.h"
+#include "NetFile.h"
+#include "TagFileReader.h"
 
 #include "MemoryLeak.h"
 
@@ -25,8 +29,13 @@ namespace CarDemo
 {
 
 	NeuralNet::NeuralNet()
-		: inputLayer(NULL)
+		: inputAmount(0)
+		, outputAmount(0)
+		, inputLayer(NULL)
 		, outputLayer(NULL)
+		, outputs(NULL)
+		, hiddenFunction(EVAL_SIGMOID)
+		, outputFunction(EVAL_SIGMOID)
 	{
 	}
 
@@ -55,31 +64,69 @@ namespace CarDemo
 
 	void NeuralNet::Update()
 	{
-		outputs.clear();
+		const float* layerInput = &inputs[0];
+		int current = 0;
 
 		for (unsigned int i = 0; i < hiddenLayers.size(); i++)
 		{
-			if (i > 0)
-			{
-				inputs = outputs;
-			}
+			float* layerOutput = &activations[current][0];
+			hiddenLayers[i]->Evaluate(layerInput, layerOutput);
 
-			hiddenLayers[i]->Evaluate(inputs, outputs);
+			// This layers output becomes the next layers input.
+			layerInput = layerOutput;
+			current = 1 - current;
 		}
 
-		inputs = outputs;
 		// Process the layeroutputs through the output llayer to 
-		outputLayer->Evaluate(inputs, outputs);
+		float* layerOutput = &activations[current][0];
+		outputLayer->Evaluate(layerInput, layerOutput);
+		outputs = layerOutput;
+	}
+
+	void NeuralNet::SetInput(const float* in, int count)
+	{
+		if (count > inputAmount)
+			count = inputAmount;
+
+		for (int i = 0; i < count; i++)
+		{
+			inputs[i] = in[i];
+		}
 	}
 
-	void NeuralNet::SetInput(std::vector<float> in)
+	void NeuralNet::SetInput(const std::vector<float> &in)
 	{
-		inputs = in;
+		if (in.empty())
+			return;
+
+		SetInput(&in[0], in.size());
+	}
+
+	void NeuralNet::AllocateBuffers()
+	{
+		// Size the ping-pong buffers to the widest layer in the net.
+		int widest = outputAmount;
+		for (unsigned int i = 0; i < hiddenLayers.size(); i++)
+		{
+			if (hiddenLayers[i]->GetTotalNeurons() > widest)
+			{
+				widest = hiddenLayers[i]->GetTotalNeurons();
+			}
+		}
+		if (outputLayer != NULL && outputLayer->GetTotalNeurons() > widest)
+		{
+			widest = outputLayer->GetTotalNeurons();
+		}
+
+		inputs.assign(inputAmount > 0 ? inputAmount : 1, 0.0f);
+		activations[0].assign(widest > 0 ? widest : 1, 0.0f);
+		activations[1].assign(widest > 0 ? widest : 1, 0.0f);
+		outputs = NULL;
 	}
 
 	float NeuralNet::GetOutput(unsigned int ID)
 	{
-		if (ID >= outputAmount)
+		if (ID >= outputAmount || outputs == NULL)
 			return 0.0f;
 		return outputs[ID];
 	}
@@ -89,16 +136,34 @@ namespace CarDemo
 		return outputAmount;
 	}
 
-	void NeuralNet::ExportNet(char* filename)
+	int NeuralNet::GetTotalInputs() const
+	{
+		return inputAmount;
+	}
+
+	const NLayer* NeuralNet::GetHiddenLayer(int index) const
+	{
+		if (index < 0 || index >= (int)hiddenLayers.size())
+			return NULL;
+
+		return hiddenLayers[index];
+	}
+
+	const NLayer* NeuralNet::GetOutputLayer() const
+	{
+		return outputLayer;
+	}
+
+	void NeuralNet::ExportNet(const char* filename)
 	{
 		char buff[128] = {0};
 		sprintf(buff, "ExportedNNs/%s", filename);
 		std::ofstream file;
 		file.open(buff);
 
-		file << "<NeuralNetwork>" << endl;
-		file <<"TotalOuputs=" << this->outputAmount << endl;
-		file <<"TotalInputs=" << this->inputAmount << endl;
+		file << "<NeuralNetwork>" << "\n";
+		file <<"TotalOuputs=" << this->outputAmount << "\n";
+		file <<"TotalInputs=" << this->inputAmount << "\n";
 		// Export hidden layerss.
 		for (unsigned int i = 0; i < hiddenLayers.size(); i++)
 		{
@@ -106,159 +171,207 @@ namespace CarDemo
 		}
 		// Export output layer.
 		outputLayer->SaveLayer(file, "Output");
-		file << "</NeuralNetwork>" << endl;
+		file << "</NeuralNetwork>" << "\n";
 
 		file.close();
 	}
 
-	void NeuralNet::LoadNet(char* filename)
+	bool NeuralNet::ExportBinaryNet(const char* filename)
 	{
-		FILE* file = fopen(filename,"rt");
+		char buff[128] = {0};
+		sprintf(buff, "ExportedNNs/%s", filename);
+		return WriteNetFile(*this, buff);
+	}
 
-		if(file!=NULL)
+	void NeuralNet::LoadNet(const char* filename)
+	{
+		TagFileReader reader;
+
+		if(reader.Open(filename))
 		{
+			ReleaseNet();
+
 			enum LayerType
 			{
 				HIDDEN,
 				OUTPUT,
 			};
 
-			float weight = 0.0f;
 			int totalNeurons = 0;
 			int totalWeights = 0;
 			int totalInputs = 0;
-			int currentNeuron = 0;
-			std::vector<Neuron> neurons;
 			std::vector<float> weights;
 			LayerType type = HIDDEN;
+			EvalFunction function = EVAL_SIGMOID;
 
-
-			char buffComp[1024] ={0};
-
-			while(fgets(buffComp,1024,file))
+			while(reader.NextLine())
 			{
-				char buff[1024] = {0};
-
-				if(buffComp[strlen(buffComp)-1]=='\n')
-				{
-					for(unsigned int i = 0; i<strlen(buffComp)-1;i++)
-					{
-						buff[i] = buffComp[i];
-					}
-				}
-
-				if(0 == strcmp(buff, "<NeuralNetwork>"))
+				if(reader.IsLine("<NeuralNetwork>"))
 				{
 				}
-				else if (0 == strcmp(buff,"</NeuralNetwork>"))
+				else if (reader.IsLine("</NeuralNetwork>"))
 				{
 					break;
 				}
-				else if (0 == strcmp(buff,"<NLayer>"))
+				else if (reader.IsLine("<NLayer>"))
 				{
-					weight = 0.0f;
 					totalNeurons = 0;
 					totalWeights = 0;
 					totalInputs = 0;
-					currentNeuron = 0;
-					neurons.clear();
+					weights.clear();
 					type = HIDDEN;
+					function = EVAL_SIGMOID;
 				}
-				else if (0 == strcmp(buff,"</NLayer>"))
+				else if (reader.IsLine("</NLayer>"))
 				{
+					// Each neuron row holds its inputs plus the bias, so trust the row width 
+					// over the 'Inputs' field (older exports wrote garbage into it).
+					if (totalWeights > 0)
+					{
+						totalInputs = totalWeights - 1;
+					}
+
 					NLayer* layer = new NLayer();
-					layer->SetNeurons(neurons, neurons.size(), totalInputs);
+					layer->SetWeights(weights, totalNeurons, totalInputs);
+					layer->SetFunction(function);
 					switch (type)
 					{
 					case HIDDEN:
 						this->hiddenLayers.push_back(layer);
+						this->hiddenFunction = function;
 						layer = NULL;
 						break;
 					case OUTPUT:
 						this->outputLayer = layer;
+						this->outputFunction = function;
 						layer = NULL;
 						break;
 					};
 				}
-				else if (0 == strcmp(buff,"<Neuron>"))
+				else if (reader.IsKey("W"))
 				{
-					weights.clear();
-				}
-				else if (0 == strcmp(buff,"</Neuron>"))
+					weights.push_back(reader.GetFloat());
+				} 
+				else if (reader.IsKey("Type"))
 				{
-					neurons[currentNeuron].Initilise(weights, totalInputs);
-					currentNeuron++;
-				}
-			
-				else
-				{
-					char* token = strtok(buff, "=");
-					if(token != NULL)
+					if (reader.ValueIs("Hidden"))
+					{
+						type = HIDDEN;
+					}
+					else if (reader.ValueIs("Output"))
 					{
-						char* value = strtok(NULL,"=");
-
-
-						if (0 == strcmp(token,"Type"))
-						{
-							if (0 == strcmp("Hidden", value))
-							{
-								type = HIDDEN;
-							}
-							else if (0 == strcmp("Output", value))
-							{
-								type = OUTPUT;
-							}
-						}
-						else if (0 == strcmp(token,"Inputs"))
-						{
-							totalInputs = atoi(value);
-						} 
-						else if (0 == strcmp(token,"Neurons"))
-						{
-							totalNeurons = atoi(value);
-						} 
-						else if (0 == strcmp(token,"Weights"))
-						{
-							totalWeights = atoi(value);
-						} 
-						else if (0 == strcmp(token,"W"))
-						{
-							weight = (float)atof(value);
-						} 
-						else if (0 == strcmp(token,"TotalOuputs"))
-						{
-							outputAmount = atoi(value);
-						} 
-						else if (0 == strcmp(token,"TotalInputs"))
-						{
-							inputAmount = atoi(value);
-						} 
+						type = OUTPUT;
 					}
 				}
+				else if (reader.IsKey("Inputs"))
+				{
+					totalInputs = reader.GetInt();
+				} 
+				else if (reader.IsKey("Neurons"))
+				{
+					totalNeurons = reader.GetInt();
+				} 
+				else if (reader.IsKey("Function"))
+				{
+					function = ParseEvalFunction(reader.GetValue());
+				} 
+				else if (reader.IsKey("Weights"))
+				{
+					totalWeights = reader.GetInt();
+				} 
+				else if (reader.IsKey("TotalOuputs"))
+				{
+					outputAmount = reader.GetInt();
+				} 
+				else if (reader.IsKey("TotalInputs"))
+				{
+					inputAmount = reader.GetInt();
+				} 
 			}
-			fclose(file);
+
+			AllocateBuffers();
 		}
 	}
 
 	void NeuralNet::CreateNet(int numOfHiddenLayers, int numOfInputs, int neuronsPerHidden, int numOfOutputs)
 	{
-		inputAmount = numOfInputs;
-		outputAmount = numOfOutputs;
+		CreateNet(NetworkLayout(numOfHiddenLayers, numOfInputs, neuronsPerHidden, numOfOutputs, hiddenFunction, outputFunction));
+	}
+
+	void NeuralNet::CreateNet(const NetworkLayout& layout)
+	{
+		ReleaseNet();
+
+		inputAmount = layout.GetTotalInputs();
+		outputAmount = layout.GetTotalOutputs();
 
-		for (unsigned int i = 0; i < numOfHiddenLayers; i++)
+		for (int i = 0; i < layout.GetTotalLayers(); i++)
 		{
+			const LayerLayout& shape = layout.GetLayer(i);
+
 			NLayer* layer = new NLayer();
-			layer->PopulateLayer(neuronsPerHidden, numOfInputs);
-			hiddenLayers.push_back(layer);
+			layer->PopulateLayer(shape.neurons, shape.inputs);
+			layer->SetFunction(shape.function);
+
+			if (i < layout.GetNumOfHiddenLayers())
+			{
+				hiddenLayers.push_back(layer);
+			}
+			else
+			{
+				outputLayer = layer;
+			}
 		}
 
-		outputLayer = new NLayer();
-		outputLayer->PopulateLayer(numOfOutputs, neuronsPerHidden);		
+		AllocateBuffers();
+	}
+
+	void NeuralNet::GetLayout(NetworkLayout& out) const
+	{
+		out.Clear();
+		for (unsigned int i = 0; i < hiddenLayers.size(); i++)
+		{
+			out.AddLayer(hiddenLayers[i]->GetTotalInputs(), hiddenLayers[i]->GetTotalNeurons(), hiddenLayers[i]->GetFunction());
+		}
+		if (outputLayer != NULL)
+		{
+			out.AddLayer(outputLayer->GetTotalInputs(), outputLayer->GetTotalNeurons(), outputLayer->GetFunction());
+		}
+	}
+
+	void NeuralNet::SetHiddenFunction(EvalFunction function)
+	{
+		hiddenFunction = function;
+		for (unsigned int i = 0; i < hiddenLayers.size(); i++)
+		{
+			hiddenLayers[i]->SetFunction(function);
+		}
+	}
+
+	void NeuralNet::SetOutputFunction(EvalFunction function)
+	{
+		outputFunction = function;
+		if (outputLayer != NULL)
+		{
+			outputLayer->SetFunction(function);
+		}
+	}
+
+	EvalFunction NeuralNet::GetHiddenFunction() const
+	{
+		return hiddenFunction;
+	}
+
+	EvalFunction NeuralNet::GetOutputFunction() const
+	{
+		return outputFunction;
 	}
 
 	
 	void NeuralNet::ReleaseNet()
 	{
+		outputs = NULL;
+
 		if (inputLayer != NULL)
 		{
 			delete inputLayer;
@@ -280,21 +393,21 @@ namespace CarDemo
 		hiddenLayers.clear();
 	}
 
-	int NeuralNet::GetNumOfHiddenLayers()
+	int NeuralNet::GetNumOfHiddenLayers() const
 	{
 		return hiddenLayers.size();
 	}
 	
-	Genome* NeuralNet::ToGenome()
+	void NeuralNet::ToGenome(std::vector<float> &out)
 	{
-		Genome* genome = new Genome();
+		out.clear();
 		for (unsigned int i = 0; i < this->hiddenLayers.size(); i++)
 		{
 			std::vector<float> weights;
 			hiddenLayers[i]->GetWeights(weights);
 			for (unsigned int j = 0; j < weights.size(); j++)
 			{
-				genome->weights.push_back(weights[j]);
+				out.push_back(weights[j]);
 			}
 		}
 			
@@ -302,51 +415,120 @@ namespace CarDemo
 		outputLayer->GetWeights(weights);
 		for (unsigned int i = 0; i < weights.size(); i++)
 		{
-			genome->weights.push_back(weights[i]);
+			out.push_back(weights[i]);
 		}
-		
-		return genome;
 	}
 	
 	void NeuralNet::FromGenome(const Genome& genome, int numOfInputs, int neuronsPerHidden, int numOfOutputs)
+	{
+		FromGenome(genome, NetworkLayout(1, numOfInputs, neuronsPerHidden, numOfOutputs, hiddenFunction, outputFunction));
+	}
+
+	void NeuralNet::FromGenome(const Genome& genome, const NetworkLayout& layout)
 	{		
+		assert(genome.totalWeights >= layout.GetTotalWeights());
+
+		// Already a view of this shape, so there is nothing to rebuild.
+		if (MatchesLayout(layout) && BindGenome(genome))
+			return;
+
 		ReleaseNet();
 
-		outputAmount = numOfOutputs;
-		inputAmount = numOfInputs;
-		int weightsForHidden = numOfInputs * neuronsPerHidden;
-		NLayer* hidden = new NLayer();
-		std::vector<Neuron> neurons;
-		neurons.resize(neuronsPerHidden);
-		for (unsigned int i = 0; i < neuronsPerHidden; i++)
+		inputAmount = layout.GetTotalInputs();
+		outputAmount = layout.GetTotalOutputs();
+
+		// The genome is laid out exactly like the layer matrices, so each layer just points at
+		// its slice of it.
+		const float* weights = genome.weights;
+		for (int i = 0; i < layout.GetTotalLayers(); i++)
 		{
-			std::vector<float> weights;
-			weights.resize(numOfInputs + 1);
-			for (unsigned int j = 0; j < numOfInputs + 1; j++)
-			{
-				weights[j] = genome.weights[i * neuronsPerHidden + j];
-			}
-			neurons[i].Initilise(weights, numOfInputs);
+			const LayerLayout& shape = layout.GetLayer(i);
+			AddLayerView(shape, weights + shape.offset, i == layout.GetNumOfHiddenLayers());
 		}
-		hidden->LoadLayer(neurons);
-		this->hiddenLayers.push_back(hidden);
-
-		// Clear weights and reasign the weights to the output.
-		int weightsForOutput = neuronsPerHidden * numOfOutputs;
-		neurons.clear();
-		neurons.resize(numOfOutputs);
-		for (unsigned int i = 0; i < numOfOutputs; i++)
+
+		AllocateBuffers();
+	}
+
+	void NeuralNet::FromNetFile(const MappedNetFile& file)
+	{
+		ReleaseNet();
+
+		const NetworkLayout& layout = file.GetLayout();
+		inputAmount = layout.GetTotalInputs();
+		outputAmount = layout.GetTotalOutputs();
+
+		for (int i = 0; i < layout.GetTotalLayers(); i++)
 		{
-			std::vector<float> weights;
-			weights.resize(neuronsPerHidden + 1);
-			for (unsigned int j = 0; j < neuronsPerHidden + 1; j++)
+			AddLayerView(layout.GetLayer(i), file.GetLayerWeights(i), i == layout.GetNumOfHiddenLayers());
+		}
+
+		AllocateBuffers();
+	}
+
+	void NeuralNet::AddLayerView(const LayerLayout& shape, const float* weights, bool isOutput)
+	{
+		NLayer* layer = new NLayer();
+		layer->SetView(weights, shape.neurons, shape.inputs);
+		layer->SetFunction(shape.function);
+
+		if (isOutput)
+		{
+			outputLayer = layer;
+		}
+		else
+		{
+			hiddenLayers.push_back(layer);
+		}
+	}
+
+	bool NeuralNet::BindGenome(const Genome& genome)
+	{
+		if (outputLayer == NULL || !outputLayer->IsView())
+			return false;
+
+		int totalWeights = outputLayer->GetTotalWeights();
+		for (unsigned int i = 0; i < hiddenLayers.size(); i++)
+		{
+			if (!hiddenLayers[i]->IsView())
+				return false;
+
+			totalWeights += hiddenLayers[i]->GetTotalWeights();
+		}
+		if (genome.totalWeights < totalWeights)
+			return false;
+
+		const float* weights = genome.weights;
+		for (unsigned int i = 0; i < hiddenLayers.size(); i++)
+		{
+			NLayer* layer = hiddenLayers[i];
+			layer->SetView(weights, layer->GetTotalNeurons(), layer->GetTotalInputs());
+			weights += layer->GetTotalWeights();
+		}
+		outputLayer->SetView(weights, outputLayer->GetTotalNeurons(), outputLayer->GetTotalInputs());
+
+		// The last outputs belonged to the previous genome.
+		outputs = NULL;
+		return true;
+	}
+
+	bool NeuralNet::MatchesLayout(const NetworkLayout& layout) const
+	{
+		if (outputLayer == NULL || layout.GetNumOfHiddenLayers() != (int)hiddenLayers.size())
+			return false;
+
+		for (int i = 0; i < layout.GetTotalLayers(); i++)
+		{
+			const LayerLayout& shape = layout.GetLayer(i);
+			const NLayer* layer = i < layout.GetNumOfHiddenLayers() ? hiddenLayers[i] : outputLayer;
+
+			if (layer->GetTotalInputs() != shape.inputs ||
+				layer->GetTotalNeurons() != shape.neurons ||
+				layer->GetFunction() != shape.function)
 			{
-				weights[j] = genome.weights[i * neuronsPerHidden + j];
+				return false;
 			}
-			neurons[i].Initilise(weights, neuronsPerHidden);
 		}
-		outputLayer = new NLayer();
-		this->outputLayer->LoadLayer(neurons);
+		return true;
 	}
 
 }; // End namespace CarDemo.
\ No newline at end of file
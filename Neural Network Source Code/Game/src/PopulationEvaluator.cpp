@@ -0,0 +1,87 @@
+//****************************************************************************
+//**
+//**    PopulationEvaluator.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include "PopulationEvaluator.h"
+
+#include "Genome.h"
+#include "GeneticAlgorithm.h"
+#include "NeuralNet.h"
+#include "TrackGeometry.h"
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+	PopulationEvaluator::PopulationEvaluator(const TrackGeometry& trackIn, const std::vector<Checkpoint>& checkpointsIn,
+											 const NetworkLayout& layoutIn, int threadCount)
+		: track(&trackIn)
+		, checkpoints(&checkpointsIn)
+		, layout(layoutIn)
+		, pool(threadCount)
+	{
+		workers.resize(pool.GetThreadCount());
+		for (unsigned int i = 0; i < workers.size(); i++)
+		{
+			workers[i].simulation = new Simulation(trackIn, checkpointsIn);
+			workers[i].net = new NeuralNet();
+		}
+	}
+
+	PopulationEvaluator::~PopulationEvaluator()
+	{
+		for (unsigned int i = 0; i < workers.size(); i++)
+		{
+			delete workers[i].simulation;
+			delete workers[i].net;
+		}
+		workers.clear();
+	}
+
+	int PopulationEvaluator::GetThreadCount() const
+	{
+		return pool.GetThreadCount();
+	}
+
+	void PopulationEvaluator::Evaluate(GeneticAlgorithm& genAlg)
+	{
+		const int totalPopulation = genAlg.GetTotalPopulation();
+		fitnesses.assign(totalPopulation, 0.0f);
+
+		// Each task only writes its own slot, and the results are handed back in population
+		// order once every episode is done.
+		pool.Run(totalPopulation, [&](int task, int worker)
+		{
+			const Genome genome = genAlg.GetGenome(task);
+			if (!genome.IsEmpty())
+			{
+				fitnesses[task] = RunEpisode(genome, workers[worker]);
+			}
+		});
+
+		for (int i = 0; i < totalPopulation; i++)
+		{
+			genAlg.SetGenomeFitness(fitnesses[i], i);
+		}
+	}
+
+	float PopulationEvaluator::EvaluateGenome(const Genome& genome)
+	{
+		return RunEpisode(genome, workers[0]);
+	}
+
+	float PopulationEvaluator::RunEpisode(const Genome& genome, WorkerState& state)
+	{
+		state.net->FromGenome(genome, layout);
+		state.simulation->Reset(state.net);
+		return state.simulation->Run();
+	}
+
+}; // End namespace CarDemo.
\ No newline at end of file
@@ -0,0 +1,451 @@
+//****************************************************************************
+//**
+//**    QuantizedNeuralNet.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+
+#include "QuantizedNeuralNet.h"
+
+#include "AlignedMemory.h"
+#include "LayerKernels.h"
+#include "NeuralNet.h"
+#include "NLayer.h"
+#include "Agent.h"
+#include "TagFileReader.h"
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+	// Largest magnitude an int8 weight or input is allowed to take. -128 is left unused so the
+	// range stays symmetric about zero.
+	const int INT8_LIMIT = 127;
+
+	inline int RoundToInt(float value)
+	{
+		return (int)(value + (value >= 0.0f ? 0.5f : -0.5f));
+	}
+
+	inline int ClampToInt8(float value)
+	{
+		int q = RoundToInt(value);
+		q = q > INT8_LIMIT ? INT8_LIMIT : q;
+		q = q < -INT8_LIMIT ? -INT8_LIMIT : q;
+		return q;
+	}
+
+	// ----------------------------------------------------------------------
+	// IEEE 754 half precision. Values too small for a normal half are flushed
+	// to zero, which is far below anything a weight cares about.
+	// ----------------------------------------------------------------------
+	static unsigned short FloatToHalf(float value)
+	{
+		union { float f; unsigned int u; } bits;
+		bits.f = value;
+
+		const unsigned int sign = (bits.u >> 16) & 0x8000;
+		const int exponent = (int)((bits.u >> 23) & 0xff) - 127 + 15;
+		unsigned int mantissa = bits.u & 0x7fffff;
+
+		if (((bits.u >> 23) & 0xff) == 0xff)
+		{
+			// Infinity or NaN.
+			return (unsigned short)(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+		}
+		if (exponent <= 0)
+		{
+			return (unsigned short)sign;
+		}
+		if (exponent >= 31)
+		{
+			return (unsigned short)(sign | 0x7c00);
+		}
+
+		// Round the 23 bit mantissa to 10 bits, to nearest even. A carry out of the mantissa
+		// correctly bumps the exponent.
+		unsigned int half = sign | (exponent << 10) | (mantissa >> 13);
+		const unsigned int dropped = mantissa & 0x1fff;
+		if (dropped > 0x1000 || (dropped == 0x1000 && (half & 1)))
+		{
+			half++;
+		}
+		return (unsigned short)half;
+	}
+
+	QuantizedNeuralNet::QuantizedNeuralNet()
+		: format(QUANTIZE_INT8)
+		, inputAmount(0)
+		, outputAmount(0)
+		, quantizedInput(NULL)
+		, sums(NULL)
+	{
+	}
+
+	QuantizedNeuralNet::~QuantizedNeuralNet()
+	{
+		Release();
+	}
+
+	void QuantizedNeuralNet::Release()
+	{
+		for (unsigned int i = 0; i < layers.size(); i++)
+		{
+			AlignedFree(layers[i].weights);
+			AlignedFree(layers[i].halfWeights);
+		}
+		layers.clear();
+
+		AlignedFree(quantizedInput);
+		AlignedFree(sums);
+		quantizedInput = NULL;
+		sums = NULL;
+
+		inputAmount = 0;
+		outputAmount = 0;
+	}
+
+	void QuantizedNeuralNet::Quantize(const NeuralNet& net, QuantizeFormat formatIn, const float* calibration, int samples)
+	{
+		Release();
+
+		format = formatIn;
+		inputAmount = net.GetTotalInputs();
+		outputAmount = net.GetTotalOutputs();
+
+		std::vector<const NLayer*> source;
+		for (int i = 0; i < net.GetNumOfHiddenLayers(); i++)
+		{
+			source.push_back(net.GetHiddenLayer(i));
+		}
+		source.push_back(net.GetOutputLayer());
+
+		int widest = inputAmount;
+		for (unsigned int i = 0; i < source.size(); i++)
+		{
+			if (source[i]->GetTotalNeurons() > widest)
+			{
+				widest = source[i]->GetTotalNeurons();
+			}
+		}
+
+		// Every layer also sees the constant bias input, so its range always covers |BIAS|.
+		std::vector<float> maxInputs(source.size(), fabsf(BIAS));
+		if (samples <= 0)
+		{
+			maxInputs[0] = 1.0f;
+		}
+
+		// Calibrate by running the recorded inputs through the float layers and noting the
+		// largest magnitude that reaches each one.
+		std::vector<float> current(widest);
+		std::vector<float> next(widest);
+		for (int s = 0; s < samples; s++)
+		{
+			memcpy(&current[0], calibration + s * inputAmount, inputAmount * sizeof(float));
+			int width = inputAmount;
+
+			for (unsigned int l = 0; l < source.size(); l++)
+			{
+				for (int j = 0; j < width; j++)
+				{
+					if (fabsf(current[j]) > maxInputs[l])
+					{
+						maxInputs[l] = fabsf(current[j]);
+					}
+				}
+
+				source[l]->Evaluate(&current[0], &next[0]);
+				width = source[l]->GetTotalNeurons();
+				current.swap(next);
+			}
+		}
+
+		layers.resize(source.size());
+		int maxStride = 0;
+		for (unsigned int l = 0; l < source.size(); l++)
+		{
+			QuantizeLayer(*source[l], maxInputs[l], layers[l]);
+
+			if (layers[l].stride > maxStride)
+			{
+				maxStride = layers[l].stride;
+			}
+		}
+
+		quantizedInput = (short*)AlignedMalloc(maxStride * sizeof(short), CACHE_LINE_ALIGNMENT);
+		sums = (int*)AlignedMalloc(widest * sizeof(int), CACHE_LINE_ALIGNMENT);
+		activations[0].assign(widest, 0.0f);
+		activations[1].assign(widest, 0.0f);
+	}
+
+	void QuantizedNeuralNet::QuantizeLayer(const NLayer& layer, float maxInput, QuantizedLayer& out)
+	{
+		const float* source = layer.GetWeightMatrix();
+		const int total = layer.GetTotalWeights();
+
+		out.inputs = layer.GetTotalInputs();
+		out.neurons = layer.GetTotalNeurons();
+		out.function = layer.GetFunction();
+		out.weights = NULL;
+		out.halfWeights = NULL;
+		out.weightScale = 1.0f;
+		out.inputScale = 1.0f;
+
+		if (format == QUANTIZE_FP16)
+		{
+			// Same row layout as the float matrix, the half kernels walk it the same way.
+			out.stride = layer.GetStride();
+			out.halfWeights = (unsigned short*)AlignedMalloc(total * sizeof(unsigned short), CACHE_LINE_ALIGNMENT);
+			for (int i = 0; i < total; i++)
+			{
+				out.halfWeights[i] = FloatToHalf(source[i]);
+			}
+			return;
+		}
+
+		out.stride = ((layer.GetStride() + INT8_ROW_ALIGNMENT - 1) / INT8_ROW_ALIGNMENT) * INT8_ROW_ALIGNMENT;
+
+		float maxWeight = 0.0f;
+		for (int i = 0; i < total; i++)
+		{
+			if (fabsf(source[i]) > maxWeight)
+			{
+				maxWeight = fabsf(source[i]);
+			}
+		}
+		if (maxWeight > 0.0f)
+		{
+			out.weightScale = maxWeight / INT8_LIMIT;
+		}
+		if (maxInput > 0.0f)
+		{
+			out.inputScale = maxInput / INT8_LIMIT;
+		}
+
+		// Zero the padding so it adds nothing to the sums.
+		out.weights = (signed char*)AlignedMalloc(out.neurons * out.stride, CACHE_LINE_ALIGNMENT);
+		memset(out.weights, 0, out.neurons * out.stride);
+
+		const int sourceStride = layer.GetStride();
+		for (int n = 0; n < out.neurons; n++)
+		{
+			for (int j = 0; j < sourceStride; j++)
+			{
+				out.weights[n * out.stride + j] = (signed char)ClampToInt8(source[n * sourceStride + j] / out.weightScale);
+			}
+		}
+	}
+
+	void QuantizedNeuralNet::EvaluateLayer(const QuantizedLayer& layer, const float* input, float* output)
+	{
+		if (format == QUANTIZE_FP16)
+		{
+			GetDenseHalfKernel()(layer.halfWeights, layer.neurons, layer.inputs, input, output);
+		}
+		else
+		{
+			// Inputs outside the calibrated range saturate rather than wrap.
+			const float toInt8 = 1.0f / layer.inputScale;
+			for (int j = 0; j < layer.inputs; j++)
+			{
+				quantizedInput[j] = (short)ClampToInt8(input[j] * toInt8);
+			}
+			quantizedInput[layer.inputs] = (short)ClampToInt8(BIAS * toInt8);
+			for (int j = layer.inputs + 1; j < layer.stride; j++)
+			{
+				quantizedInput[j] = 0;
+			}
+
+			GetDenseInt8Kernel()(layer.weights, layer.neurons, layer.stride, quantizedInput, sums);
+
+			const float toFloat = layer.weightScale * layer.inputScale;
+			for (int n = 0; n < layer.neurons; n++)
+			{
+				output[n] = (float)sums[n] * toFloat;
+			}
+		}
+
+		ApplyActivation(layer.function, output, layer.neurons);
+	}
+
+	void QuantizedNeuralNet::Update(const float* input, float* output)
+	{
+		const float* layerInput = input;
+		int current = 0;
+
+		for (unsigned int l = 0; l < layers.size(); l++)
+		{
+			// The last layer writes straight into the callers buffer.
+			float* layerOutput = (l + 1 == layers.size()) ? output : &activations[current][0];
+			EvaluateLayer(layers[l], layerInput, layerOutput);
+
+			layerInput = layerOutput;
+			current = 1 - current;
+		}
+	}
+
+	QuantizationReport QuantizedNeuralNet::CompareOpenLoop(NeuralNet& net, const float* inputs, int samples)
+	{
+		QuantizationReport report;
+		report.samples = samples;
+		report.maxError = 0.0f;
+		report.meanError = 0.0f;
+		report.maxSteerError = 0.0f;
+		report.quantizedBytes = GetWeightBytes();
+		report.floatBytes = 0;
+
+		for (int i = 0; i < net.GetNumOfHiddenLayers(); i++)
+		{
+			report.floatBytes += net.GetHiddenLayer(i)->GetTotalWeights() * sizeof(float);
+		}
+		report.floatBytes += net.GetOutputLayer()->GetTotalWeights() * sizeof(float);
+
+		std::vector<float> expected(outputAmount);
+		std::vector<float> actual(outputAmount);
+		double totalError = 0.0;
+
+		for (int s = 0; s < samples; s++)
+		{
+			const float* sample = inputs + s * inputAmount;
+
+			net.SetInput(sample, inputAmount);
+			net.Update();
+			for (int i = 0; i < outputAmount; i++)
+			{
+				expected[i] = net.GetOutput(i);
+			}
+
+			Update(sample, &actual[0]);
+
+			for (int i = 0; i < outputAmount; i++)
+			{
+				const float error = fabsf(expected[i] - actual[i]);
+				totalError += error;
+				if (error > report.maxError)
+				{
+					report.maxError = error;
+				}
+			}
+
+			// The agent turns by the difference of its two track forces.
+			if (outputAmount == NN_OUTPUT_COUNT)
+			{
+				const float expectedSteer = expected[NN_OUTPUT_LEFT_FORCE] - expected[NN_OUTPUT_RIGHT_FORCE];
+				const float actualSteer = actual[NN_OUTPUT_LEFT_FORCE] - actual[NN_OUTPUT_RIGHT_FORCE];
+				const float error = fabsf(expectedSteer - actualSteer);
+				if (error > report.maxSteerError)
+				{
+					report.maxSteerError = error;
+				}
+			}
+		}
+
+		if (samples > 0 && outputAmount > 0)
+		{
+			report.meanError = (float)(totalError / ((double)samples * outputAmount));
+		}
+		return report;
+	}
+
+	int QuantizedNeuralNet::GetTotalInputs() const
+	{
+		return inputAmount;
+	}
+
+	int QuantizedNeuralNet::GetTotalOutputs() const
+	{
+		return outputAmount;
+	}
+
+	QuantizeFormat QuantizedNeuralNet::GetFormat() const
+	{
+		return format;
+	}
+
+	int QuantizedNeuralNet::GetWeightBytes() const
+	{
+		int bytes = 0;
+		for (unsigned int i = 0; i < layers.size(); i++)
+		{
+			if (format == QUANTIZE_FP16)
+			{
+				bytes += layers[i].neurons * layers[i].stride * sizeof(unsigned short);
+			}
+			else
+			{
+				bytes += layers[i].neurons * layers[i].stride + 2 * sizeof(float);
+			}
+		}
+		return bytes;
+	}
+
+	void ExportSensorRecording(const char* filename, const std::vector<float> &inputs, int inputsPerSample)
+	{
+		char buff[128] = {0};
+		sprintf(buff, "ExportedNNs/%s", filename);
+		std::ofstream file;
+		file.open(buff);
+
+		file << "<SensorRecording>" << "\n";
+		file << "Inputs=" << inputsPerSample << "\n";
+		file << "Samples=" << (inputsPerSample > 0 ? (int)inputs.size() / inputsPerSample : 0) << "\n";
+		for (unsigned int i = 0; i < inputs.size(); i++)
+		{
+			file << "I=" << inputs[i] << "\n";
+		}
+		file << "</SensorRecording>" << "\n";
+
+		file.close();
+	}
+
+	bool LoadSensorRecording(const char* filename, std::vector<float> &inputs, int &inputsPerSample)
+	{
+		TagFileReader reader;
+		if (!reader.Open(filename))
+			return false;
+
+		inputs.clear();
+		inputsPerSample = 0;
+
+		while (reader.NextLine())
+		{
+			if (reader.IsKey("I"))
+			{
+				inputs.push_back(reader.GetFloat());
+			}
+			else if (reader.IsKey("Inputs"))
+			{
+				inputsPerSample = reader.GetInt();
+			}
+		}
+
+		// Drop any partial sample at the end.
+		if (inputsPerSample > 0)
+		{
+			inputs.resize(inputs.size() - inputs.size() % inputsPerSample);
+		}
+		return inputsPerSample > 0;
+	}
+
+	void PrintQuantizationReport(const QuantizationReport& report, std::ostream& out)
+	{
+		out << "Open loop samples: " << report.samples << std::endl;
+		out << "Max output error: " << report.maxError << std::endl;
+		out << "Mean output error: " << report.meanError << std::endl;
+		out << "Max steering error: " << report.maxSteerError << std::endl;
+		out << "Weight memory: " << report.floatBytes << " bytes float, "
+			<< report.quantizedBytes << " bytes quantized" << std::endl;
+	}
+
+}; // End namespace CarDemo.
\ No newline at end of file
@@ -0,0 +1,289 @@
+//****************************************************************************
+//**
+//**    RandomStream.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <cmath>
+#include <atomic>
+#include <mutex>
+
+#include "RandomStream.h"
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+	// The jump polynomials published with xoshiro128**: 2^64 and 2^96 draws ahead.
+	static const unsigned int JUMP[4] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+	static const unsigned int LONG_JUMP[4] = { 0xb523952e, 0x0b6f099f, 0xccf5a0ef, 0x1c580662 };
+
+	// How many generators the bulk fills run side by side.
+	static const int FILL_LANES = 8;
+
+	static unsigned long long SplitMix64(unsigned long long& x)
+	{
+		unsigned long long z = (x += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+	RandomStream::RandomStream()
+	{
+		Seed(DEFAULT_RANDOM_SEED);
+	}
+
+	RandomStream::RandomStream(unsigned long long seed)
+	{
+		Seed(seed);
+	}
+
+	void RandomStream::Seed(unsigned long long seed)
+	{
+		// SplitMix64 spreads any seed over the whole state and never gives all zeros.
+		const unsigned long long low = SplitMix64(seed);
+		const unsigned long long high = SplitMix64(seed);
+
+		state[0] = (unsigned int)low;
+		state[1] = (unsigned int)(low >> 32);
+		state[2] = (unsigned int)high;
+		state[3] = (unsigned int)(high >> 32);
+	}
+
+	unsigned int RandomStream::NextBelow(unsigned int bound)
+	{
+		// Lemire's multiply and shift. Only the few draws landing in the uneven slice at the
+		// bottom are redrawn, so the division almost never happens.
+		unsigned long long product = (unsigned long long)Next() * bound;
+		unsigned int low = (unsigned int)product;
+
+		if (low < bound)
+		{
+			const unsigned int threshold = (0u - bound) % bound;
+			while (low < threshold)
+			{
+				product = (unsigned long long)Next() * bound;
+				low = (unsigned int)product;
+			}
+		}
+
+		return (unsigned int)(product >> 32);
+	}
+
+	float RandomStream::NextGaussian()
+	{
+		// The first fraction is taken from 1 down rather than up from 0, so the log never sees 0.
+		const float radius = std::sqrt(-2.0f * std::log(1.0f - NextUnit()));
+		return radius * std::cos(6.2831853f * NextUnit());
+	}
+
+	void RandomStream::Advance(const unsigned int* polynomial)
+	{
+		unsigned int s0 = 0;
+		unsigned int s1 = 0;
+		unsigned int s2 = 0;
+		unsigned int s3 = 0;
+
+		for (int i = 0; i < 4; i++)
+		{
+			for (int b = 0; b < 32; b++)
+			{
+				if (polynomial[i] & (1u << b))
+				{
+					s0 ^= state[0];
+					s1 ^= state[1];
+					s2 ^= state[2];
+					s3 ^= state[3];
+				}
+				Next();
+			}
+		}
+
+		state[0] = s0;
+		state[1] = s1;
+		state[2] = s2;
+		state[3] = s3;
+	}
+
+	void RandomStream::Jump()
+	{
+		Advance(JUMP);
+	}
+
+	void RandomStream::LongJump()
+	{
+		Advance(LONG_JUMP);
+	}
+
+	void RandomStream::Split(RandomStream* out, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			out[i] = *this;
+			Jump();
+		}
+	}
+
+	// Eight xoshiro128** generators, one per lane, seeded from 'source'. A lane's state comes
+	// from 128 fresh bits of 'source'; the odd first word rules out the all zero state.
+	struct FillLanes
+	{
+		unsigned int s0[FILL_LANES];
+		unsigned int s1[FILL_LANES];
+		unsigned int s2[FILL_LANES];
+		unsigned int s3[FILL_LANES];
+
+		explicit FillLanes(RandomStream& source)
+		{
+			for (int j = 0; j < FILL_LANES; j++)
+			{
+				s0[j] = source.Next() | 1u;
+				s1[j] = source.Next();
+				s2[j] = source.Next();
+				s3[j] = source.Next();
+			}
+		}
+
+		// Draws one value per lane into 'out' as 24 bit fractions, 0 to 1.
+		void Draw(float* out)
+		{
+			for (int j = 0; j < FILL_LANES; j++)
+			{
+				const unsigned int scaled = s1[j] * 5;
+				const unsigned int result = ((scaled << 7) | (scaled >> 25)) * 9;
+				const unsigned int shifted = s1[j] << 9;
+
+				s2[j] ^= s0[j];
+				s3[j] ^= s1[j];
+				s1[j] ^= s2[j];
+				s0[j] ^= s3[j];
+				s2[j] ^= shifted;
+				s3[j] = (s3[j] << 11) | (s3[j] >> 21);
+
+				out[j] = (float)(int)(result >> 8) * (1.0f / 16777216.0f);
+			}
+		}
+	};
+
+	void RandomStream::FillUnit(float* out, int count)
+	{
+		FillLanes lanes(*this);
+
+		int i = 0;
+		for (; i + FILL_LANES <= count; i += FILL_LANES)
+		{
+			lanes.Draw(out + i);
+		}
+
+		for (; i < count; i++)
+		{
+			out[i] = NextUnit();
+		}
+	}
+
+	void RandomStream::FillClamped(float* out, int count)
+	{
+		FillLanes lanes(*this);
+		float second[FILL_LANES];
+
+		int i = 0;
+		for (; i + FILL_LANES <= count; i += FILL_LANES)
+		{
+			lanes.Draw(out + i);
+			lanes.Draw(second);
+
+			for (int j = 0; j < FILL_LANES; j++)
+			{
+				out[i + j] -= second[j];
+			}
+		}
+
+		for (; i < count; i++)
+		{
+			out[i] = NextClamped();
+		}
+	}
+
+	void RandomStream::GetState(unsigned int out[4]) const
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			out[i] = state[i];
+		}
+	}
+
+	void RandomStream::SetState(const unsigned int in[4])
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			state[i] = in[i];
+		}
+
+		// The one state xoshiro can't leave.
+		if ((state[0] | state[1] | state[2] | state[3]) == 0)
+		{
+			Seed(0);
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	// Thread streams. A thread's stream is built the first time it asks for one after a seed
+	// change: the seed's stream, LongJump'ed once for every thread that got there first.
+	// ----------------------------------------------------------------------
+	static std::mutex randomSeedLock;
+	static unsigned long long randomSeed = DEFAULT_RANDOM_SEED;
+	static std::atomic<unsigned int> randomSeedEpoch(1);
+	static int nextThreadOrdinal = 0;
+
+	static thread_local RandomStream threadStream;
+	static thread_local unsigned int threadStreamEpoch = 0;
+
+	static void ClaimThreadStream()
+	{
+		std::lock_guard<std::mutex> guard(randomSeedLock);
+
+		const int ordinal = nextThreadOrdinal++;
+		threadStream.Seed(randomSeed);
+		for (int i = 0; i < ordinal; i++)
+		{
+			threadStream.LongJump();
+		}
+		threadStreamEpoch = randomSeedEpoch.load();
+	}
+
+	void SetRandomSeed(unsigned long long seed)
+	{
+		{
+			std::lock_guard<std::mutex> guard(randomSeedLock);
+			randomSeed = seed;
+			nextThreadOrdinal = 0;
+			randomSeedEpoch++;
+		}
+
+		ClaimThreadStream();
+	}
+
+	unsigned long long GetRandomSeed()
+	{
+		std::lock_guard<std::mutex> guard(randomSeedLock);
+		return randomSeed;
+	}
+
+	RandomStream& ThreadRandom()
+	{
+		// Only a seed change takes the lock.
+		if (threadStreamEpoch != randomSeedEpoch.load())
+		{
+			ClaimThreadStream();
+		}
+
+		return threadStream;
+	}
+
+}; // End namespace CarDemo.
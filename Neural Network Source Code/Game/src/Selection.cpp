@@ -0,0 +1,201 @@
+//****************************************************************************
+//**
+//**    Selection.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <algorithm>
+
+#include "Selection.h"
+
+#include "RandomStream.h"
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+	static inline bool Fitter(const float* fitness, int a, int b)
+	{
+		return fitness[a] > fitness[b] || (fitness[a] == fitness[b] && a < b);
+	}
+
+	// Orders a heap with the least fit elite on top, ready to be replaced.
+	struct LessFitFirst
+	{
+		const float* fitness;
+
+		explicit LessFitFirst(const float* fitnessIn)
+			: fitness(fitnessIn)
+		{
+		}
+
+		bool operator()(int a, int b) const
+		{
+			return Fitter(fitness, a, b);
+		}
+	};
+
+	int SelectBest(const float* fitness, int count)
+	{
+		if (count <= 0)
+			return -1;
+
+		int best = 0;
+		for (int i = 1; i < count; i++)
+		{
+			if (fitness[i] > fitness[best])
+			{
+				best = i;
+			}
+		}
+		return best;
+	}
+
+	int SelectWorst(const float* fitness, int count)
+	{
+		if (count <= 0)
+			return -1;
+
+		int worst = 0;
+		for (int i = 1; i < count; i++)
+		{
+			if (fitness[i] < fitness[worst])
+			{
+				worst = i;
+			}
+		}
+		return worst;
+	}
+
+	void SelectElites(const float* fitness, int count, int k, std::vector<int>& out)
+	{
+		out.clear();
+		if (k > count)
+		{
+			k = count;
+		}
+		if (k <= 0)
+			return;
+
+		const LessFitFirst order(fitness);
+
+		for (int i = 0; i < k; i++)
+		{
+			out.push_back(i);
+		}
+		std::make_heap(out.begin(), out.end(), order);
+
+		// Only a genome fitter than the weakest elite so far gets in.
+		for (int i = k; i < count; i++)
+		{
+			if (Fitter(fitness, i, out[0]))
+			{
+				std::pop_heap(out.begin(), out.end(), order);
+				out.back() = i;
+				std::push_heap(out.begin(), out.end(), order);
+			}
+		}
+
+		std::sort_heap(out.begin(), out.end(), order);
+	}
+
+	void SelectTournament(const float* fitness, int count, int size, int picks, RandomStream& random,
+						  std::vector<int>& out)
+	{
+		out.clear();
+		if (count <= 0)
+			return;
+
+		if (size < 1)
+		{
+			size = 1;
+		}
+
+		for (int i = 0; i < picks; i++)
+		{
+			int winner = random.NextBelow(count);
+			for (int j = 1; j < size; j++)
+			{
+				const int challenger = random.NextBelow(count);
+				if (Fitter(fitness, challenger, winner))
+				{
+					winner = challenger;
+				}
+			}
+			out.push_back(winner);
+		}
+	}
+
+	void SelectRanked(const float* fitness, int count, float pressure, int picks, RandomStream& random,
+					  std::vector<int>& out)
+	{
+		out.clear();
+		if (count <= 0)
+			return;
+
+		// Two genomes drawn with replacement, the fitter kept with probability 'pressure' / 2.
+		// The odds of keeping the genome of rank r come out as a straight line in r, with the
+		// fittest expecting 'pressure' picks per genome, the linear ranking distribution.
+		const float keepFitter = std::min(std::max(pressure, 1.0f), 2.0f) * 0.5f;
+
+		for (int i = 0; i < picks; i++)
+		{
+			const int a = random.NextBelow(count);
+			const int b = random.NextBelow(count);
+			const int fitter = Fitter(fitness, a, b) ? a : b;
+			const int other = fitter == a ? b : a;
+			out.push_back(random.NextUnit() < keepFitter ? fitter : other);
+		}
+	}
+
+	void SelectStochasticUniversal(const float* fitness, int count, int picks, RandomStream& random,
+								   std::vector<int>& out)
+	{
+		out.clear();
+		if (count <= 0 || picks <= 0)
+			return;
+
+		// Summed in double so a large population doesn't lose the small fitnesses.
+		double total = 0.0;
+		for (int i = 0; i < count; i++)
+		{
+			total += std::max(fitness[i], 0.0f);
+		}
+
+		if (total <= 0.0)
+		{
+			for (int i = 0; i < picks; i++)
+			{
+				out.push_back(random.NextBelow(count));
+			}
+			return;
+		}
+
+		const double spacing = total / picks;
+		double pointer = random.NextUnit() * spacing;
+		double reached = 0.0;
+		int genome = -1;
+		for (int i = 0; i < picks; i++)
+		{
+			while (reached <= pointer && genome + 1 < count)
+			{
+				genome++;
+				reached += std::max(fitness[genome], 0.0f);
+			}
+			out.push_back(genome);
+			pointer += spacing;
+		}
+
+		// The wheel hands them out in population order.
+		for (int i = picks - 1; i > 0; i--)
+		{
+			std::swap(out[i], out[random.NextBelow(i + 1)]);
+		}
+	}
+
+}; // End namespace CarDemo.
@@ -0,0 +1,315 @@
+//****************************************************************************
+//**
+//**    SensorKernels.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include "SensorKernels.h"
+
+#include <Clarity/Math/Math.h>
+
+#if defined(CARDEMO_X86)
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+	SensorSegments::SensorSegments()
+		: count(0)
+	{
+	}
+
+	void SensorSegments::Pad()
+	{
+		const int padded = GetPaddedCount();
+		std::vector<float>* arrays[] = { &tailX, &tailY, &vectorX, &vectorY, &normalX, &normalY };
+		for (unsigned int i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++)
+		{
+			// A zero normal faces nothing and a zero vector never crosses a ray.
+			arrays[i]->resize(count);
+			arrays[i]->resize(padded, 0.0f);
+		}
+	}
+
+	void SensorSegments::Clear()
+	{
+		count = 0;
+		Pad();
+	}
+
+	void SensorSegments::Set(const std::vector<Clarity::LineSegment2> &sections)
+	{
+		count = (int)sections.size();
+		Pad();
+
+		// Worked out from the end points alone, the way LineSegment2 would, because its vector
+		// and normal are caches filled in on first use and the sections may be shared by
+		// simulations on other threads.
+		for (int i = 0; i < count; i++)
+		{
+			const Clarity::Vector2& tail = sections[i].GetTail();
+			const Clarity::Vector2& head = sections[i].GetHead();
+			const float nx = head.y - tail.y;
+			const float ny = tail.x - head.x;
+			const float invMag = 1.0f / Clarity::Sqrt(nx * nx + ny * ny);
+
+			tailX[i] = tail.x;
+			tailY[i] = tail.y;
+			vectorX[i] = head.x - tail.x;
+			vectorY[i] = head.y - tail.y;
+			normalX[i] = nx * invMag;
+			normalY[i] = ny * invMag;
+		}
+	}
+
+	void SensorSegments::Gather(const SensorSegments& source, const std::vector<int> &indices)
+	{
+		count = (int)indices.size();
+		Pad();
+
+		for (int i = 0; i < count; i++)
+		{
+			const int j = indices[i];
+			tailX[i] = source.tailX[j];
+			tailY[i] = source.tailY[j];
+			vectorX[i] = source.vectorX[j];
+			vectorY[i] = source.vectorY[j];
+			normalX[i] = source.normalX[j];
+			normalY[i] = source.normalY[j];
+		}
+	}
+
+	int SensorSegments::GetCount() const
+	{
+		return count;
+	}
+
+	int SensorSegments::GetPaddedCount() const
+	{
+		return (count + SENSOR_SEGMENT_ALIGNMENT - 1) / SENSOR_SEGMENT_ALIGNMENT * SENSOR_SEGMENT_ALIGNMENT;
+	}
+
+	const float* SensorSegments::GetTailX() const
+	{
+		return tailX.data();
+	}
+
+	const float* SensorSegments::GetTailY() const
+	{
+		return tailY.data();
+	}
+
+	const float* SensorSegments::GetVectorX() const
+	{
+		return vectorX.data();
+	}
+
+	const float* SensorSegments::GetVectorY() const
+	{
+		return vectorY.data();
+	}
+
+	const float* SensorSegments::GetNormalX() const
+	{
+		return normalX.data();
+	}
+
+	const float* SensorSegments::GetNormalY() const
+	{
+		return normalY.data();
+	}
+
+	void CastRaysScalar(const SensorSegments& segments, const float* originX, const float* originY,
+						const float* directionX, const float* directionY, int rays, float maxDistance, float* depths)
+	{
+		const int count = segments.GetPaddedCount();
+		const float* tx = segments.GetTailX();
+		const float* ty = segments.GetTailY();
+		const float* vx = segments.GetVectorX();
+		const float* vy = segments.GetVectorY();
+		const float* nx = segments.GetNormalX();
+		const float* ny = segments.GetNormalY();
+
+		for (int r = 0; r < rays; r++)
+		{
+			const float px = originX[r];
+			const float py = originY[r];
+			const float dx = directionX[r];
+			const float dy = directionY[r];
+			float best = maxDistance;
+
+			for (int j = 0; j < count; j++)
+			{
+				// Walls are only seen from the front, which also means the denominator is negative.
+				const float denominator = vy[j] * dx - vx[j] * dy;
+				if (dx * nx[j] + dy * ny[j] >= 0.0f || denominator >= 0.0f)
+					continue;
+
+				// The ray crosses the segment at s = sNumerator / denominator along the ray and
+				// t = tNumerator / denominator along the segment. With the sign of the denominator
+				// known, 0 <= t <= 1 and s >= 0 can be tested without dividing, only hits pay for it.
+				const float ox = tx[j] - px;
+				const float oy = ty[j] - py;
+				const float sNumerator = vy[j] * ox - vx[j] * oy;
+				const float tNumerator = dy * ox - dx * oy;
+				if (sNumerator > 0.0f || tNumerator > 0.0f || tNumerator < denominator)
+					continue;
+
+				const float s = sNumerator / denominator;
+				if (s < best)
+				{
+					best = s;
+				}
+			}
+			depths[r] = best;
+		}
+	}
+
+#if defined(CARDEMO_X86)
+
+	KERNEL_TARGET_SSE2
+	void CastRaysSSE2(const SensorSegments& segments, const float* originX, const float* originY,
+					  const float* directionX, const float* directionY, int rays, float maxDistance, float* depths)
+	{
+		const int count = segments.GetPaddedCount();
+		const float* tx = segments.GetTailX();
+		const float* ty = segments.GetTailY();
+		const float* vx = segments.GetVectorX();
+		const float* vy = segments.GetVectorY();
+		const float* nx = segments.GetNormalX();
+		const float* ny = segments.GetNormalY();
+
+		const __m128 zero = _mm_setzero_ps();
+
+		for (int r = 0; r < rays; r++)
+		{
+			const __m128 px = _mm_set1_ps(originX[r]);
+			const __m128 py = _mm_set1_ps(originY[r]);
+			const __m128 dx = _mm_set1_ps(directionX[r]);
+			const __m128 dy = _mm_set1_ps(directionY[r]);
+			__m128 best = _mm_set1_ps(maxDistance);
+
+			for (int j = 0; j < count; j += 4)
+			{
+				const __m128 facing = _mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(nx + j)), _mm_mul_ps(dy, _mm_loadu_ps(ny + j)));
+				const __m128 sx = _mm_loadu_ps(vx + j);
+				const __m128 sy = _mm_loadu_ps(vy + j);
+				const __m128 denominator = _mm_sub_ps(_mm_mul_ps(sy, dx), _mm_mul_ps(sx, dy));
+				const __m128 ox = _mm_sub_ps(_mm_loadu_ps(tx + j), px);
+				const __m128 oy = _mm_sub_ps(_mm_loadu_ps(ty + j), py);
+				const __m128 sNumerator = _mm_sub_ps(_mm_mul_ps(sy, ox), _mm_mul_ps(sx, oy));
+				const __m128 tNumerator = _mm_sub_ps(_mm_mul_ps(dy, ox), _mm_mul_ps(dx, oy));
+
+				// Same tests as the scalar kernel. Padding has a zero normal and drops out here.
+				__m128 hit = _mm_and_ps(_mm_cmplt_ps(facing, zero), _mm_cmplt_ps(denominator, zero));
+				hit = _mm_and_ps(hit, _mm_cmple_ps(sNumerator, zero));
+				hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmple_ps(tNumerator, zero), _mm_cmpge_ps(tNumerator, denominator)));
+				if (_mm_movemask_ps(hit) == 0)
+					continue;
+
+				const __m128 s = _mm_div_ps(sNumerator, denominator);
+				hit = _mm_and_ps(hit, _mm_cmplt_ps(s, best));
+				best = _mm_or_ps(_mm_and_ps(hit, s), _mm_andnot_ps(hit, best));
+			}
+
+			best = _mm_min_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(1, 0, 3, 2)));
+			best = _mm_min_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(2, 3, 0, 1)));
+			depths[r] = _mm_cvtss_f32(best);
+		}
+	}
+
+	KERNEL_TARGET_AVX2
+	void CastRaysAVX2(const SensorSegments& segments, const float* originX, const float* originY,
+					  const float* directionX, const float* directionY, int rays, float maxDistance, float* depths)
+	{
+		const int count = segments.GetPaddedCount();
+		const float* tx = segments.GetTailX();
+		const float* ty = segments.GetTailY();
+		const float* vx = segments.GetVectorX();
+		const float* vy = segments.GetVectorY();
+		const float* nx = segments.GetNormalX();
+		const float* ny = segments.GetNormalY();
+
+		const __m256 zero = _mm256_setzero_ps();
+
+		for (int r = 0; r < rays; r++)
+		{
+			const __m256 px = _mm256_set1_ps(originX[r]);
+			const __m256 py = _mm256_set1_ps(originY[r]);
+			const __m256 dx = _mm256_set1_ps(directionX[r]);
+			const __m256 dy = _mm256_set1_ps(directionY[r]);
+			__m256 best = _mm256_set1_ps(maxDistance);
+
+			for (int j = 0; j < count; j += 8)
+			{
+				const __m256 facing = _mm256_add_ps(_mm256_mul_ps(dx, _mm256_loadu_ps(nx + j)), _mm256_mul_ps(dy, _mm256_loadu_ps(ny + j)));
+				const __m256 sx = _mm256_loadu_ps(vx + j);
+				const __m256 sy = _mm256_loadu_ps(vy + j);
+				const __m256 denominator = _mm256_sub_ps(_mm256_mul_ps(sy, dx), _mm256_mul_ps(sx, dy));
+				const __m256 ox = _mm256_sub_ps(_mm256_loadu_ps(tx + j), px);
+				const __m256 oy = _mm256_sub_ps(_mm256_loadu_ps(ty + j), py);
+				const __m256 sNumerator = _mm256_sub_ps(_mm256_mul_ps(sy, ox), _mm256_mul_ps(sx, oy));
+				const __m256 tNumerator = _mm256_sub_ps(_mm256_mul_ps(dy, ox), _mm256_mul_ps(dx, oy));
+
+				__m256 hit = _mm256_and_ps(_mm256_cmp_ps(facing, zero, _CMP_LT_OQ), _mm256_cmp_ps(denominator, zero, _CMP_LT_OQ));
+				hit = _mm256_and_ps(hit, _mm256_cmp_ps(sNumerator, zero, _CMP_LE_OQ));
+				hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(tNumerator, zero, _CMP_LE_OQ), _mm256_cmp_ps(tNumerator, denominator, _CMP_GE_OQ)));
+				if (_mm256_movemask_ps(hit) == 0)
+					continue;
+
+				const __m256 s = _mm256_div_ps(sNumerator, denominator);
+				hit = _mm256_and_ps(hit, _mm256_cmp_ps(s, best, _CMP_LT_OQ));
+				best = _mm256_blendv_ps(best, s, hit);
+			}
+
+			__m128 half = _mm_min_ps(_mm256_castps256_ps128(best), _mm256_extractf128_ps(best, 1));
+			half = _mm_min_ps(half, _mm_shuffle_ps(half, half, _MM_SHUFFLE(1, 0, 3, 2)));
+			half = _mm_min_ps(half, _mm_shuffle_ps(half, half, _MM_SHUFFLE(2, 3, 0, 1)));
+			depths[r] = _mm_cvtss_f32(half);
+		}
+	}
+
+#else
+
+	// Not an x86 build, everything runs through the reference kernel.
+	void CastRaysSSE2(const SensorSegments& segments, const float* originX, const float* originY,
+					  const float* directionX, const float* directionY, int rays, float maxDistance, float* depths)
+	{
+		CastRaysScalar(segments, originX, originY, directionX, directionY, rays, maxDistance, depths);
+	}
+
+	void CastRaysAVX2(const SensorSegments& segments, const float* originX, const float* originY,
+					  const float* directionX, const float* directionY, int rays, float maxDistance, float* depths)
+	{
+		CastRaysScalar(segments, originX, originY, directionX, directionY, rays, maxDistance, depths);
+	}
+
+#endif // #if defined(CARDEMO_X86)
+
+	RayCastKernel GetRayCastKernel(KernelLevel level)
+	{
+		switch (level)
+		{
+		case KERNEL_AVX2:
+			return CastRaysAVX2;
+		case KERNEL_SSE2:
+			return CastRaysSSE2;
+		default:
+			return CastRaysScalar;
+		};
+	}
+
+	RayCastKernel GetRayCastKernel()
+	{
+		return GetRayCastKernel(GetKernelLevel());
+	}
+
+}; // End namespace CarDemo.
@@ -0,0 +1,196 @@
+//****************************************************************************
+//**
+//**    Simulation.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include "Simulation.h"
+
+#include "DistanceField.h"
+#include "TrackGeometry.h"
+#include "TagFileReader.h"
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+	bool LoadCheckpoints(const char* filename, std::vector<Checkpoint> &out)
+	{
+		TagFileReader reader;
+		if (!reader.Open(filename))
+			return false;
+
+		out.clear();
+
+		Clarity::Vector2 start;
+		Clarity::Vector2 end;
+		int totalCheckpoints = 0;
+
+		while (reader.NextLine())
+		{
+			if (reader.IsLine("</Declaration>"))
+			{
+				break;
+			}
+			else if (reader.IsLine("-Build-"))
+			{
+				out.reserve(totalCheckpoints);
+			}
+			else if (reader.IsLine("<Checkpoint>"))
+			{
+				start.Set(0.0f, 0.0f);
+				end.Set(0.0f, 0.0f);
+			}
+			else if (reader.IsLine("</Checkpoint>"))
+			{
+				out.push_back(Checkpoint(end, start));
+			}
+			else if (reader.IsKey("sX"))
+			{
+				start.x = reader.GetFloat();
+			}
+			else if (reader.IsKey("sY"))
+			{
+				start.y = reader.GetFloat();
+			}
+			else if (reader.IsKey("eX"))
+			{
+				end.x = reader.GetFloat();
+			}
+			else if (reader.IsKey("eY"))
+			{
+				end.y = reader.GetFloat();
+			}
+			else if (reader.IsKey("TotalCheckpoints"))
+			{
+				totalCheckpoints = reader.GetInt();
+			}
+		}
+		return true;
+	}
+
+	Simulation::Simulation(const TrackGeometry& trackIn, const std::vector<Checkpoint>& checkpointsIn, int maxStepsIn)
+		: track(&trackIn)
+		, checkpoints(&checkpointsIn)
+		, fitness(0.0f)
+		, steps(0)
+		, maxSteps(maxStepsIn)
+		, finished(true)
+	{
+	}
+
+	void Simulation::Reset(NeuralNet* net)
+	{
+		agent.SetRotation(DEFAULT_ROTATION);
+		agent.SetPosition(DEFAULT_POSITION);
+		agent.Attach(net);
+		agent.ClearFailure();
+
+		checkpointFlags.assign(checkpoints->size(), Checkpoint_Active);
+		checkpointSegments.Set(*checkpoints);
+		fitness = 0.0f;
+		steps = 0;
+		finished = net == NULL;
+	}
+
+	bool Simulation::Step()
+	{
+		if (finished)
+			return false;
+
+		bool crashed = false;
+		const DistanceField* field = track->GetDistanceField();
+		if (field != NULL)
+		{
+			agent.UpdateSensors(*field);
+			crashed = agent.CheckForCollision(*field);
+		}
+		else
+		{
+			// Sense and collide against the walls near the agent only. A wall a feeler or the body
+			// can reach is inside the sensor bounds, so the grid's candidates are enough for both.
+			track->QueryCandidates(agent.GetSensorBounds(), candidates);
+			nearbySegments.Gather(track->GetSensorSegments(), candidates);
+			agent.UpdateSensors(nearbySegments);
+			crashed = agent.CheckForCollision(nearbySegments);
+		}
+
+		if (crashed)
+		{
+			finished = true;
+			return false;
+		}
+
+		agent.Update(SIMULATION_TIME_STEP);
+		fitness += agent.GetDistanceDelta() / 2.0f;
+		ScoreCheckpoints();
+
+		steps++;
+		if (maxSteps > 0 && steps >= maxSteps)
+		{
+			finished = true;
+		}
+		return !finished;
+	}
+
+	float Simulation::Run()
+	{
+		while (Step())
+		{
+		}
+		return fitness;
+	}
+
+	void Simulation::ScoreCheckpoints()
+	{
+		// Test the agent against the active checkpoints.
+		for (unsigned int i = 0; i < checkpoints->size(); i++)
+		{
+			// See if the checkpoint has already been hit.
+			if (checkpointFlags[i] == Checkpoint_Inactive)
+				continue;
+
+			if (agent.CrossesSegment(checkpointSegments, i))
+			{
+				fitness += CHECK_POINT_BONUS;
+				checkpointFlags[i] = Checkpoint_Inactive;
+			}
+		}
+	}
+
+	bool Simulation::IsFinished() const
+	{
+		return finished;
+	}
+
+	float Simulation::GetFitness() const
+	{
+		return fitness;
+	}
+
+	int Simulation::GetSteps() const
+	{
+		return steps;
+	}
+
+	Agent& Simulation::GetAgent()
+	{
+		return agent;
+	}
+
+	const Agent& Simulation::GetAgent() const
+	{
+		return agent;
+	}
+
+	const std::vector<CheckpointFlag>& Simulation::GetCheckpointFlags() const
+	{
+		return checkpointFlags;
+	}
+
+}; // End namespace CarDemo.
\ No newline at end of file
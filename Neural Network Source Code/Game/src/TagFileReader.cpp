@@ -0,0 +1,222 @@
+//****************************************************************************
+//**
+//**    TagFileReader.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <string.h>
+#include <stdlib.h>
+#include <charconv>
+
+#include "TagFileReader.h"
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+	TagFileReader::TagFileReader()
+		: file(NULL)
+		, buffer(NULL)
+		, capacity(0)
+		, start(0)
+		, end(0)
+		, endOfFile(true)
+		, line("")
+		, lineLength(0)
+		, value(NULL)
+		, keyLength(0)
+	{
+	}
+
+	TagFileReader::~TagFileReader()
+	{
+		Close();
+		delete [] buffer;
+	}
+
+	bool TagFileReader::Open(const char* filename)
+	{
+		Close();
+
+		file = fopen(filename, "rb");
+		if (file == NULL)
+			return false;
+
+		if (buffer == NULL)
+		{
+			// One spare byte so the last line can always be terminated in place.
+			capacity = BLOCK_SIZE;
+			buffer = new char[capacity + 1];
+		}
+		start = 0;
+		end = 0;
+		endOfFile = false;
+		return true;
+	}
+
+	void TagFileReader::Close()
+	{
+		if (file != NULL)
+		{
+			fclose(file);
+			file = NULL;
+		}
+		start = 0;
+		end = 0;
+		endOfFile = true;
+		line = "";
+		lineLength = 0;
+		value = NULL;
+		keyLength = 0;
+	}
+
+	bool TagFileReader::Refill()
+	{
+		if (endOfFile || file == NULL)
+			return false;
+
+		// Keep the unfinished line, moving it to the front of the buffer.
+		const int remaining = end - start;
+		if (start > 0)
+		{
+			memmove(buffer, buffer + start, remaining);
+			start = 0;
+			end = remaining;
+		}
+
+		// A single line longer than the whole buffer, so make room for it.
+		if (end == capacity)
+		{
+			char* bigger = new char[capacity * 2 + 1];
+			memcpy(bigger, buffer, end);
+			delete [] buffer;
+			buffer = bigger;
+			capacity *= 2;
+		}
+
+		const int read = (int)fread(buffer + end, 1, capacity - end, file);
+		end += read;
+		if (read == 0)
+		{
+			endOfFile = true;
+			return false;
+		}
+		return true;
+	}
+
+	bool TagFileReader::NextLine()
+	{
+		for (;;)
+		{
+			char* lineStart = buffer + start;
+			char* lineEnd = (char*)memchr(lineStart, '\n', end - start);
+
+			if (lineEnd == NULL)
+			{
+				if (Refill())
+					continue;
+
+				// The last line of a file without a final newline.
+				if (start == end)
+				{
+					line = "";
+					lineLength = 0;
+					value = NULL;
+					keyLength = 0;
+					return false;
+				}
+				lineStart = buffer + start;
+				lineEnd = buffer + end;
+			}
+
+			start = (int)(lineEnd - buffer) + (lineEnd < buffer + end ? 1 : 0);
+
+			// Terminate in place, dropping the '\r' of files saved on Windows.
+			*lineEnd = '\0';
+			if (lineEnd > lineStart && lineEnd[-1] == '\r')
+			{
+				lineEnd--;
+				*lineEnd = '\0';
+			}
+
+			if (lineEnd == lineStart)
+				continue;
+
+			line = lineStart;
+			lineLength = (int)(lineEnd - lineStart);
+
+			const char* equals = (const char*)memchr(line, '=', lineLength);
+			value = equals != NULL ? equals + 1 : NULL;
+			keyLength = equals != NULL ? (int)(equals - line) : 0;
+			return true;
+		}
+	}
+
+	bool TagFileReader::IsLine(const char* text) const
+	{
+		return strcmp(line, text) == 0;
+	}
+
+	bool TagFileReader::IsKey(const char* key) const
+	{
+		return value != NULL && strncmp(line, key, keyLength) == 0 && key[keyLength] == '\0';
+	}
+
+	const char* TagFileReader::GetLine() const
+	{
+		return line;
+	}
+
+	const char* TagFileReader::GetValue() const
+	{
+		return value != NULL ? value : "";
+	}
+
+	bool TagFileReader::ValueIs(const char* text) const
+	{
+		return strcmp(GetValue(), text) == 0;
+	}
+
+	float TagFileReader::GetFloat(float fallback) const
+	{
+		if (value == NULL)
+			return fallback;
+
+		const char* first = value;
+		const char* last = line + lineLength;
+		// from_chars doesn't take a leading '+', which the old atof based loaders did.
+		if (first < last && *first == '+')
+		{
+			first++;
+		}
+
+		float result = fallback;
+		if (std::from_chars(first, last, result).ec != std::errc())
+			return fallback;
+		return result;
+	}
+
+	int TagFileReader::GetInt(int fallback) const
+	{
+		if (value == NULL)
+			return fallback;
+
+		const char* first = value;
+		const char* last = line + lineLength;
+		if (first < last && *first == '+')
+		{
+			first++;
+		}
+
+		int result = fallback;
+		if (std::from_chars(first, last, result).ec != std::errc())
+			return fallback;
+		return result;
+	}
+
+}; // End namespace CarDemo.
\ No newline at end of file
@@ -0,0 +1,307 @@
+//****************************************************************************
+//**
+//**    TrackGeometry.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <algorithm>
+#include <cmath>
+
+#include <Clarity/Math/Circle.h>
+#include <Clarity/Math/Ray2.h>
+#include <Clarity/Math/Math.h>
+
+#include "TrackGeometry.h"
+#include "TagFileReader.h"
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+	// Which of 'cells' cells of size 'cellSize' the offset falls in, clamped to the grid.
+	static int ToCell(float offset, float cellSize, int cells)
+	{
+		int cell = (int)std::floor(offset / cellSize);
+		if (cell < 0)
+			return 0;
+		if (cell >= cells)
+			return cells - 1;
+		return cell;
+	}
+
+	TrackGeometry::TrackGeometry()
+		: gridOrigin(Clarity::Vector2::ZERO)
+		, gridCellSize(1.0f)
+		, gridColumns(0)
+		, gridRows(0)
+		, distanceField(NULL)
+	{
+	}
+
+	bool TrackGeometry::Load(const char* filename)
+	{
+		TagFileReader reader;
+		if (!reader.Open(filename))
+			return false;
+
+		Clear();
+
+		std::vector<Clarity::LineSegment2>* sections = NULL;
+		Clarity::Vector2 start;
+		Clarity::Vector2 end;
+
+		while (reader.NextLine())
+		{
+			if (reader.IsLine("<PolyInner>"))
+			{
+				sections = &inner;
+			}
+			else if (reader.IsLine("<PolyOuter>"))
+			{
+				sections = &outer;
+			}
+			else if (reader.IsLine("<Segment>"))
+			{
+				start.Set(0.0f, 0.0f);
+				end.Set(0.0f, 0.0f);
+			}
+			else if (reader.IsLine("</Segment>"))
+			{
+				if (sections != NULL)
+				{
+					sections->push_back(Clarity::LineSegment2(end, start));
+				}
+			}
+			else if (reader.IsKey("sX"))
+			{
+				start.x = reader.GetFloat();
+			}
+			else if (reader.IsKey("sY"))
+			{
+				start.y = reader.GetFloat();
+			}
+			else if (reader.IsKey("eX"))
+			{
+				end.x = reader.GetFloat();
+			}
+			else if (reader.IsKey("eY"))
+			{
+				end.y = reader.GetFloat();
+			}
+		}
+
+		BuildGrid();
+		return true;
+	}
+
+	void TrackGeometry::Clear()
+	{
+		inner.clear();
+		outer.clear();
+		BuildGrid();
+	}
+
+	void TrackGeometry::SetSections(const std::vector<Clarity::LineSegment2> &innerIn, const std::vector<Clarity::LineSegment2> &outerIn)
+	{
+		inner = innerIn;
+		outer = outerIn;
+		BuildGrid();
+	}
+
+	const std::vector<Clarity::LineSegment2>& TrackGeometry::GetInnerSections() const
+	{
+		return inner;
+	}
+
+	const std::vector<Clarity::LineSegment2>& TrackGeometry::GetOuterSections() const
+	{
+		return outer;
+	}
+
+	int TrackGeometry::GetTotalSections() const
+	{
+		return (int)(inner.size() + outer.size());
+	}
+
+	const Clarity::LineSegment2& TrackGeometry::GetSection(int index) const
+	{
+		if (index < (int)inner.size())
+			return inner[index];
+		return outer[index - inner.size()];
+	}
+
+	const SensorSegments& TrackGeometry::GetSensorSegments() const
+	{
+		return sensorSegments;
+	}
+
+	void TrackGeometry::SetDistanceField(const DistanceField* field)
+	{
+		distanceField = field;
+	}
+
+	const DistanceField* TrackGeometry::GetDistanceField() const
+	{
+		return distanceField;
+	}
+
+	void TrackGeometry::BuildGrid()
+	{
+		gridCellStart.clear();
+		gridSegments.clear();
+		gridColumns = 0;
+		gridRows = 0;
+
+		// Built from the old walls.
+		distanceField = NULL;
+
+		std::vector<Clarity::LineSegment2> sections(inner);
+		sections.insert(sections.end(), outer.begin(), outer.end());
+		sensorSegments.Set(sections);
+
+		const int totalSections = GetTotalSections();
+		if (totalSections == 0)
+			return;
+
+		Clarity::Vector2 minimum = GetSection(0).GetTail();
+		Clarity::Vector2 maximum = minimum;
+		float totalLength = 0.0f;
+		for (int i = 0; i < totalSections; i++)
+		{
+			const Clarity::LineSegment2& section = GetSection(i);
+			minimum.x = std::min(minimum.x, std::min(section.GetTail().x, section.GetHead().x));
+			minimum.y = std::min(minimum.y, std::min(section.GetTail().y, section.GetHead().y));
+			maximum.x = std::max(maximum.x, std::max(section.GetTail().x, section.GetHead().x));
+			maximum.y = std::max(maximum.y, std::max(section.GetTail().y, section.GetHead().y));
+			totalLength += section.GetLength();
+		}
+
+		// Cells about as long as a segment, so each segment lands in a handful of cells, but no
+		// more cells than segments on tracks made of a few long walls.
+		const float width = maximum.x - minimum.x;
+		const float height = maximum.y - minimum.y;
+		gridCellSize = std::max(totalLength / totalSections, std::sqrt(width * height / totalSections));
+		if (gridCellSize <= 0.0f)
+		{
+			gridCellSize = 1.0f;
+		}
+
+		gridOrigin = minimum;
+		gridColumns = (int)(width / gridCellSize) + 1;
+		gridRows = (int)(height / gridCellSize) + 1;
+
+		// Count the segments per cell, turn the counts into offsets, then fill.
+		gridCellStart.assign(gridColumns * gridRows + 1, 0);
+		for (int pass = 0; pass < 2; pass++)
+		{
+			std::vector<int> cursor;
+			if (pass == 1)
+			{
+				for (unsigned int c = 1; c < gridCellStart.size(); c++)
+				{
+					gridCellStart[c] += gridCellStart[c - 1];
+				}
+				gridSegments.resize(gridCellStart.back());
+				cursor.assign(gridCellStart.begin(), gridCellStart.end() - 1);
+			}
+
+			for (int i = 0; i < totalSections; i++)
+			{
+				const Clarity::LineSegment2& section = GetSection(i);
+				const int x0 = ToCell(std::min(section.GetTail().x, section.GetHead().x) - gridOrigin.x, gridCellSize, gridColumns);
+				const int x1 = ToCell(std::max(section.GetTail().x, section.GetHead().x) - gridOrigin.x, gridCellSize, gridColumns);
+				const int y0 = ToCell(std::min(section.GetTail().y, section.GetHead().y) - gridOrigin.y, gridCellSize, gridRows);
+				const int y1 = ToCell(std::max(section.GetTail().y, section.GetHead().y) - gridOrigin.y, gridCellSize, gridRows);
+
+				for (int y = y0; y <= y1; y++)
+				{
+					for (int x = x0; x <= x1; x++)
+					{
+						const int cell = y * gridColumns + x;
+						if (pass == 0)
+						{
+							gridCellStart[cell + 1]++;
+						}
+						else
+						{
+							gridSegments[cursor[cell]++] = i;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void TrackGeometry::QueryCandidates(const Clarity::Circle& circle, std::vector<int> &out) const
+	{
+		out.clear();
+		if (gridCellStart.empty())
+			return;
+
+		const Clarity::Vector2 centre = circle.GetCentre() - gridOrigin;
+		const float radius = circle.GetRadius();
+		const int x0 = ToCell(centre.x - radius, gridCellSize, gridColumns);
+		const int x1 = ToCell(centre.x + radius, gridCellSize, gridColumns);
+		const int y0 = ToCell(centre.y - radius, gridCellSize, gridRows);
+		const int y1 = ToCell(centre.y + radius, gridCellSize, gridRows);
+
+		for (int y = y0; y <= y1; y++)
+		{
+			for (int x = x0; x <= x1; x++)
+			{
+				const int cell = y * gridColumns + x;
+				out.insert(out.end(), gridSegments.begin() + gridCellStart[cell], gridSegments.begin() + gridCellStart[cell + 1]);
+			}
+		}
+
+		// Cells are filled in index order, so only segments spanning cells need weeding out.
+		if (x1 > x0 || y1 > y0)
+		{
+			std::sort(out.begin(), out.end());
+			out.erase(std::unique(out.begin(), out.end()), out.end());
+		}
+	}
+
+	void TrackGeometry::QueryPossibleCollisions(const Clarity::Circle& circle, std::vector<Clarity::LineSegment2> &out,
+												std::vector<int>* innerHits, std::vector<int>* outerHits,
+												std::vector<int>* candidates) const
+	{
+		std::vector<int> localCandidates;
+		std::vector<int>& indices = candidates != NULL ? *candidates : localCandidates;
+		QueryCandidates(circle, indices);
+
+		// A segment touches the circle if the rays cast along it from both ends hit it.
+		Clarity::Ray2 ray(Clarity::Vector2::ZERO, Clarity::Vector2::UNIT_X);
+		Clarity::Ray2 ray2(Clarity::Vector2::ZERO, Clarity::Vector2::UNIT_X);
+		float distance = 0; // Unused, needed so that the function will work.
+
+		const int innerCount = (int)inner.size();
+		for (unsigned int i = 0; i < indices.size(); i++)
+		{
+			const Clarity::LineSegment2& section = GetSection(indices[i]);
+			ray.Set(section.GetTail(), section.GetDirection());
+			ray2.Set(section.GetHead(), section.GetDirection() * -1);
+			if (Clarity::Intersects(circle, ray, &distance) && Clarity::Intersects(circle, ray2, &distance))
+			{
+				out.push_back(section);
+				if (indices[i] < innerCount)
+				{
+					if (innerHits != NULL)
+					{
+						innerHits->push_back(indices[i]);
+					}
+				}
+				else if (outerHits != NULL)
+				{
+					outerHits->push_back(indices[i] - innerCount);
+				}
+			}
+		}
+	}
+
+}; // End namespace CarDemo.
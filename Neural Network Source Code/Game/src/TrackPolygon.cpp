@@ -18,6 +18,7 @@
 
 #include "TrackPolygon.h"
 #include "GameGlobals.h"
+#include "GF1Conversions.h"
 
 #include <GF1_Sprite.h>
 #include <GF1_Colour.h>
@@ -37,12 +38,6 @@ using std::endl;
 
 namespace CarDemo 
 {		
-	enum PolygonReadMode
-	{
-		PolyInner,
-		PolyOuter,
-		PolyInvalid,
-	};
 
 	const int INVALID_POLY_SECTION = -1;
 
@@ -76,112 +71,55 @@ namespace CarDemo
 	
 	void TrackPolygon::LoadPolygon(char* filename)
 	{
-		FILE* file = fopen(filename,"rt");
-		int tempID = 0;
-
-		if(file!=NULL)
-		{
-			PolygonReadMode mode = PolyInvalid;
+		if (!geometry.Load(filename))
+			return;
 
-			Clarity::Vector2 normal;
-			Clarity::Vector2 start;
-			Clarity::Vector2 end;
+		polygonInner.clear();
+		polygonOuter.clear();
 
-			char buffer[1024] ={0};
+		const std::vector<Clarity::LineSegment2>& inner = geometry.GetInnerSections();
+		for (unsigned int i = 0; i < inner.size(); i++)
+		{
+			PolySection ps;
+			ps.section = inner[i];
+			polygonInner.push_back(ps);
+		}
 
-			while(fgets(buffer,1024,file))
-			{
-				char buff[1024] = {0};
+		const std::vector<Clarity::LineSegment2>& outer = geometry.GetOuterSections();
+		for (unsigned int i = 0; i < outer.size(); i++)
+		{
+			PolySection ps;
+			ps.section = outer[i];
+			polygonOuter.push_back(ps);
+		}
+	}
 
-				if(buffer[strlen(buffer)-1] == '\n')
-				{
-					for(unsigned int i = 0; i<strlen(buffer)-1;i++)
-					{
-						buff[i] = buffer[i];
-					}
-				}
+	void TrackPolygon::RebuildGeometry()
+	{
+		std::vector<Clarity::LineSegment2> inner;
+		std::vector<Clarity::LineSegment2> outer;
+		GetPolySections(inner, outer);
+		geometry.SetSections(inner, outer);
+	}
 
-				if(0 == strcmp(buff, "<PolyInner>"))
-				{
-					// Set mode to inner polygon loading.
-					mode = PolyInner;
-				}
-				else if (0 == strcmp(buff,"</PolyInner>"))
-				{
-					// Do nothing, just there for structure.
-				}
-				else if (0 == strcmp(buff,"<PolyOuter>"))
-				{
-					// Set mode to outer polygon loading.
-					mode = PolyOuter;
-				}
-				else if (0 == strcmp(buff,"</PolyOuter>"))
-				{
-					// Do nothing, just there for structure.
-				}
-				else if (0 == strcmp(buff,"<Segment>"))
-				{
-					// Clear segment data.
-					start.Set(0.0f, 0.0f);
-					end.Set(0.0f, 0.0f);
-					normal.Set(0.0f, 0.0f);
-				}
-				else if (0 == strcmp(buff,"</Segment>"))
-				{
-					// Create segment data
-					PolySection ps;
-					ps.section.Set(end, start);
-					switch (mode)
-					{
-					case PolyInner:
-						polygonInner.push_back(ps);
-						break;
-					case PolyOuter:
-						polygonOuter.push_back(ps);
-						break;
-					};
-				}
-			
-				else
-				{
-					char* token = strtok(buff, "=");
+	void TrackPolygon::GetPolySections(std::vector<Clarity::LineSegment2> &polyInner, std::vector<Clarity::LineSegment2> &polyOuter)
+	{
+		for (unsigned int i = 0; i < polygonInner.size(); i++)
+		{
+			polyInner.push_back(polygonInner[i].section);
+		}
 
-					if (token != NULL)
-					{
-						char* value = strtok(NULL,"=");
-
-
-						if (0 == strcmp(token,"sX"))
-						{
-							start.x = (float)atof(value);
-						}
-						else if (0 == strcmp(token,"sY"))
-						{
-							start.y = (float)atof(value);
-						}
-						else if (0 == strcmp(token,"eX"))
-						{
-							end.x = (float)atof(value);
-						}
-						else if (0 == strcmp(token,"eY"))
-						{
-							end.y = (float)atof(value);
-						}
-						else if (0 == strcmp(token,"nX"))
-						{
-							normal.x = (float)atof(value);
-						}
-						else if (0 == strcmp(token,"nY"))
-						{
-							normal.y = (float)atof(value);
-						}
-					}
-				}
-			}
-			fclose(file);
+		for (unsigned int i = 0; i < polygonOuter.size(); i++)
+		{
+			polyOuter.push_back(polygonOuter[i].section);
 		}
 	}
 
+	const TrackGeometry& TrackPolygon::GetGeometry() const
+	{
+		return geometry;
+	}
+
 	void TrackPolygon::ExportPolygon(char* filename)
 	{
 		std::ofstream file;
@@ -500,6 +438,8 @@ namespace CarDemo
 		default:
 			break;
 		};
+
+		RebuildGeometry();
 	}
 
 	
@@ -557,37 +497,7 @@ namespace CarDemo
 
 	void TrackPolygon::QueryPossibleCollisions(const Clarity::Circle& circle, std::vector<Clarity::LineSegment2> &out)
 	{
-		// Ray to test intersections against the circle.
-		Clarity::Ray2 ray(Clarity::Vector2::ZERO, Clarity::Vector2::UNIT_X);
-		Clarity::Ray2 ray2(Clarity::Vector2::ZERO, Clarity::Vector2::UNIT_X);
-		float distance = 0; // Unused, needed so that the function will work.
-
-		// Test inner polygon sections to the circle.
-		for (unsigned int i = 0; i < polygonInner.size(); i++)
-		{
-			ray.Set(polygonInner[i].section.GetTail(), polygonInner[i].section.GetDirection());
-			ray2.Set(polygonInner[i].section.GetHead(), polygonInner[i].section.GetDirection() * -1);
-			if (Clarity::Intersects(circle, ray, &distance) && Clarity::Intersects(circle, ray2, &distance))
-			{
-				out.push_back(polygonInner[i].section);
-				intersectingInner.push_back(i);
-				continue;
-			}
-
-		}
-
-		// Test outer polygon sections to the circle.
-		for (unsigned int i = 0; i < polygonOuter.size(); i++)
-		{
-			ray.Set(polygonOuter[i].section.GetTail(), polygonOuter[i].section.GetDirection());
-			ray2.Set(polygonOuter[i].section.GetHead(), polygonOuter[i].section.GetDirection() * -1);
-			if (Clarity::Intersects(circle, ray, &distance) && Clarity::Intersects(circle, ray2, &distance))
-			{
-				out.push_back(polygonOuter[i].section);
-				intersectingOuter.push_back(i);
-				continue;
-			}
-		}
+		geometry.QueryPossibleCollisions(circle, out, &intersectingInner, &intersectingOuter);
 	}
 	
 }; // End namespace CarDemo.
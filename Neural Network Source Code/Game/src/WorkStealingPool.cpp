@@ -0,0 +1,180 @@
+//****************************************************************************
+//**
+//**    WorkStealingPool.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include "WorkStealingPool.h"
+
+#include "MemoryLeak.h"
+
+namespace CarDemo
+{
+	WorkStealingPool::WorkStealingPool(int threadCount)
+		: function(NULL)
+		, generation(0)
+		, quitting(false)
+		, remaining(0)
+	{
+		if (threadCount <= 0)
+		{
+			threadCount = (int)std::thread::hardware_concurrency();
+			if (threadCount <= 0)
+			{
+				threadCount = 1;
+			}
+		}
+
+		for (int i = 0; i < threadCount; i++)
+		{
+			queues.push_back(new WorkerQueue());
+		}
+
+		// Worker 0 is whoever calls Run.
+		for (int i = 1; i < threadCount; i++)
+		{
+			threads.push_back(std::thread(&WorkStealingPool::WorkerLoop, this, i));
+		}
+	}
+
+	WorkStealingPool::~WorkStealingPool()
+	{
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			quitting = true;
+		}
+		wake.notify_all();
+
+		for (unsigned int i = 0; i < threads.size(); i++)
+		{
+			threads[i].join();
+		}
+
+		for (unsigned int i = 0; i < queues.size(); i++)
+		{
+			delete queues[i];
+		}
+		queues.clear();
+	}
+
+	int WorkStealingPool::GetThreadCount() const
+	{
+		return (int)queues.size();
+	}
+
+	bool WorkStealingPool::TakeTask(int worker, int &task)
+	{
+		// Own work first, newest end.
+		{
+			WorkerQueue& own = *queues[worker];
+			std::lock_guard<std::mutex> guard(own.lock);
+			if (!own.tasks.empty())
+			{
+				task = own.tasks.back();
+				own.tasks.pop_back();
+				return true;
+			}
+		}
+
+		// Then steal the oldest task from whoever is next along.
+		const int count = (int)queues.size();
+		for (int i = 1; i < count; i++)
+		{
+			WorkerQueue& victim = *queues[(worker + i) % count];
+			std::lock_guard<std::mutex> guard(victim.lock);
+			if (!victim.tasks.empty())
+			{
+				task = victim.tasks.front();
+				victim.tasks.pop_front();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void WorkStealingPool::RunTasks(int worker)
+	{
+		int task = 0;
+		while (TakeTask(worker, task))
+		{
+			(*function)(task, worker);
+
+			if (remaining.fetch_sub(1) == 1)
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				finished.notify_all();
+			}
+		}
+	}
+
+	void WorkStealingPool::WorkerLoop(int worker)
+	{
+		int seenGeneration = 0;
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				while (!quitting && seenGeneration == generation)
+				{
+					wake.wait(guard);
+				}
+				if (quitting)
+					return;
+
+				seenGeneration = generation;
+			}
+
+			RunTasks(worker);
+		}
+	}
+
+	void WorkStealingPool::Run(int taskCount, const TaskFunction& func)
+	{
+		if (taskCount <= 0)
+			return;
+
+		// Set up the job before any task is queued, a worker still finishing the last Run
+		// may pick up one of the new tasks straight away.
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			function = &func;
+			remaining = taskCount;
+		}
+
+		// Deal the tasks out in contiguous runs, one per worker.
+		const int count = (int)queues.size();
+		for (int i = 0; i < count; i++)
+		{
+			WorkerQueue& queue = *queues[i];
+			std::lock_guard<std::mutex> guard(queue.lock);
+			const int first = (int)((long long)taskCount * i / count);
+			const int last = (int)((long long)taskCount * (i + 1) / count);
+			for (int task = last - 1; task >= first; task--)
+			{
+				// Popped from the back, so the run is worked through in order.
+				queue.tasks.push_back(task);
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			generation++;
+		}
+		wake.notify_all();
+
+		RunTasks(0);
+
+		std::unique_lock<std::mutex> guard(lock);
+		while (remaining.load() != 0)
+		{
+			finished.wait(guard);
+		}
+		function = NULL;
+	}
+
+}; // End namespace CarDemo.
\ No newline at end of file
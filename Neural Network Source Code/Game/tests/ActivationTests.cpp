@@ -0,0 +1,86 @@
+//****************************************************************************
+//**
+//**    ActivationTests.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <float.h>
+#include <math.h>
+#include <vector>
+
+#include "TestFramework.h"
+
+#include "Activation.h"
+#include "LayerKernels.h"
+
+using namespace CarDemo;
+
+// Every 1/256 across [-SWEEP_RANGE, SWEEP_RANGE], which crosses the table's clamp at 16 and
+// expf's limits at 88, then the far ends of the float range.
+static const float SWEEP_RANGE = 100.0f;
+static const float SWEEP_STEP = 1.0f / 256.0f;
+static const float EXTREMES[] = { FLT_MAX, 1e30f, 1e6f, 88.5f, 88.0f, 87.5f, 16.5f, 16.0f, FLT_MIN, 0.0f };
+
+static void BuildSweep(std::vector<float>& out)
+{
+	out.clear();
+	for (float a = -SWEEP_RANGE; a <= SWEEP_RANGE; a += SWEEP_STEP)
+	{
+		out.push_back(a);
+	}
+	for (unsigned int i = 0; i < sizeof(EXTREMES) / sizeof(EXTREMES[0]); i++)
+	{
+		out.push_back(EXTREMES[i]);
+		out.push_back(-EXTREMES[i]);
+	}
+}
+
+// The largest distance between 'values' and the sigmoid of 'inputs' worked out in double.
+static double MaxError(const std::vector<float>& inputs, const std::vector<float>& values)
+{
+	double worst = 0.0;
+	for (unsigned int i = 0; i < inputs.size(); i++)
+	{
+		const double expected = 1.0 / (1.0 + exp(-(double)inputs[i]));
+		const double error = fabs((double)values[i] - expected);
+		if (!(error <= worst))
+		{
+			worst = error;
+		}
+	}
+	return worst;
+}
+
+// Checks a mode against the bound its ActivationMode entry documents, one value at a time and
+// through the bulk kernel at every level the CPU runs.
+static void CheckSigmoidError(ActivationMode mode, float (*single)(float), double bound)
+{
+	std::vector<float> inputs, values;
+	BuildSweep(inputs);
+
+	values.resize(inputs.size());
+	for (unsigned int i = 0; i < inputs.size(); i++)
+	{
+		values[i] = single(inputs[i]);
+	}
+	CHECK(MaxError(inputs, values) < bound);
+
+	for (int level = KERNEL_SCALAR; level <= DetectKernelLevel(); level++)
+	{
+		values = inputs;
+		ApplySigmoid(&values[0], (int)values.size(), mode, (KernelLevel)level);
+		CHECK(MaxError(inputs, values) < bound);
+	}
+}
+
+TEST_CASE(SigmoidModesStayWithinDocumentedError)
+{
+	CheckSigmoidError(ACTIVATION_EXACT, SigmoidExact, 1e-7);
+	CheckSigmoidError(ACTIVATION_APPROX, SigmoidApprox, 1e-7);
+	CheckSigmoidError(ACTIVATION_TABLE, SigmoidTable, 1e-6);
+}
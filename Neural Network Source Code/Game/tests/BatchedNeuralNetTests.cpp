@@ -0,0 +1,114 @@
+//****************************************************************************
+//**
+//**    BatchedNeuralNetTests.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <math.h>
+#include <vector>
+
+#include "TestFramework.h"
+
+#include "BatchedNeuralNet.h"
+#include "Genome.h"
+#include "NetworkLayout.h"
+#include "NeuralNet.h"
+#include "RandomStream.h"
+
+using namespace CarDemo;
+
+// Not a multiple of 4 or 8, so the batch kernels' tails run too.
+static const int AGENT_COUNT = 37;
+
+// Two hidden layers with different functions, so the layers can't be mixed up unnoticed.
+static const NetworkLayout LAYOUT(2, 5, 8, 2, EVAL_TANH, EVAL_SIGMOID);
+
+static void FillRandom(std::vector<float>& out, int count, RandomStream& random)
+{
+	out.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		out[i] = random.NextClamped();
+	}
+}
+
+// The batch and NeuralNet::Update add the same products in another order, so only rounding may
+// tell them apart.
+static void CheckAgent(NeuralNet& net, const float* input, const float* output)
+{
+	net.SetInput(input, LAYOUT.GetTotalInputs());
+	net.Update();
+	for (int o = 0; o < LAYOUT.GetTotalOutputs(); o++)
+	{
+		CHECK(fabsf(output[o] - net.GetOutput(o)) <= 1e-5f);
+	}
+}
+
+// Checks row 'i' of a per genome batch against a NeuralNet viewing that row's genome.
+static void CheckGenomeRows(const std::vector<float>& inputs, const std::vector<float>& outputs,
+							const float* weights, int genomeStride, const int* agents, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		const int agent = agents != NULL ? agents[i] : i;
+		const Genome genome(agent, 0.0f, weights + agent * genomeStride, LAYOUT.GetTotalWeights());
+
+		NeuralNet net;
+		net.FromGenome(genome, LAYOUT);
+		CheckAgent(net, &inputs[i * LAYOUT.GetTotalInputs()], &outputs[i * LAYOUT.GetTotalOutputs()]);
+	}
+}
+
+TEST_CASE(BatchedNeuralNetMatchesNeuralNet)
+{
+	RandomStream random(11);
+	std::vector<float> inputs, outputs(AGENT_COUNT * LAYOUT.GetTotalOutputs());
+	FillRandom(inputs, AGENT_COUNT * LAYOUT.GetTotalInputs(), random);
+
+	// Shared weights, one matrix-matrix product per layer.
+	std::vector<float> sharedWeights;
+	FillRandom(sharedWeights, LAYOUT.GetTotalWeights(), random);
+	NeuralNet shared;
+	shared.FromGenome(Genome(0, 0.0f, &sharedWeights[0], LAYOUT.GetTotalWeights()), LAYOUT);
+
+	BatchedNeuralNet batch;
+	batch.SetSharedNet(shared);
+	batch.UpdateBatch(&inputs[0], AGENT_COUNT, &outputs[0]);
+	for (int a = 0; a < AGENT_COUNT; a++)
+	{
+		CheckAgent(shared, &inputs[a * LAYOUT.GetTotalInputs()], &outputs[a * LAYOUT.GetTotalOutputs()]);
+	}
+
+	// A genome per agent, padded apart like a GA arena's.
+	const int stride = LAYOUT.GetTotalWeights() + 3;
+	std::vector<float> population;
+	FillRandom(population, AGENT_COUNT * stride, random);
+
+	batch.SetLayout(LAYOUT);
+	batch.SetGenomeWeights(&population[0], stride, AGENT_COUNT);
+	batch.UpdateBatch(&inputs[0], AGENT_COUNT, &outputs[0]);
+	CheckGenomeRows(inputs, outputs, &population[0], stride, NULL, AGENT_COUNT);
+
+	// Runs of 1 to 6 rows on one genome are batched, the single rows are not.
+	std::vector<int> agents;
+	for (int run = 1; (int)agents.size() < AGENT_COUNT; run = run % 6 + 1)
+	{
+		const int agent = (int)random.NextBelow(AGENT_COUNT);
+		for (int r = 0; r < run && (int)agents.size() < AGENT_COUNT; r++)
+		{
+			agents.push_back(agent);
+		}
+	}
+	batch.UpdateBatch(&inputs[0], &agents[0], AGENT_COUNT, &outputs[0]);
+	CheckGenomeRows(inputs, outputs, &population[0], stride, &agents[0], AGENT_COUNT);
+
+	// A stride of 0 puts the whole batch on one genome.
+	batch.SetGenomeWeights(&population[0], 0, AGENT_COUNT);
+	batch.UpdateBatch(&inputs[0], AGENT_COUNT, &outputs[0]);
+	CheckGenomeRows(inputs, outputs, &population[0], 0, NULL, AGENT_COUNT);
+}
@@ -0,0 +1,147 @@
+//****************************************************************************
+//**
+//**    CrossoverTests.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <vector>
+
+#include "TestFramework.h"
+
+#include "BreedingPolicy.h"
+#include "GeneticAlgorithm.h"
+#include "Genome.h"
+#include "NetworkLayout.h"
+
+using namespace CarDemo;
+
+static const int CROSSOVER_POPULATION = 40;
+
+// The parent whose weight 'position' is 'value', -1 if none or more than one has it. Random
+// weights make every parent's value at a position its own.
+static int FindParent(const std::vector<float>& parents, int totalWeights, int position, float value)
+{
+	int found = -1;
+	for (int p = 0; p < CROSSOVER_POPULATION; p++)
+	{
+		if (parents[p * totalWeights + position] == value)
+		{
+			if (found >= 0)
+				return -1;
+			found = p;
+		}
+	}
+	return found;
+}
+
+// Breeds one generation with 'crossover' and no mutation, then traces every child weight back
+// to its parent. Returns the number of pairs whose parents differed.
+static int CheckCrossover(CrossoverOperator crossover, int crossoverPoints)
+{
+	const NetworkLayout layout(2, 5, 8, 2);
+	const int totalWeights = layout.GetTotalWeights();
+
+	// Every child is bred, from parents drawn by tournament so the pairs vary.
+	BreedingPolicy policy;
+	policy.eliteCount = 0;
+	policy.immigrantFraction = 0.0f;
+	policy.selection = SELECTION_TOURNAMENT;
+	policy.selectionSize = 2;
+	policy.crossover = crossover;
+	policy.crossoverPoints = crossoverPoints;
+	policy.mutation = MUTATION_NONE;
+
+	GeneticAlgorithm genAlg;
+	genAlg.SetSeed(24);
+	genAlg.SetBreedingPolicy(policy);
+	genAlg.GenerateCrossoverSplits(layout);
+	genAlg.GenerateNewPopulation(CROSSOVER_POPULATION, totalWeights);
+	for (int i = 0; i < CROSSOVER_POPULATION; i++)
+	{
+		genAlg.SetGenomeFitness((float)i, i);
+	}
+
+	const std::vector<float> parents(genAlg.GetPopulationWeights(),
+									 genAlg.GetPopulationWeights() + CROSSOVER_POPULATION * totalWeights);
+	genAlg.BreedPopulation();
+
+	// Where each neuron's row starts, as GenerateCrossoverSplits cuts them.
+	std::vector<int> blockStarts;
+	for (int l = 0; l < layout.GetTotalLayers(); l++)
+	{
+		const LayerLayout& layer = layout.GetLayer(l);
+		for (int n = 0; n < layer.neurons; n++)
+		{
+			blockStarts.push_back(layer.offset + n * (layer.inputs + 1));
+		}
+	}
+	blockStarts.push_back(totalWeights);
+
+	int mixedPairs = 0;
+	for (int child = 0; child < CROSSOVER_POPULATION; child += 2)
+	{
+		const float* baby1 = genAlg.GetGenome(child).weights;
+		const float* baby2 = genAlg.GetGenome(child + 1).weights;
+
+		int switches = 0;
+		int previous = -1;
+		int mother = -1;
+		int father = -1;
+		for (unsigned int b = 0; b + 1 < blockStarts.size(); b++)
+		{
+			// A whole neuron comes from one parent, and its twin gets the other parent's copy.
+			const int first = FindParent(parents, totalWeights, blockStarts[b], baby1[blockStarts[b]]);
+			const int other = FindParent(parents, totalWeights, blockStarts[b], baby2[blockStarts[b]]);
+			CHECK(first >= 0 && other >= 0);
+			for (int w = blockStarts[b]; w < blockStarts[b + 1]; w++)
+			{
+				CHECK(FindParent(parents, totalWeights, w, baby1[w]) == first);
+				CHECK(FindParent(parents, totalWeights, w, baby2[w]) == other);
+			}
+
+			// The same two parents throughout.
+			if (b == 0)
+			{
+				mother = first;
+				father = other;
+			}
+			CHECK((first == mother && other == father) || (first == father && other == mother));
+
+			switches += (b > 0 && first != previous) ? 1 : 0;
+			previous = first;
+		}
+
+		if (mother != father)
+		{
+			mixedPairs++;
+			if (crossover == CROSSOVER_NEURON_POINT)
+			{
+				CHECK(switches <= 1);
+			}
+			else if (crossover == CROSSOVER_MULTI_POINT)
+			{
+				CHECK(switches == crossoverPoints);
+			}
+			else if (crossover == CROSSOVER_NONE)
+			{
+				CHECK(switches == 0);
+			}
+		}
+	}
+	return mixedPairs;
+}
+
+TEST_CASE(CrossoverKeepsNeuronsWhole)
+{
+	CHECK(CheckCrossover(CROSSOVER_NEURON_POINT, 1) > 0);
+	CHECK(CheckCrossover(CROSSOVER_MULTI_POINT, 1) > 0);
+	CHECK(CheckCrossover(CROSSOVER_MULTI_POINT, 3) > 0);
+	CHECK(CheckCrossover(CROSSOVER_MULTI_POINT, 7) > 0);
+	CHECK(CheckCrossover(CROSSOVER_UNIFORM, 1) > 0);
+	CHECK(CheckCrossover(CROSSOVER_NONE, 1) > 0);
+}
@@ -0,0 +1,201 @@
+//****************************************************************************
+//**
+//**    GACheckpointTests.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "TestFramework.h"
+
+#include "BreedingPolicy.h"
+#include "GACheckpoint.h"
+#include "GeneticAlgorithm.h"
+#include "Genome.h"
+#include "NetFile.h"
+#include "NetworkLayout.h"
+
+using namespace CarDemo;
+
+static const int TEST_POPULATION = 40;
+
+// A stand in for driving the track: any fitness that depends on every weight will do.
+static void ScorePopulation(GeneticAlgorithm& genAlg)
+{
+	for (int i = 0; i < genAlg.GetTotalPopulation(); i++)
+	{
+		const Genome genome = genAlg.GetGenome(i);
+		float fitness = 0.0f;
+		for (int j = 0; j < genome.totalWeights; j++)
+		{
+			fitness += genome.weights[j] * (float)((j % 5) - 2);
+		}
+		genAlg.SetGenomeFitness(fitness > 0.0f ? fitness : 0.0f, i);
+	}
+}
+
+static void RunGenerations(GeneticAlgorithm& genAlg, int generations)
+{
+	for (int i = 0; i < generations; i++)
+	{
+		ScorePopulation(genAlg);
+		genAlg.BreedPopulation();
+	}
+}
+
+static void StartPopulation(GeneticAlgorithm& genAlg, const BreedingPolicy& policy)
+{
+	const NetworkLayout layout(1, 5, 8, 2);
+	genAlg.SetSeed(21);
+	genAlg.SetBreedingPolicy(policy);
+	genAlg.GenerateCrossoverSplits(layout);
+	genAlg.GenerateNewPopulation(TEST_POPULATION, layout.GetTotalWeights());
+}
+
+// Resumes from a snapshot taken mid run and checks the two runs end up byte for byte the same,
+// weights, fitnesses, IDs, sigmas and generator alike.
+static void CheckResume(const BreedingPolicy& policy)
+{
+	GeneticAlgorithm uninterrupted;
+	StartPopulation(uninterrupted, policy);
+	RunGenerations(uninterrupted, 2);
+
+	std::vector<unsigned char> snapshot;
+	uninterrupted.SaveState(snapshot);
+	RunGenerations(uninterrupted, 4);
+
+	GeneticAlgorithm resumed;
+	resumed.SetBreedingPolicy(policy);
+	resumed.GenerateCrossoverSplits(NetworkLayout(1, 5, 8, 2));
+	CHECK(resumed.LoadState(&snapshot[0], snapshot.size()));
+	CHECK(resumed.GetCurrentGeneration() == 3);
+	RunGenerations(resumed, 4);
+
+	std::vector<unsigned char> expected;
+	std::vector<unsigned char> actual;
+	uninterrupted.SaveState(expected);
+	resumed.SaveState(actual);
+	CHECK(expected == actual);
+}
+
+TEST_CASE(CheckpointResumeIsBitExact)
+{
+	CheckResume(BreedingPolicy());
+
+	BreedingPolicy adaptive;
+	adaptive.mutation = MUTATION_SELF_ADAPTIVE;
+	adaptive.selection = SELECTION_TOURNAMENT;
+	adaptive.crossover = CROSSOVER_UNIFORM;
+	CheckResume(adaptive);
+}
+
+TEST_CASE(CheckpointRejectsDamage)
+{
+	GeneticAlgorithm genAlg;
+	StartPopulation(genAlg, BreedingPolicy());
+	RunGenerations(genAlg, 1);
+
+	std::vector<unsigned char> before;
+	genAlg.SaveState(before);
+
+	std::vector<unsigned char> damaged = before;
+	damaged[damaged.size() / 2] ^= 0x10;
+	CHECK(!genAlg.LoadState(&damaged[0], damaged.size()));
+
+	std::vector<unsigned char> truncated(before.begin(), before.end() - 4);
+	CHECK(!genAlg.LoadState(&truncated[0], truncated.size()));
+
+	// A rejected buffer leaves the GA as it was.
+	std::vector<unsigned char> after;
+	genAlg.SaveState(after);
+	CHECK(before == after);
+}
+
+TEST_CASE(CheckpointLoadsVersion2)
+{
+	BreedingPolicy policy;
+	policy.mutationSigma = 0.125f;
+
+	GeneticAlgorithm genAlg;
+	StartPopulation(genAlg, policy);
+	RunGenerations(genAlg, 1);
+
+	std::vector<unsigned char> current;
+	genAlg.SaveState(current);
+
+	// Version 2 is version 3 without the sigmas on the end.
+	std::vector<unsigned char> old(current.begin(), current.end() - TEST_POPULATION * sizeof(float));
+	GACheckpointHeader header;
+	memcpy(&header, &old[0], sizeof(header));
+	header.version = GA_CHECKPOINT_VERSION_NO_SIGMAS;
+	header.fileSize = old.size();
+	header.checksum = NetFileChecksum(&old[sizeof(header)], old.size() - sizeof(header));
+	memcpy(&old[0], &header, sizeof(header));
+
+	GeneticAlgorithm loaded;
+	loaded.SetBreedingPolicy(policy);
+	CHECK(loaded.LoadState(&old[0], old.size()));
+
+	// Everything but the sigmas comes back, and they start over at the policy's.
+	std::vector<unsigned char> resaved;
+	loaded.SaveState(resaved);
+	CHECK(resaved.size() == current.size());
+	CHECK(memcmp(&resaved[sizeof(header)], &current[sizeof(header)], old.size() - sizeof(header)) == 0);
+
+	const float* sigmas = (const float*)&resaved[old.size()];
+	for (int i = 0; i < TEST_POPULATION; i++)
+	{
+		CHECK(sigmas[i] == policy.mutationSigma);
+	}
+}
+
+TEST_CASE(CheckpointFileRoundTrip)
+{
+	const char* filename = "CheckpointTest/Nested/Population.ckpt";
+	remove(filename);
+
+	GeneticAlgorithm genAlg;
+	StartPopulation(genAlg, BreedingPolicy());
+	RunGenerations(genAlg, 2);
+
+	// The directories don't exist yet; the writer makes them.
+	CHECK(genAlg.SaveCheckpoint(filename));
+	CHECK(genAlg.WaitForCheckpoint());
+
+	GeneticAlgorithm loaded;
+	CHECK(loaded.LoadCheckpoint(filename));
+
+	std::vector<unsigned char> expected;
+	std::vector<unsigned char> actual;
+	genAlg.SaveState(expected);
+	loaded.SaveState(actual);
+	CHECK(expected == actual);
+}
+
+TEST_CASE(CheckpointWriteFailureIsReported)
+{
+	// A file where the directory should be, so the snapshot can never be written.
+	FILE* blocker = fopen("CheckpointBlocker", "wb");
+	CHECK(blocker != NULL);
+	if (blocker != NULL)
+	{
+		fclose(blocker);
+	}
+
+	GeneticAlgorithm genAlg;
+	StartPopulation(genAlg, BreedingPolicy());
+
+	// The first failure is reported by the next snapshot, not only at the end.
+	CHECK(genAlg.SaveCheckpoint("CheckpointBlocker/Population.ckpt"));
+	CHECK(!genAlg.SaveCheckpoint("CheckpointBlocker/Population.ckpt"));
+	CHECK(!genAlg.WaitForCheckpoint());
+
+	remove("CheckpointBlocker");
+}
@@ -0,0 +1,200 @@
+//****************************************************************************
+//**
+//**    LayerKernelTests.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <math.h>
+#include <vector>
+
+#include "TestFramework.h"
+
+#include "LayerKernels.h"
+#include "NLayer.h"
+#include "RandomStream.h"
+
+using namespace CarDemo;
+
+// Shapes chosen to leave every remainder of a 4 and an 8 wide vector, so the SSE2 tail and
+// the AVX2 masked tail both run.
+static const int INPUT_COUNTS[] = { 1, 2, 3, 4, 5, 7, 8, 9, 13, 15, 16, 17, 31, 33, 65 };
+static const int NEURON_COUNTS[] = { 1, 2, 3, 4, 5, 8, 13 };
+static const int AGENT_COUNTS[] = { 1, 3, 4, 7, 8, 15, 17, 33, 70 };
+
+// The SIMD kernels add in another order (and AVX2 fuses its multiply-adds), so they agree with
+// the scalar kernel to within rounding of the sum's terms rather than to the bit.
+static bool CloseEnough(float value, float expected, float magnitude)
+{
+	return fabsf(value - expected) <= 1e-5f * magnitude + 1e-6f;
+}
+
+static float RowMagnitude(const float* row, int inputs, const float* input, int inputStride)
+{
+	float magnitude = fabsf(row[inputs] * BIAS);
+	for (int j = 0; j < inputs; j++)
+	{
+		magnitude += fabsf(row[j] * input[j * inputStride]);
+	}
+	return magnitude;
+}
+
+static void FillRandom(std::vector<float>& out, int count, RandomStream& random)
+{
+	out.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		out[i] = random.NextClamped() * 4.0f;
+	}
+}
+
+TEST_CASE(DenseKernelsMatchScalar)
+{
+	RandomStream random(3);
+	std::vector<float> weights, input, expected, actual;
+
+	for (int level = KERNEL_SSE2; level <= DetectKernelLevel(); level++)
+	{
+		const DenseKernel kernel = GetDenseKernel((KernelLevel)level);
+		for (unsigned int i = 0; i < sizeof(INPUT_COUNTS) / sizeof(INPUT_COUNTS[0]); i++)
+		{
+			for (unsigned int n = 0; n < sizeof(NEURON_COUNTS) / sizeof(NEURON_COUNTS[0]); n++)
+			{
+				const int inputs = INPUT_COUNTS[i];
+				const int neurons = NEURON_COUNTS[n];
+				FillRandom(weights, neurons * (inputs + 1), random);
+				FillRandom(input, inputs, random);
+
+				// A guard past the end catches a tail that writes too far.
+				expected.assign(neurons + 1, 123.0f);
+				actual.assign(neurons + 1, 123.0f);
+				DenseLayerScalar(&weights[0], neurons, inputs, &input[0], &expected[0]);
+				kernel(&weights[0], neurons, inputs, &input[0], &actual[0]);
+
+				for (int r = 0; r < neurons; r++)
+				{
+					const float magnitude = RowMagnitude(&weights[r * (inputs + 1)], inputs, &input[0], 1);
+					CHECK(CloseEnough(actual[r], expected[r], magnitude));
+				}
+				CHECK(actual[neurons] == 123.0f);
+			}
+		}
+	}
+}
+
+TEST_CASE(DenseBatchKernelsMatchScalar)
+{
+	RandomStream random(4);
+	std::vector<float> weights, input, expected, actual;
+
+	for (int level = KERNEL_SSE2; level <= DetectKernelLevel(); level++)
+	{
+		const DenseBatchKernel kernel = GetDenseBatchKernel((KernelLevel)level);
+		for (unsigned int i = 0; i < sizeof(INPUT_COUNTS) / sizeof(INPUT_COUNTS[0]); i++)
+		{
+			for (unsigned int c = 0; c < sizeof(AGENT_COUNTS) / sizeof(AGENT_COUNTS[0]); c++)
+			{
+				const int inputs = INPUT_COUNTS[i];
+				const int neurons = 5;
+				const int count = AGENT_COUNTS[c];
+				FillRandom(weights, neurons * (inputs + 1), random);
+				FillRandom(input, inputs * count, random);
+
+				expected.assign(neurons * count + 1, 123.0f);
+				actual.assign(neurons * count + 1, 123.0f);
+				DenseBatchScalar(&weights[0], neurons, inputs, &input[0], count, &expected[0]);
+				kernel(&weights[0], neurons, inputs, &input[0], count, &actual[0]);
+
+				for (int r = 0; r < neurons; r++)
+				{
+					for (int a = 0; a < count; a++)
+					{
+						const float magnitude = RowMagnitude(&weights[r * (inputs + 1)], inputs, &input[a], count);
+						CHECK(CloseEnough(actual[r * count + a], expected[r * count + a], magnitude));
+					}
+				}
+				CHECK(actual[neurons * count] == 123.0f);
+			}
+		}
+	}
+}
+
+TEST_CASE(DenseInt8KernelsMatchScalar)
+{
+	RandomStream random(5);
+
+	for (int level = KERNEL_SSE2; level <= DetectKernelLevel(); level++)
+	{
+		const DenseInt8Kernel kernel = GetDenseInt8Kernel((KernelLevel)level);
+		for (int stride = INT8_ROW_ALIGNMENT; stride <= 4 * INT8_ROW_ALIGNMENT; stride += INT8_ROW_ALIGNMENT)
+		{
+			const int neurons = 7;
+			std::vector<signed char> weights(neurons * stride);
+			std::vector<short> input(stride);
+			for (unsigned int i = 0; i < weights.size(); i++)
+			{
+				weights[i] = (signed char)((int)random.NextBelow(255) - 127);
+			}
+			for (int i = 0; i < stride; i++)
+			{
+				input[i] = (short)((int)random.NextBelow(65535) - 32767);
+			}
+
+			// Integer sums, so these have to match exactly.
+			std::vector<int> expected(neurons), actual(neurons);
+			DenseInt8Scalar(&weights[0], neurons, stride, &input[0], &expected[0]);
+			kernel(&weights[0], neurons, stride, &input[0], &actual[0]);
+			CHECK(expected == actual);
+		}
+	}
+}
+
+TEST_CASE(DenseHalfKernelsMatchFloat)
+{
+	CHECK(HalfToFloat(0x3c00) == 1.0f);
+	CHECK(HalfToFloat(0xc100) == -2.5f);
+	CHECK(HalfToFloat(0x3555) == 0.333251953125f);
+	CHECK(HalfToFloat(0x0000) == 0.0f);
+	CHECK(HalfToFloat(0x7c00) == HUGE_VALF);
+
+	RandomStream random(6);
+	std::vector<unsigned short> halves;
+	std::vector<float> widened, input, expected, actual;
+
+	for (int level = KERNEL_SCALAR; level <= DetectKernelLevel(); level++)
+	{
+		const DenseHalfKernel kernel = GetDenseHalfKernel((KernelLevel)level);
+		for (unsigned int i = 0; i < sizeof(INPUT_COUNTS) / sizeof(INPUT_COUNTS[0]); i++)
+		{
+			for (unsigned int n = 0; n < sizeof(NEURON_COUNTS) / sizeof(NEURON_COUNTS[0]); n++)
+			{
+				const int inputs = INPUT_COUNTS[i];
+				const int neurons = NEURON_COUNTS[n];
+				const int total = neurons * (inputs + 1);
+
+				// Either sign, exponents from 1/64 to 4, any mantissa, and the odd zero.
+				halves.resize(total);
+				widened.resize(total);
+				for (int w = 0; w < total; w++)
+				{
+					const unsigned int exponent = 9 + random.NextBelow(9);
+					halves[w] = (unsigned short)((random.NextBelow(2) << 15) | (exponent << 10) | random.NextBelow(1024));
+					halves[w] = random.NextBelow(16) == 0 ? (unsigned short)(halves[w] & 0x8000) : halves[w];
+					widened[w] = HalfToFloat(halves[w]);
+				}
+				FillRandom(input, inputs, random);
+
+				// Widening is exact, so a level's half kernel must give its float kernel's bits.
+				expected.assign(neurons + 1, 123.0f);
+				actual.assign(neurons + 1, 123.0f);
+				GetDenseKernel((KernelLevel)level)(&widened[0], neurons, inputs, &input[0], &expected[0]);
+				kernel(&halves[0], neurons, inputs, &input[0], &actual[0]);
+				CHECK(actual == expected);
+			}
+		}
+	}
+}
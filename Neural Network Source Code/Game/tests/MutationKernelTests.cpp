@@ -0,0 +1,185 @@
+//****************************************************************************
+//**
+//**    MutationKernelTests.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include "TestFramework.h"
+
+#include "BreedingPolicy.h"
+#include "GeneticAlgorithm.h"
+#include "MutationKernels.h"
+#include "RandomStream.h"
+
+using namespace CarDemo;
+
+// Counts that leave every remainder of a group, so the padded tail runs too.
+static const int WEIGHT_COUNTS[] = { 1, 7, 8, 9, 66, 1003 };
+
+// Mutates a fresh block of zeros with the kernel 'get' returns for 'level'.
+static std::vector<float> Mutate(MutationKernel (*get)(KernelLevel), KernelLevel level, int count, float rate,
+								 float scale)
+{
+	RandomStream random(77);
+	MutationLanes lanes;
+	lanes.Seed(random);
+
+	std::vector<float> weights(count, 0.0f);
+	ApplyMutation(get(level), &weights[0], count, rate, scale, lanes);
+
+	// A second pass carries on from where the lanes were left.
+	ApplyMutation(get(level), &weights[0], count, rate, scale, lanes);
+	return weights;
+}
+
+TEST_CASE(MutationKernelsMatchAtEveryLevel)
+{
+	MutationKernel (*kernels[])(KernelLevel) = { GetUniformMutationKernel, GetGaussianMutationKernel };
+
+	for (unsigned int k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+	{
+		for (unsigned int c = 0; c < sizeof(WEIGHT_COUNTS) / sizeof(WEIGHT_COUNTS[0]); c++)
+		{
+			const int count = WEIGHT_COUNTS[c];
+			const std::vector<float> scalar = Mutate(kernels[k], KERNEL_SCALAR, count, 0.15f, 0.3f);
+			for (int level = KERNEL_SSE2; level <= DetectKernelLevel(); level++)
+			{
+				// To the bit, so a seed trains the same on any CPU.
+				const std::vector<float> simd = Mutate(kernels[k], (KernelLevel)level, count, 0.15f, 0.3f);
+				CHECK(memcmp(&scalar[0], &simd[0], count * sizeof(float)) == 0);
+			}
+		}
+	}
+}
+
+TEST_CASE(MutationKernelDistributions)
+{
+	const int count = 200000;
+	RandomStream random(78);
+	MutationLanes lanes;
+	lanes.Seed(random);
+	std::vector<float> weights(count);
+
+	// Uniform keeps the legacy test of one clamped draw against the rate: at 0.15 a weight
+	// moves with probability 1 - (1 - 0.15)^2 / 2, moving by up to the scale either way.
+	weights.assign(count, 0.0f);
+	ApplyMutation(GetUniformMutationKernel(), &weights[0], count, 0.15f, 0.3f, lanes);
+	int moved = 0;
+	float largest = 0.0f;
+	for (int i = 0; i < count; i++)
+	{
+		moved += weights[i] != 0.0f ? 1 : 0;
+		largest = fabsf(weights[i]) > largest ? fabsf(weights[i]) : largest;
+	}
+	CHECK(fabs(moved / (double)count - (1.0 - 0.85 * 0.85 / 2.0)) < 0.01);
+	CHECK(largest <= 0.3f);
+
+	// Gaussian moves 'rate' of the weights by N(0, scale), never past 3.47 sigma.
+	weights.assign(count, 0.0f);
+	ApplyMutation(GetGaussianMutationKernel(), &weights[0], count, 0.25f, 0.1f, lanes);
+	moved = 0;
+	double sum = 0.0;
+	double squares = 0.0;
+	largest = 0.0f;
+	for (int i = 0; i < count; i++)
+	{
+		if (weights[i] != 0.0f)
+		{
+			moved++;
+			sum += weights[i];
+			squares += weights[i] * weights[i];
+		}
+		largest = fabsf(weights[i]) > largest ? fabsf(weights[i]) : largest;
+	}
+	CHECK(fabs(moved / (double)count - 0.25) < 0.01);
+	CHECK(fabs(sum / moved) < 0.002);
+	CHECK(fabs(sqrt(squares / moved) - 0.1) < 0.002);
+	CHECK(largest <= 0.347f);
+}
+
+TEST_CASE(NextGaussianIsStandardNormal)
+{
+	RandomStream random(79);
+	const int count = 200000;
+	double sum = 0.0;
+	double squares = 0.0;
+	int withinOne = 0;
+	for (int i = 0; i < count; i++)
+	{
+		const float value = random.NextGaussian();
+		sum += value;
+		squares += value * value;
+		withinOne += fabsf(value) < 1.0f ? 1 : 0;
+	}
+	CHECK(fabs(sum / count) < 0.01);
+	CHECK(fabs(squares / count - 1.0) < 0.02);
+	CHECK(fabs(withinOne / (double)count - 0.6827) < 0.005);
+}
+
+// Breeds one generation of copies with 'mutation' at 'rate' and returns the fraction of the
+// children's weights that differ from their parents'.
+static double MutatedFraction(MutationOperator mutation, float rate)
+{
+	const int population = 200;
+	const int totalWeights = 500;
+
+	BreedingPolicy policy;
+	policy.eliteCount = 0;
+	policy.immigrantFraction = 0.0f;
+	policy.crossover = CROSSOVER_NONE;
+	policy.mutation = mutation;
+	policy.mutationRate = rate;
+
+	GeneticAlgorithm genAlg;
+	genAlg.SetSeed(80);
+	genAlg.SetBreedingPolicy(policy);
+	genAlg.GenerateNewPopulation(population, totalWeights);
+	for (int i = 0; i < population; i++)
+	{
+		genAlg.SetGenomeFitness((float)i, i);
+	}
+
+	// Truncation breeds from the fittest few; copying them means each child starts as one.
+	const std::vector<float> parents(genAlg.GetPopulationWeights(), genAlg.GetPopulationWeights() + population * totalWeights);
+	genAlg.BreedPopulation();
+
+	int moved = 0;
+	for (int child = 0; child < population; child++)
+	{
+		const float* weights = genAlg.GetGenome(child).weights;
+
+		// The parent it was copied from is the one it shares the most weights with.
+		int bestShared = -1;
+		for (int parent = 0; parent < population; parent++)
+		{
+			int shared = 0;
+			for (int w = 0; w < totalWeights; w++)
+			{
+				shared += weights[w] == parents[parent * totalWeights + w] ? 1 : 0;
+			}
+			bestShared = shared > bestShared ? shared : bestShared;
+		}
+		moved += totalWeights - bestShared;
+	}
+	return moved / ((double)population * totalWeights);
+}
+
+TEST_CASE(BreedingMutatesTheDocumentedFraction)
+{
+	// Uniform: the original RandomClamped() < rate odds, see BreedingPolicy.h.
+	CHECK(fabs(MutatedFraction(MUTATION_UNIFORM, 0.15f) - (1.0 - 0.85 * 0.85 / 2.0)) < 0.01);
+	CHECK(fabs(MutatedFraction(MUTATION_UNIFORM, -0.5f) - (0.5 * 0.5 / 2.0)) < 0.01);
+
+	// Gaussian: the rate itself.
+	CHECK(fabs(MutatedFraction(MUTATION_GAUSSIAN, 0.15f) - 0.15) < 0.01);
+	CHECK(MutatedFraction(MUTATION_NONE, 0.15f) == 0.0);
+}
@@ -0,0 +1,164 @@
+//****************************************************************************
+//**
+//**    NeuralNetTests.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <math.h>
+#include <vector>
+
+#include "TestFramework.h"
+
+#include "Activation.h"
+#include "FixedNeuralNet.h"
+#include "Genome.h"
+#include "NetworkLayout.h"
+#include "NeuralNet.h"
+#include "RandomStream.h"
+
+using namespace CarDemo;
+
+static const int STEADY_STATE_UPDATES = 1000;
+
+// Runs the net for STEADY_STATE_UPDATES frames and returns how many allocations that took.
+static unsigned long long CountUpdateAllocations(NeuralNet& net)
+{
+	float input[5] = { 0.1f, 0.5f, 0.9f, 0.3f, 0.7f };
+	float sum = 0.0f;
+
+	const unsigned long long before = GetAllocationCount();
+	for (int i = 0; i < STEADY_STATE_UPDATES; i++)
+	{
+		input[i % 5] = (float)(i % 7) / 7.0f;
+		net.SetInput(input, 5);
+		net.Update();
+		sum += net.GetOutput(0) + net.GetOutput(1);
+	}
+	const unsigned long long after = GetAllocationCount();
+
+	CHECK(sum == sum);
+	return after - before;
+}
+
+TEST_CASE(NeuralNetUpdateDoesNotAllocate)
+{
+	// The counting operator new must be the one in use, or the checks below prove nothing.
+	const unsigned long long start = GetAllocationCount();
+	std::vector<float> probe(16);
+	CHECK(GetAllocationCount() > start);
+
+	NeuralNet created;
+	created.CreateNet(1, 5, 8, 2);
+	CHECK(CountUpdateAllocations(created) == 0);
+
+	NeuralNet deep;
+	deep.CreateNet(NetworkLayout(3, 5, 16, 2));
+	CHECK(CountUpdateAllocations(deep) == 0);
+
+	const NetworkLayout layout(1, 5, 8, 2);
+	std::vector<float> weights(layout.GetTotalWeights(), 0.25f);
+	const Genome genome(0, 0.0f, &weights[0], layout.GetTotalWeights());
+
+	NeuralNet fromGenome;
+	fromGenome.FromGenome(genome, 5, 8, 2);
+	CHECK(CountUpdateAllocations(fromGenome) == 0);
+
+	NeuralNet view;
+	view.FromGenome(genome, layout);
+	CHECK(CountUpdateAllocations(view) == 0);
+
+	// Rebinding to another genome is part of the steady state too.
+	std::vector<float> otherWeights(layout.GetTotalWeights(), -0.25f);
+	const Genome other(1, 0.0f, &otherWeights[0], layout.GetTotalWeights());
+	const unsigned long long before = GetAllocationCount();
+	CHECK(view.BindGenome(other));
+	CHECK(GetAllocationCount() == before);
+	CHECK(CountUpdateAllocations(view) == 0);
+}
+
+// Runs a FixedNeuralNet with every layer 'F' beside a NeuralNet built from the same genome.
+template <EvalFunction F>
+static void CheckFixedNet(const Genome& genome, RandomStream& random)
+{
+	NeuralNet net;
+	net.SetHiddenFunction(F);
+	net.SetOutputFunction(F);
+	net.FromGenome(genome, 5, 8, 2);
+
+	FixedNeuralNet<F, 5, 8, 2> fixed;
+	fixed.BindGenome(genome);
+	CHECK(fixed.GetWeights() == genome.weights);
+
+	// Only the order of the sums differs, so only rounding may tell them apart.
+	for (int frame = 0; frame < 50; frame++)
+	{
+		float input[5];
+		for (int i = 0; i < 5; i++)
+		{
+			input[i] = random.NextUnit();
+		}
+		net.SetInput(input, 5);
+		net.Update();
+
+		float output[2];
+		fixed.Update(input, output);
+		for (int i = 0; i < 2; i++)
+		{
+			CHECK(fabsf(output[i] - net.GetOutput(i)) <= 1e-5f);
+		}
+	}
+}
+
+TEST_CASE(FixedNeuralNetMatchesNeuralNet)
+{
+	const ActivationMode modes[] = { ACTIVATION_EXACT, ACTIVATION_APPROX, ACTIVATION_TABLE };
+	const ActivationMode originalMode = GetActivationMode();
+
+	const NetworkLayout layout(1, 5, 8, 2);
+	RandomStream random(7);
+	std::vector<float> weights(layout.GetTotalWeights());
+	for (size_t w = 0; w < weights.size(); w++)
+	{
+		weights[w] = random.NextClamped();
+	}
+	const Genome genome(0, 0.0f, &weights[0], layout.GetTotalWeights());
+
+	for (int m = 0; m < 3; m++)
+	{
+		SetActivationMode(modes[m]);
+		CheckFixedNet<EVAL_SIGMOID>(genome, random);
+		CheckFixedNet<EVAL_BIPOLAR>(genome, random);
+		CheckFixedNet<EVAL_RELU>(genome, random);
+		CheckFixedNet<EVAL_TANH>(genome, random);
+		CheckFixedNet<EVAL_LINEAR>(genome, random);
+	}
+
+	// The table and the polynomial round differently, so if the mode reaches the fixed net some
+	// output has to change with it.
+	FixedNeuralNet<EVAL_SIGMOID, 5, 8, 2> fixed;
+	fixed.BindGenome(genome);
+	int changed = 0;
+	for (int frame = 0; frame < 50; frame++)
+	{
+		float input[5];
+		for (int i = 0; i < 5; i++)
+		{
+			input[i] = random.NextUnit();
+		}
+
+		float approx[2], table[2];
+		SetActivationMode(ACTIVATION_APPROX);
+		fixed.Update(input, approx);
+		SetActivationMode(ACTIVATION_TABLE);
+		fixed.Update(input, table);
+		changed += (approx[0] != table[0] || approx[1] != table[1]) ? 1 : 0;
+	}
+	CHECK(changed > 0);
+
+	SetActivationMode(originalMode);
+}
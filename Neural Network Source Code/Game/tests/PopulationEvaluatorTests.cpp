@@ -0,0 +1,103 @@
+//****************************************************************************
+//**
+//**    PopulationEvaluatorTests.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <vector>
+
+#include "TestFramework.h"
+
+#include "GameGlobals.h"
+#include "GeneticAlgorithm.h"
+#include "Genome.h"
+#include "NetworkLayout.h"
+#include "PopulationEvaluator.h"
+#include "Simulation.h"
+#include "TrackGeometry.h"
+
+using namespace CarDemo;
+
+static const int TEST_POPULATION = 48;
+static const int TEST_GENERATIONS = 3;
+
+// Trains a small population for a few generations on 'threads' threads and returns every
+// fitness it saw, generation after generation.
+static std::vector<float> TrainFitnesses(const TrackGeometry& track, const std::vector<Checkpoint>& checkpoints,
+										 int threads)
+{
+	const NetworkLayout layout(1, FEELER_COUNT, HIDDEN_LAYER_NEURONS, NN_OUTPUT_COUNT);
+
+	GeneticAlgorithm genAlg;
+	genAlg.SetSeed(11);
+	genAlg.GenerateCrossoverSplits(layout);
+	genAlg.GenerateNewPopulation(TEST_POPULATION, layout.GetTotalWeights());
+
+	PopulationEvaluator evaluator(track, checkpoints, layout, threads);
+	CHECK(evaluator.GetThreadCount() == threads);
+
+	std::vector<float> fitnesses;
+	for (int generation = 0; generation < TEST_GENERATIONS; generation++)
+	{
+		evaluator.Evaluate(genAlg);
+		for (int i = 0; i < genAlg.GetTotalPopulation(); i++)
+		{
+			fitnesses.push_back(genAlg.GetGenome(i).fitness);
+		}
+		genAlg.BreedPopulation();
+	}
+	return fitnesses;
+}
+
+TEST_CASE(FitnessesDoNotDependOnThreadCount)
+{
+	TrackGeometry track;
+	std::vector<Checkpoint> checkpoints;
+	CHECK(track.Load(GetResourcePath("Track1Polygon.txt")));
+	CHECK(LoadCheckpoints(GetResourcePath("Track1Checkpoints.txt"), checkpoints));
+
+	// Compared with ==, so to the bit: the threads must not change a single rounding.
+	const std::vector<float> single = TrainFitnesses(track, checkpoints, 1);
+	CHECK(single.size() == (size_t)(TEST_POPULATION * TEST_GENERATIONS));
+
+	const int threadCounts[] = { 2, 4, 8 };
+	for (unsigned int i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]); i++)
+	{
+		CHECK(TrainFitnesses(track, checkpoints, threadCounts[i]) == single);
+	}
+
+	// Someone has to have got somewhere, or every fitness being equal proves nothing.
+	float best = 0.0f;
+	for (unsigned int i = 0; i < single.size(); i++)
+	{
+		best = single[i] > best ? single[i] : best;
+	}
+	CHECK(best > 0.0f);
+}
+
+TEST_CASE(EvaluateMatchesEvaluateGenome)
+{
+	TrackGeometry track;
+	std::vector<Checkpoint> checkpoints;
+	CHECK(track.Load(GetResourcePath("Track1Polygon.txt")));
+	CHECK(LoadCheckpoints(GetResourcePath("Track1Checkpoints.txt"), checkpoints));
+
+	const NetworkLayout layout(1, FEELER_COUNT, HIDDEN_LAYER_NEURONS, NN_OUTPUT_COUNT);
+	GeneticAlgorithm genAlg;
+	genAlg.SetSeed(12);
+	genAlg.GenerateNewPopulation(16, layout.GetTotalWeights());
+
+	PopulationEvaluator evaluator(track, checkpoints, layout, 4);
+	evaluator.Evaluate(genAlg);
+
+	for (int i = 0; i < genAlg.GetTotalPopulation(); i++)
+	{
+		const Genome genome = genAlg.GetGenome(i);
+		CHECK(evaluator.EvaluateGenome(genome) == genome.fitness);
+	}
+}
@@ -0,0 +1,169 @@
+//****************************************************************************
+//**
+//**    RandomStreamTests.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <string.h>
+
+#include "TestFramework.h"
+
+#include "RandomStream.h"
+
+using namespace CarDemo;
+
+// ----------------------------------------------------------------------
+// xoshiro128** and its jumps written out as in Blackman and Vigna's
+// reference code, kept apart from RandomStream so the two can disagree.
+// ----------------------------------------------------------------------
+static unsigned int Rotl(unsigned int x, int k)
+{
+	return (x << k) | (x >> (32 - k));
+}
+
+static unsigned int ReferenceNext(unsigned int s[4])
+{
+	const unsigned int result = Rotl(s[1] * 5, 7) * 9;
+	const unsigned int t = s[1] << 9;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = Rotl(s[3], 11);
+
+	return result;
+}
+
+static void ReferenceJump(unsigned int s[4], const unsigned int polynomial[4])
+{
+	unsigned int jumped[4] = { 0, 0, 0, 0 };
+	for (int i = 0; i < 4; i++)
+	{
+		for (int b = 0; b < 32; b++)
+		{
+			if (polynomial[i] & (1u << b))
+			{
+				for (int w = 0; w < 4; w++)
+				{
+					jumped[w] ^= s[w];
+				}
+			}
+			ReferenceNext(s);
+		}
+	}
+	memcpy(s, jumped, sizeof(jumped));
+}
+
+static const unsigned int REFERENCE_JUMP[4] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+static const unsigned int REFERENCE_LONG_JUMP[4] = { 0xb523952e, 0x0b6f099f, 0xccf5a0ef, 0x1c580662 };
+
+static bool SameState(const RandomStream& stream, const unsigned int expected[4])
+{
+	unsigned int state[4];
+	stream.GetState(state);
+	return memcmp(state, expected, sizeof(state)) == 0;
+}
+
+TEST_CASE(RandomStreamMatchesReference)
+{
+	unsigned int reference[4] = { 0x12345678, 0x9abcdef0, 0x0fedcba9, 0x87654321 };
+	RandomStream stream;
+	stream.SetState(reference);
+
+	bool same = true;
+	for (int i = 0; i < 10000; i++)
+	{
+		same = same && stream.Next() == ReferenceNext(reference);
+	}
+	CHECK(same);
+	CHECK(SameState(stream, reference));
+
+	stream.Jump();
+	ReferenceJump(reference, REFERENCE_JUMP);
+	CHECK(SameState(stream, reference));
+
+	stream.LongJump();
+	ReferenceJump(reference, REFERENCE_LONG_JUMP);
+	CHECK(SameState(stream, reference));
+
+	// Both jumps are powers of the same step, so their order can't matter.
+	RandomStream jumpFirst(5);
+	RandomStream longJumpFirst(5);
+	jumpFirst.Jump();
+	jumpFirst.LongJump();
+	longJumpFirst.LongJump();
+	longJumpFirst.Jump();
+	unsigned int state[4];
+	longJumpFirst.GetState(state);
+	CHECK(SameState(jumpFirst, state));
+}
+
+TEST_CASE(RandomStreamSeedAndSplit)
+{
+	// Seeding is SplitMix64, whose first two outputs from zero are well known.
+	const unsigned int zeroSeed[4] = { 0x7b1dcdaf, 0xe220a839, 0xa1b965f4, 0x6e789e6a };
+	RandomStream zero(0);
+	CHECK(SameState(zero, zeroSeed));
+
+	RandomStream a(42), b(42), c(43);
+	bool same = true;
+	bool differs = false;
+	for (int i = 0; i < 1000; i++)
+	{
+		const unsigned int value = a.Next();
+		same = same && value == b.Next();
+		differs = differs || value != c.Next();
+	}
+	CHECK(same);
+	CHECK(differs);
+
+	// Split hands out the parent's stream, then every Jump after it, and leaves the parent
+	// past the last one.
+	RandomStream parent(7);
+	RandomStream expected(7);
+	RandomStream children[3];
+	parent.Split(children, 3);
+	for (int i = 0; i < 3; i++)
+	{
+		unsigned int state[4];
+		expected.GetState(state);
+		CHECK(SameState(children[i], state));
+		expected.Jump();
+	}
+	unsigned int state[4];
+	expected.GetState(state);
+	CHECK(SameState(parent, state));
+}
+
+TEST_CASE(NextBelowIsUniform)
+{
+	RandomStream random(11);
+	const unsigned int bounds[] = { 1, 3, 10, 1000 };
+	for (unsigned int b = 0; b < sizeof(bounds) / sizeof(bounds[0]); b++)
+	{
+		const unsigned int bound = bounds[b];
+		const int draws = 2000 * bound;
+		int counts[1000] = { 0 };
+		bool inRange = true;
+		for (int i = 0; i < draws; i++)
+		{
+			const unsigned int value = random.NextBelow(bound);
+			inRange = inRange && value < bound;
+			counts[value < bound ? value : 0]++;
+		}
+		CHECK(inRange);
+
+		// 2000 expected per value, about 45 either way; 6 sigma is plenty.
+		for (unsigned int v = 0; v < bound; v++)
+		{
+			CHECK(counts[v] > 2000 - 270 && counts[v] < 2000 + 270);
+		}
+	}
+}
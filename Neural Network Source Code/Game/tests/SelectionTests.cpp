@@ -0,0 +1,144 @@
+//****************************************************************************
+//**
+//**    SelectionTests.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <algorithm>
+#include <math.h>
+#include <vector>
+
+#include "TestFramework.h"
+
+#include "RandomStream.h"
+#include "Selection.h"
+
+using namespace CarDemo;
+
+// Falling fitness. Under a stable sort ties stay in index order, as the selectors promise.
+struct FitterFirst
+{
+	const float* fitness;
+
+	bool operator()(int a, int b) const
+	{
+		return fitness[a] > fitness[b];
+	}
+};
+
+// Few distinct values, so plenty of ties.
+static void FillFitness(std::vector<float>& fitness, int count, RandomStream& random)
+{
+	fitness.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		fitness[i] = (float)random.NextBelow(20);
+	}
+}
+
+// True if 'count' draws of probability 'p' landing 'hits' times is within 6 sigma.
+static bool Plausible(int hits, int count, double p)
+{
+	const double expected = count * p;
+	const double sigma = sqrt(count * p * (1.0 - p));
+	return fabs(hits - expected) <= 6.0 * sigma + 1.0;
+}
+
+TEST_CASE(SelectElitesMatchesStableSort)
+{
+	RandomStream random(21);
+	std::vector<float> fitness;
+	std::vector<int> elites;
+	const int counts[] = { 1, 2, 7, 100, 5000 };
+
+	for (unsigned int c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+	{
+		const int count = counts[c];
+		FillFitness(fitness, count, random);
+
+		std::vector<int> sorted(count);
+		for (int i = 0; i < count; i++)
+		{
+			sorted[i] = i;
+		}
+		const FitterFirst order = { &fitness[0] };
+		std::stable_sort(sorted.begin(), sorted.end(), order);
+
+		CHECK(SelectBest(&fitness[0], count) == sorted[0]);
+
+		// Up to the whole population, and more than there is.
+		const int ks[] = { 0, 1, 5, 64, count, count + 3 };
+		for (unsigned int k = 0; k < sizeof(ks) / sizeof(ks[0]); k++)
+		{
+			SelectElites(&fitness[0], count, ks[k], elites);
+
+			const int expected = std::min(ks[k], count);
+			CHECK(elites == std::vector<int>(sorted.begin(), sorted.begin() + expected));
+		}
+	}
+
+	CHECK(SelectBest(NULL, 0) == -1);
+	CHECK(SelectWorst(NULL, 0) == -1);
+}
+
+TEST_CASE(SelectionDistributions)
+{
+	RandomStream random(22);
+	std::vector<int> picks;
+
+	// Genome g has rank g, the fittest first.
+	const int count = 10;
+	const int draws = 200000;
+	std::vector<float> fitness(count);
+	for (int g = 0; g < count; g++)
+	{
+		fitness[g] = (float)(count - g);
+	}
+
+	// A tournament of 'size' is won by rank r when the fittest entrant has rank r.
+	const int size = 3;
+	SelectTournament(&fitness[0], count, size, draws, random, picks);
+	for (int r = 0; r < count; r++)
+	{
+		const double p = (pow((double)(count - r), size) - pow((double)(count - r - 1), size)) / pow((double)count, size);
+		CHECK(Plausible((int)std::count(picks.begin(), picks.end(), r), draws, p));
+	}
+
+	// Linear ranking: the fittest expects 'pressure' picks per genome, the least fit
+	// 2 - 'pressure'. Drawing the pair with replacement adds the odd even contest.
+	const float pressure = 1.8f;
+	SelectRanked(&fitness[0], count, pressure, draws, random, picks);
+	for (int r = 0; r < count; r++)
+	{
+		const double p = (pressure * (count - 1 - r) + (2.0 - pressure) * r + 1.0) / ((double)count * count);
+		CHECK(Plausible((int)std::count(picks.begin(), picks.end(), r), draws, p));
+	}
+
+	// Stochastic universal sampling owes every genome its share to within one pick; negative
+	// fitnesses count as none.
+	RandomStream shares(23);
+	std::vector<float> wheel(37);
+	double total = 0.0;
+	for (unsigned int g = 0; g < wheel.size(); g++)
+	{
+		wheel[g] = g % 5 == 4 ? -1.0f : shares.NextUnit() * 10.0f;
+		total += std::max(wheel[g], 0.0f);
+	}
+	const int spins = 250;
+	for (int pass = 0; pass < 20; pass++)
+	{
+		SelectStochasticUniversal(&wheel[0], (int)wheel.size(), spins, random, picks);
+		CHECK((int)picks.size() == spins);
+		for (unsigned int g = 0; g < wheel.size(); g++)
+		{
+			const double owed = spins * std::max(wheel[g], 0.0f) / total;
+			const int got = (int)std::count(picks.begin(), picks.end(), (int)g);
+			CHECK(got >= (int)floor(owed) && got <= (int)ceil(owed));
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#ifndef _TEST_FRAMEWORK_H
+#define _TEST_FRAMEWORK_H
+
+//****************************************************************************
+//**
+//**    TestFramework.h
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+// Just enough of a test runner for the simulation core. Each TEST_CASE registers itself, and
+// simulation_tests runs the one named on its command line (or all of them), so CMake can
+// hand every case to CTest as a test of its own.
+
+namespace CarDemo
+{
+	typedef void (*TestFunction)();
+
+	class TestRegistrar
+	{
+	private:
+	protected:
+	public:
+		TestRegistrar(const char* name, TestFunction function);
+	};
+
+	// Records a failure of the running test, which carries on so every failed check is listed.
+	void CheckCondition(bool passed, const char* condition, const char* file, int line);
+
+	// How many times operator new has been called since the program started. The test runner
+	// replaces the global operator new and delete with counting versions.
+	unsigned long long GetAllocationCount();
+
+	// Where the demo's track files live, for the tests that drive a Simulation.
+	const char* GetResourcePath(const char* filename);
+
+}; // End namespace CarDemo.
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static CarDemo::TestRegistrar name##Registrar(#name, name); \
+	static void name()
+
+#define CHECK(condition) CarDemo::CheckCondition((condition), #condition, __FILE__, __LINE__)
+
+#endif // #ifndef _TEST_FRAMEWORK_H
@@ -0,0 +1,159 @@
+//****************************************************************************
+//**
+//**    TestMain.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "TestFramework.h"
+
+// ----------------------------------------------------------------------
+// Counting replacements for the global allocation functions. Only the count is added, the
+// memory still comes from malloc.
+// ----------------------------------------------------------------------
+static std::atomic<unsigned long long> allocationCount(0);
+
+static void* CountedAllocate(size_t size)
+{
+	allocationCount++;
+	void* memory = malloc(size > 0 ? size : 1);
+	if (memory == NULL)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new(size_t size)
+{
+	return CountedAllocate(size);
+}
+
+void* operator new[](size_t size)
+{
+	return CountedAllocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	allocationCount++;
+	return malloc(size > 0 ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	allocationCount++;
+	return malloc(size > 0 ? size : 1);
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+namespace CarDemo
+{
+	struct TestCase
+	{
+		const char* name;
+		TestFunction function;
+	};
+
+	// Built on first use, the registrars being static objects of other files.
+	static std::vector<TestCase>& GetTestCases()
+	{
+		static std::vector<TestCase> testCases;
+		return testCases;
+	}
+
+	static int failedChecks = 0;
+
+	TestRegistrar::TestRegistrar(const char* name, TestFunction function)
+	{
+		const TestCase testCase = { name, function };
+		GetTestCases().push_back(testCase);
+	}
+
+	void CheckCondition(bool passed, const char* condition, const char* file, int line)
+	{
+		if (passed)
+			return;
+
+		printf("    %s(%i): CHECK(%s) failed.\n", file, line, condition);
+		failedChecks++;
+	}
+
+	unsigned long long GetAllocationCount()
+	{
+		return allocationCount.load();
+	}
+
+	const char* GetResourcePath(const char* filename)
+	{
+		static std::string path;
+		path = std::string(CARDEMO_RESOURCE_DIR) + "/" + filename;
+		return path.c_str();
+	}
+
+}; // End namespace CarDemo.
+
+using namespace CarDemo;
+
+// simulation_tests [name]: runs the named test, or every test if none is given.
+int main(int argc, char** argv)
+{
+	const char* only = argc > 1 ? argv[1] : NULL;
+	const std::vector<TestCase>& testCases = GetTestCases();
+
+	int ran = 0;
+	int failed = 0;
+	for (unsigned int i = 0; i < testCases.size(); i++)
+	{
+		if (only != NULL && strcmp(only, testCases[i].name) != 0)
+			continue;
+
+		const int failedBefore = failedChecks;
+		testCases[i].function();
+		ran++;
+
+		const bool passed = failedChecks == failedBefore;
+		printf("%s %s\n", passed ? "PASS" : "FAIL", testCases[i].name);
+		if (!passed)
+		{
+			failed++;
+		}
+	}
+
+	if (ran == 0)
+	{
+		printf("No test named '%s'.\n", only != NULL ? only : "");
+		return 1;
+	}
+
+	return failed == 0 ? 0 : 1;
+}
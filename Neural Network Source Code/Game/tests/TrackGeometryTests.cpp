@@ -0,0 +1,155 @@
+//****************************************************************************
+//**
+//**    TrackGeometryTests.cpp
+//**
+//**    Copyright (c) 2010 Matthew Robbins
+//**
+//**    Author:  Matthew Robbins
+//**    Created: 04/2010
+//**
+//****************************************************************************
+
+#include <math.h>
+#include <vector>
+
+#include <Clarity/Math/Circle.h>
+#include <Clarity/Math/Math.h>
+#include <Clarity/Math/Ray2.h>
+
+#include "TestFramework.h"
+
+#include "RandomStream.h"
+#include "SensorKernels.h"
+#include "TrackGeometry.h"
+
+using namespace CarDemo;
+
+// The corners of a box round every wall, padded by 'margin'.
+static void GetTrackBounds(const TrackGeometry& track, float margin, Clarity::Vector2& low, Clarity::Vector2& high)
+{
+	low = track.GetSection(0).GetTail();
+	high = low;
+	for (int i = 0; i < track.GetTotalSections(); i++)
+	{
+		const Clarity::Vector2 ends[2] = { track.GetSection(i).GetTail(), track.GetSection(i).GetHead() };
+		for (int e = 0; e < 2; e++)
+		{
+			low.x = ends[e].x < low.x ? ends[e].x : low.x;
+			low.y = ends[e].y < low.y ? ends[e].y : low.y;
+			high.x = ends[e].x > high.x ? ends[e].x : high.x;
+			high.y = ends[e].y > high.y ? ends[e].y : high.y;
+		}
+	}
+	low.x -= margin;
+	low.y -= margin;
+	high.x += margin;
+	high.y += margin;
+}
+
+static Clarity::Vector2 RandomPoint(const Clarity::Vector2& low, const Clarity::Vector2& high, RandomStream& random)
+{
+	return Clarity::Vector2(low.x + random.NextUnit() * (high.x - low.x), low.y + random.NextUnit() * (high.y - low.y));
+}
+
+TEST_CASE(GridQueryMatchesLinearScan)
+{
+	TrackGeometry track;
+	CHECK(track.Load(GetResourcePath("Track1Polygon.txt")));
+	CHECK(track.GetTotalSections() > 0);
+	if (track.GetTotalSections() == 0)
+		return;
+
+	Clarity::Vector2 low, high;
+	GetTrackBounds(track, 50.0f, low, high);
+
+	RandomStream random(31);
+	std::vector<Clarity::LineSegment2> found;
+	std::vector<int> innerHits, outerHits, candidates;
+	int hitQueries = 0;
+
+	for (int q = 0; q < 20000; q++)
+	{
+		const Clarity::Circle circle(RandomPoint(low, high, random), 2.0f + random.NextUnit() * 30.0f);
+
+		found.clear();
+		innerHits.clear();
+		outerHits.clear();
+		track.QueryPossibleCollisions(circle, found, &innerHits, &outerHits, &candidates);
+
+		// The same exact test over every wall, no grid.
+		std::vector<int> expectedInner, expectedOuter;
+		const int innerCount = (int)track.GetInnerSections().size();
+		for (int i = 0; i < track.GetTotalSections(); i++)
+		{
+			const Clarity::LineSegment2& section = track.GetSection(i);
+			const Clarity::Ray2 ray(section.GetTail(), section.GetDirection());
+			const Clarity::Ray2 ray2(section.GetHead(), section.GetDirection() * -1);
+			if (Clarity::Intersects(circle, ray) && Clarity::Intersects(circle, ray2))
+			{
+				if (i < innerCount)
+				{
+					expectedInner.push_back(i);
+				}
+				else
+				{
+					expectedOuter.push_back(i - innerCount);
+				}
+			}
+		}
+
+		CHECK(innerHits == expectedInner);
+		CHECK(outerHits == expectedOuter);
+		CHECK(found.size() == expectedInner.size() + expectedOuter.size());
+		hitQueries += found.empty() ? 0 : 1;
+	}
+
+	// Enough of the circles have to touch a wall for the comparison to mean anything.
+	CHECK(hitQueries > 1000);
+}
+
+TEST_CASE(RayCastKernelsMatchScalar)
+{
+	TrackGeometry track;
+	CHECK(track.Load(GetResourcePath("Track1Polygon.txt")));
+	if (track.GetTotalSections() == 0)
+		return;
+
+	Clarity::Vector2 low, high;
+	GetTrackBounds(track, 0.0f, low, high);
+
+	// Ray counts that leave the kernels' segment loops every kind of tail.
+	RandomStream random(32);
+	const int rays = 1003;
+	const float maxDistance = 200.0f;
+	std::vector<float> originX(rays), originY(rays), directionX(rays), directionY(rays);
+	for (int r = 0; r < rays; r++)
+	{
+		const Clarity::Vector2 origin = RandomPoint(low, high, random);
+		const float angle = random.NextUnit() * 6.2831853f;
+		originX[r] = origin.x;
+		originY[r] = origin.y;
+		directionX[r] = cosf(angle);
+		directionY[r] = sinf(angle);
+	}
+
+	const SensorSegments& segments = track.GetSensorSegments();
+	std::vector<float> expected(rays);
+	CastRaysScalar(segments, &originX[0], &originY[0], &directionX[0], &directionY[0], rays, maxDistance, &expected[0]);
+
+	int hits = 0;
+	for (int r = 0; r < rays; r++)
+	{
+		hits += expected[r] < maxDistance ? 1 : 0;
+	}
+	CHECK(hits > rays / 4);
+
+	// Bit for bit, which holds as long as SensorKernels.cpp is built without multiply-add
+	// contraction (see KERNEL_SOURCES in CMakeLists.txt).
+	for (int level = KERNEL_SSE2; level <= DetectKernelLevel(); level++)
+	{
+		std::vector<float> actual(rays);
+		GetRayCastKernel((KernelLevel)level)(segments, &originX[0], &originY[0], &directionX[0], &directionY[0], rays,
+											 maxDistance, &actual[0]);
+		CHECK(actual == expected);
+	}
+}